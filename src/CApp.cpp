@@ -1,5 +1,10 @@
 #include "CApp.h"
 #include "./LinAlg/Vector.h"
+#include "./RayTrace/compiledscene.hpp"
+#include "./RayTrace/sceneloader.hpp"
+#include "./RayTrace/tracer.hpp"
+#include <chrono>
+#include <cstdio>
 
 // The constructor (default)
 CApp::CApp()
@@ -7,6 +12,46 @@ CApp::CApp()
     isRunning = true;
     pWindow = NULL;
     pRenderer = NULL;
+    m_printStats = false;
+    m_displayMs = 0.0;
+    m_statsPrinted = false;
+}
+
+void CApp::SetPrintStats(bool printStats)
+{
+    m_printStats = printStats;
+    m_scene.SetStatsEnabled(printStats);
+}
+
+void CApp::SetTraceFile(const std::string &fileName)
+{
+    m_traceFile = fileName;
+    RT::Tracer::SetThreadName("main");
+    RT::Tracer::SetEnabled(!fileName.empty());
+}
+
+bool CApp::LoadScene(const std::string &fileName)
+{
+    if (RT::CompiledScene::IsCompiledScene(fileName))
+    {
+        RT::CompiledScene compiled;
+        if (!compiled.Load(fileName, m_scene))
+        {
+            std::fprintf(stderr, "%s\n", compiled.GetError().c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    RT::SceneLoader loader;
+    if (!loader.LoadFile(fileName, m_scene))
+    {
+        std::fprintf(stderr, "%s\n", loader.GetError().c_str());
+        return false;
+    }
+
+    return true;
 }
 
 bool CApp::OnInit()
@@ -29,14 +74,12 @@ bool CApp::OnInit()
         SDL_SetRenderDrawColor(pRenderer, 255, 255, 255, 255);
         SDL_RenderClear(pRenderer);
 
-        // Render the scene
-        m_scene.Render(m_image);
-
-        // Display the image
-        m_image.Display();
-
-        // Show the result
+        // Show the window straight away, the scene is rendered in the background
         SDL_RenderPresent(pRenderer);
+        m_pAsyncRenderer = std::make_unique<RT::AsyncRenderer> (m_scene);
+        m_pAsyncRenderer -> StartFrame(m_image.GetXSize(), m_image.GetYSize());
+        m_displayMs = 0.0;
+        m_statsPrinted = false;
     }
     else
     {
@@ -57,9 +100,14 @@ int CApp::OnExecute()
 	
 	while (isRunning)
 	{
-		while (SDL_PollEvent(&event) != 0)
+		// Sleep until there is an event or it is time to present the next tiles
+		if (SDL_WaitEventTimeout(&event, FRAME_TIME_MS) != 0)
 		{
 			OnEvent(&event);
+			while (isRunning && (SDL_PollEvent(&event) != 0))
+			{
+				OnEvent(&event);
+			}
 		}
 		
 		OnLoop();
@@ -74,8 +122,30 @@ void CApp::OnEvent(SDL_Event *event)
 {
     if (event->type == SDL_QUIT)
     {
+        // Stop the frame in progress rather than waiting for it to finish
+        m_pAsyncRenderer -> Cancel();
         isRunning = false;
     }
+    else if (event->type == SDL_KEYDOWN)
+    {
+        // The arrow keys move the camera
+        Vector3<double> offset;
+        switch (event->key.keysym.sym)
+        {
+            case SDLK_LEFT:     offset = Vector3<double>{-0.5, 0.0, 0.0};   break;
+            case SDLK_RIGHT:    offset = Vector3<double>{ 0.5, 0.0, 0.0};   break;
+            case SDLK_UP:       offset = Vector3<double>{ 0.0, 0.5, 0.0};   break;
+            case SDLK_DOWN:     offset = Vector3<double>{ 0.0, -0.5, 0.0};  break;
+            default:            return;
+        }
+
+        // The render threads read the camera, so the frame in progress is stopped before it moves
+        m_pAsyncRenderer -> Cancel();
+        m_scene.MoveCamera(offset);
+        m_pAsyncRenderer -> StartFrame(m_image.GetXSize(), m_image.GetYSize());
+        m_displayMs = 0.0;
+        m_statsPrinted = false;
+    }
 }
 
 void CApp::OnLoop()
@@ -85,22 +155,45 @@ void CApp::OnLoop()
 
 void CApp::OnRender()
 {
-    // Set the background color to white
-    //SDL_SetRenderDrawColor(pRenderer, 255, 255, 255, 255);
-    //SDL_RenderClear(pRenderer);
+    // Copy the tiles finished since the last frame, nothing needs to be drawn if there are none
+    if (m_pAsyncRenderer -> PublishTiles(m_image) > 0)
+    {
+        // Display the image
+        auto displayStart = std::chrono::steady_clock::now();
+        SDL_RenderClear(pRenderer);
+        m_image.Display();
 
-    // Render the scene
-    //m_scene.Render(m_image);
+        // Show the result
+        SDL_RenderPresent(pRenderer);
+        m_displayMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - displayStart).count();
+    }
 
-    // Display the image
-    //m_image.Display();
+    // The render threads have stopped once the frame is complete, so the statistics can be read
+    if (m_printStats && !m_statsPrinted && m_pAsyncRenderer -> IsFrameComplete())
+    {
+        RT::RenderStats stats = m_scene.GetStats();
+        stats.m_displayMs = m_displayMs;
+        stats.Print(stdout);
+        m_statsPrinted = true;
+    }
 
-    // Show the result
-    //SDL_RenderPresent(pRenderer);
+    // Write the trace of the first frame, the render threads are idle until the camera moves
+    if (!m_traceFile.empty() && m_pAsyncRenderer -> IsFrameComplete())
+    {
+        RT::Tracer::SetEnabled(false);
+        if (RT::Tracer::WriteChromeTrace(m_traceFile))
+            std::printf("Wrote the trace of the first frame to '%s'.\n", m_traceFile.c_str());
+        else
+            std::fprintf(stderr, "Could not write the trace to '%s'.\n", m_traceFile.c_str());
+        m_traceFile.clear();
+    }
 }
 
 void CApp::OnExit()
 {
+    // Stop the render threads before the window goes away
+    m_pAsyncRenderer.reset();
+
     // Tidy up SDL2 stuff
     SDL_DestroyRenderer(pRenderer);
     SDL_DestroyWindow(pWindow);
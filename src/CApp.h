@@ -1,8 +1,11 @@
 #ifndef CAPP_H
 #define CAPP_H
 
+#include <memory>
+#include <string>
 #include <SDL2/SDL.h>
 #include "./RayTrace/Image.hpp"
+#include "./RayTrace/asyncrenderer.hpp"
 #include "./RayTrace/scene.hpp"
 #include "./RayTrace/camera.hpp"
 
@@ -11,6 +14,15 @@ class CApp
     public:
         CApp();
 
+        // Function to print the statistics of each frame once it has been displayed
+        void SetPrintStats(bool printStats);
+
+        // Function to trace the first frame, and write the trace to fileName once it is complete
+        void SetTraceFile(const std::string &fileName);
+
+        // Function to replace the default scene with one loaded from a scene file. Returns false on an error
+        bool LoadScene(const std::string &fileName);
+
         int OnExecute();
         bool OnInit();
         void OnEvent(SDL_Event *event);
@@ -28,6 +40,21 @@ class CApp
         // An instance of the scene class
         RT::Scene m_scene;
 
+        // Renders the scene on background threads
+        std::unique_ptr<RT::AsyncRenderer> m_pAsyncRenderer;
+
+        // The longest time the event loop waits before presenting newly rendered tiles
+        static constexpr int FRAME_TIME_MS = 16;
+
+        // Whether to print the statistics of each frame, the time spent displaying the
+        // current frame so far, and whether its statistics have been printed
+        bool m_printStats;
+        double m_displayMs;
+        bool m_statsPrinted;
+
+        // The file to write the trace of the first frame to, or empty if it is not traced or has been written
+        std::string m_traceFile;
+
         // SDL2 Stuff
         bool isRunning;
         SDL_Window *pWindow;
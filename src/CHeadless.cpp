@@ -0,0 +1,227 @@
+#include "CHeadless.h"
+#include "./RayTrace/compiledscene.hpp"
+#include "./RayTrace/sceneloader.hpp"
+#include "./RayTrace/tracer.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Function to parse a positive integer option value
+static bool ParsePositiveInt(const char *text, int &value)
+{
+    char *end = NULL;
+    long parsed = std::strtol(text, &end, 10);
+    if ((end == text) || (*end != '\0') || (parsed < 1) || (parsed > 65536))
+        return false;
+
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+// The constructor (default)
+CHeadless::CHeadless()
+{
+    m_xSize = 1280;
+    m_ySize = 720;
+    m_numThreads = 0;
+    m_outputFile = "render.ppm";
+    m_sceneName = "default";
+    m_wavefront = false;
+    m_statsFormat = "";
+    m_traceFile = "";
+    m_compiledFile = "";
+}
+
+bool CHeadless::IsRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0)
+            return true;
+    }
+
+    return false;
+}
+
+int CHeadless::OnExecute(int argc, char* argv[])
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    if (!ParseArguments(argc, argv))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    if (!LoadScene())
+        return 1;
+
+    // Compiling a scene replaces rendering it
+    if (!m_compiledFile.empty())
+    {
+        RT::CompiledScene compiled;
+        if (!compiled.Save(m_compiledFile, m_scene))
+        {
+            std::fprintf(stderr, "%s\n", compiled.GetError().c_str());
+            return 1;
+        }
+
+        std::printf
+        (
+            "%s: compiled in %.1f ms\n", m_compiledFile.c_str(),
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count()
+        );
+        return 0;
+    }
+
+    // Render off-screen, without a renderer the image never touches SDL
+    m_image.Initialize(m_xSize, m_ySize, NULL);
+    m_scene.SetThreadCount(m_numThreads);
+    m_scene.SetWavefront(m_wavefront);
+    m_scene.SetStatsEnabled(!m_statsFormat.empty());
+
+    if (!m_traceFile.empty())
+    {
+        RT::Tracer::SetThreadName("main");
+        RT::Tracer::SetEnabled(true);
+    }
+
+    auto renderStart = std::chrono::steady_clock::now();
+    m_scene.Render(m_image);
+    auto renderEnd = std::chrono::steady_clock::now();
+    RT::Tracer::SetEnabled(false);
+
+    if (!m_image.WritePPM(m_outputFile))
+    {
+        std::fprintf(stderr, "Could not write the image to '%s'.\n", m_outputFile.c_str());
+        return 1;
+    }
+
+    auto endTime = std::chrono::steady_clock::now();
+    std::printf
+    (
+        "%s: %d x %d, setup %.1f ms, render %.1f ms, total %.1f ms\n",
+        m_outputFile.c_str(), m_xSize, m_ySize,
+        std::chrono::duration<double, std::milli>(renderStart - startTime).count(),
+        std::chrono::duration<double, std::milli>(renderEnd - renderStart).count(),
+        std::chrono::duration<double, std::milli>(endTime - startTime).count()
+    );
+
+    if (m_statsFormat == "text")
+    {
+        m_scene.GetStats().Print(stdout);
+    }
+    else if (m_statsFormat == "json")
+    {
+        m_scene.GetStats().WriteJson(stdout);
+        std::printf("\n");
+    }
+
+    // The worker threads are idle once Render returns, so their events can be read
+    if (!m_traceFile.empty() && !RT::Tracer::WriteChromeTrace(m_traceFile))
+    {
+        std::fprintf(stderr, "Could not write the trace to '%s'.\n", m_traceFile.c_str());
+        return 1;
+    }
+
+    return 0;
+}
+
+bool CHeadless::ParseArguments(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string option = argv[i];
+        if (option == "--headless")
+            continue;
+
+        // Every other option takes a value
+        if (i + 1 >= argc)
+        {
+            std::fprintf(stderr, "Missing value for '%s'.\n", option.c_str());
+            return false;
+        }
+        const char *value = argv[++i];
+
+        bool valid = true;
+        if (option == "--width")
+            valid = ParsePositiveInt(value, m_xSize);
+        else if (option == "--height")
+            valid = ParsePositiveInt(value, m_ySize);
+        else if (option == "--threads")
+            valid = ParsePositiveInt(value, m_numThreads);
+        else if (option == "--output")
+            m_outputFile = value;
+        else if (option == "--scene")
+            m_sceneName = value;
+        else if (option == "--renderer")
+        {
+            valid = (std::strcmp(value, "recursive") == 0) || (std::strcmp(value, "wavefront") == 0);
+            m_wavefront = (std::strcmp(value, "wavefront") == 0);
+        }
+        else if (option == "--stats")
+        {
+            valid = (std::strcmp(value, "text") == 0) || (std::strcmp(value, "json") == 0);
+            m_statsFormat = value;
+        }
+        else if (option == "--trace")
+            m_traceFile = value;
+        else if (option == "--compile")
+            m_compiledFile = value;
+        else
+        {
+            std::fprintf(stderr, "Unknown option '%s'.\n", option.c_str());
+            return false;
+        }
+
+        if (!valid)
+        {
+            std::fprintf(stderr, "Invalid value '%s' for '%s'.\n", value, option.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool CHeadless::LoadScene()
+{
+    // The default scene is built in the RT::Scene constructor, any other name is a scene file
+    if (m_sceneName == "default")
+        return true;
+
+    if (RT::CompiledScene::IsCompiledScene(m_sceneName))
+    {
+        RT::CompiledScene compiled;
+        if (!compiled.Load(m_sceneName, m_scene))
+        {
+            std::fprintf(stderr, "%s\n", compiled.GetError().c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    RT::SceneLoader loader;
+    if (!loader.LoadFile(m_sceneName, m_scene))
+    {
+        std::fprintf(stderr, "%s\n", loader.GetError().c_str());
+        return false;
+    }
+
+    std::printf("%s: %d objects, %d lights\n", m_sceneName.c_str(), loader.GetNumObjects(), loader.GetNumLights());
+    return true;
+}
+
+void CHeadless::PrintUsage()
+{
+    std::fprintf
+    (
+        stderr,
+        "Usage: game --headless [--width W] [--height H] [--threads N]\n"
+        "            [--output file.ppm] [--scene default|file.scene|file.rtscene]\n"
+        "            [--renderer recursive|wavefront] [--stats text|json]\n"
+        "            [--trace trace.json] [--compile file.rtscene]\n"
+    );
+}
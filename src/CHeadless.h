@@ -0,0 +1,60 @@
+#ifndef CHEADLESS_H
+#define CHEADLESS_H
+
+#include <string>
+#include "./RayTrace/Image.hpp"
+#include "./RayTrace/scene.hpp"
+
+/*
+    Command line renderer for machines without a display. Renders a scene
+    to a file without initializing SDL, eg.
+
+        game --headless --width 1920 --height 1080 --output frame.ppm --scene scenes/default.scene
+
+    With --compile the scene is saved as a compiled scene (see RT::CompiledScene) instead
+    of being rendered, and --scene loads either kind of file, eg.
+
+        game --headless --scene big.scene --compile big.rtscene
+        game --headless --scene big.rtscene --output frame.ppm
+*/
+class CHeadless
+{
+    public:
+        CHeadless();
+
+        // Function to test whether the command line asks for headless rendering
+        static bool IsRequested(int argc, char* argv[]);
+
+        int OnExecute(int argc, char* argv[]);
+
+    private:
+        bool ParseArguments(int argc, char* argv[]);
+        bool LoadScene();
+        void PrintUsage();
+
+    private:
+        // Options from the command line
+        int m_xSize;
+        int m_ySize;
+        int m_numThreads;
+        std::string m_outputFile;
+        std::string m_sceneName;
+        bool m_wavefront;
+
+        // How to print the render statistics ("text" or "json"), or empty to not collect them
+        std::string m_statsFormat;
+
+        // The file to write a trace of the render to, or empty to not trace it
+        std::string m_traceFile;
+
+        // The file to save the compiled scene to instead of rendering, or empty to render
+        std::string m_compiledFile;
+
+        // An instance of the Image class to store the image
+        Image m_image;
+
+        // An instance of the scene class
+        RT::Scene m_scene;
+};
+
+#endif
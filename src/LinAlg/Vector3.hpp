@@ -5,7 +5,10 @@
 
 	Vector3
 	
-	Class to provide capability to handle three-dimensional vectors.					
+	Class to provide capability to handle three-dimensional vectors.
+	
+	The class is trivially copyable and holds its data inline, so it can be
+	passed around by value without touching the heap.
 
 ************************************************************************************************* */
 
@@ -29,14 +32,9 @@ class Vector3
 		Vector3(const std::vector<T> &inputData);
 		// With input data (Vector).
 		Vector3(const Vector<T> &inputData);
-		// With input data (Vector3).
-		Vector3(const Vector3<T> &inputData);
 		// With input data as three separate values.
 		Vector3(const T x, const T y, const T z);
 		
-		// And the destructor.
-		~Vector3();	
-		
 		// Keep the GetNumDims() function for backwards compatibility.
 		int GetNumDims() const;
 		T GetElement(int index) const;
@@ -44,10 +42,10 @@ class Vector3
 		
 		// Functions to perform computations on the vector.
 		// Return the length of the vector.
-		T norm();
+		T norm() const;
 		
 		// Return a normalized copy of the vector.
-		Vector3<T> Normalized();
+		Vector3<T> Normalized() const;
 		
 		// Normalize the vector in place.
 		void Normalize();
@@ -58,9 +56,8 @@ class Vector3
 		Vector3<T> operator* (const T &rhs) const;
 		
 		// Overload the assignment operator.
-		Vector3<T> operator= (const Vector<T> &rhs);
-		Vector3<T> operator= (const std::vector<T> &rhs);
-		Vector3<T> operator= (const Vector3<T> &rhs);
+		Vector3<T> &operator= (const Vector<T> &rhs);
+		Vector3<T> &operator= (const std::vector<T> &rhs);
 		
 		// Friend functions.
 		template <class U> friend Vector3<U> operator* (const U &lhs, const Vector3<U> &rhs);
@@ -110,14 +107,6 @@ Vector3<T>::Vector3(const Vector<T> &inputData)
 	m_z = inputData.GetElement(2);
 }
 
-template <class T>
-Vector3<T>::Vector3(const Vector3<T> &inputData)
-{
-	m_x = inputData.m_x;
-	m_y = inputData.m_y;
-	m_z = inputData.m_z;
-}
-
 template <class T>
 Vector3<T>::Vector3(const T x, const T y, const T z)
 {
@@ -126,35 +115,29 @@ Vector3<T>::Vector3(const T x, const T y, const T z)
 	m_z = z;
 }
 
-template <class T>
-Vector3<T>::~Vector3()
-{
-	// For now, we don't need to do anything in the destructor.
-}
-
 /* **************************************************************************************************
 FUNCTIONS TO PERFORM COMPUTATIONS ON THE VECTOR
 /* *************************************************************************************************/
 // Compute the length of the vector, known as the 'norm'.
 template <class T>
-T Vector3<T>::norm()
+T Vector3<T>::norm() const
 {		
 	return sqrt((m_x*m_x) + (m_y*m_y) + (m_z*m_z));
 }
 
 // Return a normalized copy of the vector.
 template <class T>
-Vector3<T> Vector3<T>::Normalized()
+Vector3<T> Vector3<T>::Normalized() const
 {
 	// Compute the vector norm.
 	T vecNorm = this->norm();
 	
-	// Compute the normalized version of the vector.
-	//Vector<T> result(m_vectorData);
+	// Compute the normalized version of the vector (multiply by the reciprocal, as Vector does).
+	T invNorm = static_cast<T>(1.0) / vecNorm;
 	Vector3<T> result;
-	result.m_x = m_x / vecNorm;
-	result.m_y = m_y / vecNorm;
-	result.m_z = m_z / vecNorm;
+	result.m_x = m_x * invNorm;
+	result.m_y = m_y * invNorm;
+	result.m_z = m_z * invNorm;
 
 	return result;
 }
@@ -166,9 +149,10 @@ void Vector3<T>::Normalize()
 	// Compute the vector norm.
 	T vecNorm = this->norm();
 	
-	m_x = m_x / vecNorm;
-	m_y = m_y / vecNorm;
-	m_z = m_z / vecNorm;
+	T invNorm = static_cast<T>(1.0) / vecNorm;
+	m_x = m_x * invNorm;
+	m_y = m_y * invNorm;
+	m_z = m_z * invNorm;
 }
 
 /* **************************************************************************************************
@@ -211,7 +195,7 @@ Vector3<T> Vector3<T>::operator* (const T &rhs) const
 THE ASSIGNMENT (=) OPERATOR
 /* *************************************************************************************************/
 template <class T>
-Vector3<T> Vector3<T>::operator= (const Vector<T> &rhs)
+Vector3<T> &Vector3<T>::operator= (const Vector<T> &rhs)
 {
 	if (rhs.GetNumDims() != 3)
 		throw std::invalid_argument("Cannot assign Vector to Vector3 - assignment dimension mismatch.");
@@ -224,7 +208,7 @@ Vector3<T> Vector3<T>::operator= (const Vector<T> &rhs)
 }
 
 template <class T>
-Vector3<T> Vector3<T>::operator= (const std::vector<T> &rhs)
+Vector3<T> &Vector3<T>::operator= (const std::vector<T> &rhs)
 {
 	if (rhs.size() != 3)
 		throw std::invalid_argument("Cannot assign std::vector to Vector3 - assignment dimension mismatch.");
@@ -236,16 +220,6 @@ Vector3<T> Vector3<T>::operator= (const std::vector<T> &rhs)
 	return *this;
 }
 
-template <class T>
-Vector3<T> Vector3<T>::operator= (const Vector3<T> &rhs)
-{
-	m_x = rhs.m_x;
-	m_y = rhs.m_y;
-	m_z = rhs.m_z;
-	
-	return *this;
-}
-
 /* **************************************************************************************************
 FRIEND FUNCTIONS
 /* *************************************************************************************************/
@@ -277,12 +251,9 @@ Vector3<T> Vector3<T>::cross(const Vector3<T> &a, const Vector3<T> &b)
 {
 	// Compute the cross product.
 	Vector3<T> result;
-	result.SetElement(0, ((a.GetElement(1) * b.GetElement(2)) - (a.GetElement(2) * b.GetElement(1))));
-	result.SetElement(1, (-((a.GetElement(0) * b.GetElement(2)) - (a.GetElement(2) * b.GetElement(0)))));
-	result.SetElement(2, ((a.GetElement(0) * b.GetElement(1)) - (a.GetElement(1) * b.GetElement(0))));		
-	//result.m_x = (a.m_y * b.m_z) - (a.m_z * b.m_y);
-	//result.m_y = -((a.m_x * b.m_z) - (a.m_z * b.m_x));
-	//result.m_z = (a.m_x * b.m_y) - (a.m_y * b.m_x);
+	result.m_x = (a.m_y * b.m_z) - (a.m_z * b.m_y);
+	result.m_y = -((a.m_x * b.m_z) - (a.m_z * b.m_x));
+	result.m_z = (a.m_x * b.m_y) - (a.m_y * b.m_x);
 	
 	return result;
 }
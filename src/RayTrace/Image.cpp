@@ -1,10 +1,18 @@
 #include "Image.hpp"
+#include "tracer.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
 
 // The defauld constructor
 Image::Image()
 {
     m_xSize = 0;
     m_ySize = 0;
+    m_numDisplayTilesX = 0;
+    m_numDisplayTilesY = 0;
+    m_displayedMax = -1.0;
     m_pTexture = NULL;
 }
 
@@ -18,15 +26,25 @@ Image::~Image()
 // Function to initialize
 void Image::Initialize(const int xSize, const int ySize, SDL_Renderer *pRenderer)
 {
-    // Resize the image arrays
-    m_rChannel.resize(xSize, std::vector<double>(ySize, 0.0));
-    m_gChannel.resize(xSize, std::vector<double>(ySize, 0.0));
-    m_bChannel.resize(xSize, std::vector<double>(ySize, 0.0));
+    // Allocate the pixel buffer, cleared to black
+    size_t numValues = static_cast<size_t>(xSize) * static_cast<size_t>(ySize) * NUM_CHANNELS;
+    m_pixels.reset(new (std::align_val_t(BUFFER_ALIGNMENT)) float[numValues]());
 
     // Store the dimensions
     m_xSize = xSize;
     m_ySize = ySize;
 
+    // Every display tile starts out dirty, so the first Display converts the whole image
+    m_numDisplayTilesX = (xSize + DISPLAY_TILE_SIZE - 1) / DISPLAY_TILE_SIZE;
+    m_numDisplayTilesY = (ySize + DISPLAY_TILE_SIZE - 1) / DISPLAY_TILE_SIZE;
+    int numDisplayTiles = m_numDisplayTilesX * m_numDisplayTilesY;
+    m_dirtyTiles.reset(new std::atomic<bool>[numDisplayTiles]);
+    for (int i = 0; i < numDisplayTiles; ++i)
+        m_dirtyTiles[i].store(true, std::memory_order_relaxed);
+    m_updateTiles.assign(numDisplayTiles, 0);
+    m_tileMax.assign(static_cast<size_t>(numDisplayTiles) * NUM_CHANNELS, 0.0f);
+    m_displayedMax = -1.0;
+
     // Store the pointer to the renderer
     m_pRenderer = pRenderer;
 
@@ -37,17 +55,71 @@ void Image::Initialize(const int xSize, const int ySize, SDL_Renderer *pRenderer
 // Function to set pixels
 void Image::SetPixel(const int x, const int y, const double red, const double green, const double blue)
 {
-    m_rChannel.at(x).at(y) = red;
-    m_gChannel.at(x).at(y) = green;
-    m_bChannel.at(x).at(y) = blue;
+    if ((x < 0) || (x >= m_xSize) || (y < 0) || (y >= m_ySize))
+        throw std::out_of_range("Pixel coordinates are outside of the image.");
+
+    SetPixelUnchecked(x, y, static_cast<float>(red), static_cast<float>(green), static_cast<float>(blue));
+}
+
+// Function to return the colour of a pixel
+void Image::GetPixel(const int x, const int y, double &red, double &green, double &blue) const
+{
+    if ((x < 0) || (x >= m_xSize) || (y < 0) || (y >= m_ySize))
+        throw std::out_of_range("Pixel coordinates are outside of the image.");
+
+    const float *pixel = m_pixels.get() + ((static_cast<size_t>(y) * m_xSize) + x) * NUM_CHANNELS;
+    red = pixel[0];
+    green = pixel[1];
+    blue = pixel[2];
+}
+
+// Function to copy a tile into the image, one row at a time
+void Image::WriteTile(const int x0, const int y0, const int width, const int height, const float *tileData)
+{
+    size_t rowValues = static_cast<size_t>(width) * NUM_CHANNELS;
+    for (int row = 0; row < height; ++row)
+    {
+        float *dest = m_pixels.get() + ((static_cast<size_t>(y0 + row) * m_xSize) + x0) * NUM_CHANNELS;
+        std::memcpy(dest, tileData + (row * rowValues), rowValues * sizeof(float));
+    }
+
+    MarkDirty(x0, y0, width, height);
+}
+
+// Function to copy a rectangle out of the image
+void Image::ReadTile(const int x0, const int y0, const int width, const int height, float *tileData) const
+{
+    size_t rowValues = static_cast<size_t>(width) * NUM_CHANNELS;
+    for (int row = 0; row < height; ++row)
+    {
+        const float *src = m_pixels.get() + ((static_cast<size_t>(y0 + row) * m_xSize) + x0) * NUM_CHANNELS;
+        std::memcpy(tileData + (row * rowValues), src, rowValues * sizeof(float));
+    }
+}
+
+// Function to flag the display tiles that overlap a rectangle as changed
+void Image::MarkDirty(const int x0, const int y0, const int width, const int height)
+{
+    if ((width <= 0) || (height <= 0))
+        return;
+
+    for (int tileY = y0 / DISPLAY_TILE_SIZE; tileY <= (y0 + height - 1) / DISPLAY_TILE_SIZE; ++tileY)
+        for (int tileX = x0 / DISPLAY_TILE_SIZE; tileX <= (x0 + width - 1) / DISPLAY_TILE_SIZE; ++tileX)
+            m_dirtyTiles[(tileY * m_numDisplayTilesX) + tileX].store(true, std::memory_order_relaxed);
+}
+
+// Function to return the pixel data
+const float *Image::GetPixelData() const
+{
+    return m_pixels.get();
 }
 
 // Functions to return the dimensions of the image
-int Image::GetXSize()
+int Image::GetXSize() const
 {
     return m_xSize;
 }
-int Image::GetYSize()
+int Image::GetYSize() const
 {
     return m_ySize;
 }
@@ -55,28 +127,38 @@ int Image::GetYSize()
 // Function to generate the display
 void Image::Display()
 {
-    // Compute maximum values
-    ComputeMaxValues();
+    if (m_pTexture == NULL)
+        return;
+
+    RT::TraceScope displayScope("Image::Display");
 
-    // Allocate memory for a pixel buffer
-    Uint32 *tempPixels = new Uint32[m_xSize * m_ySize];
+    // Compute maximum values. This also takes the set of dirty tiles for this update
+    ComputeMaxValues();
 
-    // Clear the pixel buffer
-    memset(tempPixels, 0, m_xSize * m_ySize * sizeof(Uint32));
+    // The conversion scales by the maximum, so if that changed every tile has to be redone
+    bool fullUpdate = (m_overallMax != m_displayedMax);
+    m_displayedMax = m_overallMax;
 
-    for (int x = 0; x < m_xSize; ++x)
+    /*
+        Upload each row of tiles as one locked rectangle spanning its first to last changed
+        tile. The locked pixels are write-only, so every pixel in the rectangle is converted
+    */
+    for (int tileY = 0; tileY < m_numDisplayTilesY; ++tileY)
     {
-        for (int y = 0; y < m_ySize; ++y)
+        int firstTileX = m_numDisplayTilesX;
+        int lastTileX = -1;
+        for (int tileX = 0; tileX < m_numDisplayTilesX; ++tileX)
         {
-            tempPixels[(y * m_xSize) + x] = ConvertColor(m_rChannel.at(x).at(y), m_gChannel.at(x).at(y), m_bChannel.at(x).at(y));
+            if (fullUpdate || m_updateTiles[(tileY * m_numDisplayTilesX) + tileX])
+            {
+                firstTileX = std::min(firstTileX, tileX);
+                lastTileX = tileX;
+            }
         }
-    }
-
-    // Update the texture with the pixel buffer
-    SDL_UpdateTexture(m_pTexture, NULL, tempPixels, m_xSize * sizeof(Uint32));
 
-    // Delete the pixel buffer
-    delete[] tempPixels;
+        if (lastTileX >= firstTileX)
+            ConvertTiles(tileY, firstTileX, lastTileX);
+    }
 
     // Copy the texture to the renderer
     SDL_Rect srcRect, bounds;
@@ -88,40 +170,120 @@ void Image::Display()
     SDL_RenderCopy(m_pRenderer, m_pTexture, &srcRect, &bounds);
 }
 
+// Function to convert a run of tiles in one row of tiles straight into the texture
+void Image::ConvertTiles(const int tileY, const int firstTileX, const int lastTileX)
+{
+    RT::TraceScope uploadScope("texture upload", "tile row", tileY);
+
+    SDL_Rect lockRect;
+    lockRect.x = firstTileX * DISPLAY_TILE_SIZE;
+    lockRect.y = tileY * DISPLAY_TILE_SIZE;
+    lockRect.w = std::min((lastTileX + 1) * DISPLAY_TILE_SIZE, m_xSize) - lockRect.x;
+    lockRect.h = std::min((tileY + 1) * DISPLAY_TILE_SIZE, m_ySize) - lockRect.y;
+
+    void *texturePixels;
+    int pitch;
+    if (SDL_LockTexture(m_pTexture, &lockRect, &texturePixels, &pitch) != 0)
+        return;
+
+    for (int row = 0; row < lockRect.h; ++row)
+    {
+        Uint32 *dest = reinterpret_cast<Uint32*>(static_cast<unsigned char*>(texturePixels) + (static_cast<size_t>(row) * pitch));
+        const float *pixel = m_pixels.get() + ((static_cast<size_t>(lockRect.y + row) * m_xSize) + lockRect.x) * NUM_CHANNELS;
+        for (int x = 0; x < lockRect.w; ++x, pixel += NUM_CHANNELS)
+        {
+            dest[x] = ConvertColor(pixel[0], pixel[1], pixel[2]);
+        }
+    }
+
+    SDL_UnlockTexture(m_pTexture);
+}
+
 // Function to initialize the texture
 void Image::InitTexture()
 {
-    Uint32 rmask, gmask, bmask, amask;
-
+    // The pixel format that matches ConvertColor
     #if SDL_BYTEORDER == SDL_BIG_ENDIAN
-        rmask = 0xff000000;
-        gmask = 0x00ff0000;
-        bmask = 0x0000ff00;
-        amask = 0x000000ff;
+        Uint32 pixelFormat = SDL_PIXELFORMAT_BGRA8888;
     #else
-        rmask = 0x000000ff;
-        gmask = 0x0000ff00;
-        bmask = 0x00ff0000;
-        amask = 0xff000000;
+        Uint32 pixelFormat = SDL_PIXELFORMAT_ARGB8888;
     #endif
 
     // Delete any previously created textures
     if (m_pTexture != NULL)
+    {
         SDL_DestroyTexture(m_pTexture);
+        m_pTexture = NULL;
+    }
+
+    // Without a renderer the image is only used off-screen and there is nothing to display
+    if (m_pRenderer == NULL)
+        return;
+
+    // Create a streaming texture, so that Display can write into it directly
+    m_pTexture = SDL_CreateTexture(m_pRenderer, pixelFormat, SDL_TEXTUREACCESS_STREAMING, m_xSize, m_ySize);
+}
+
+// Function to write the image to a PPM file
+bool Image::WritePPM(const std::string &fileName) const
+{
+    FILE *pFile = std::fopen(fileName.c_str(), "wb");
+    if (pFile == NULL)
+        return false;
+
+    std::fprintf(pFile, "P6\n%d %d\n255\n", m_xSize, m_ySize);
+
+    // Scale by the brightest value, as Display does. An image with no light in it has nothing to
+    // scale by, so the row buffer is left as zeros and the image is written as black
+    double overallMax = ComputeOverallMax();
+    bool hasLight = (overallMax > 0.0);
+    std::vector<unsigned char> rowBuffer(static_cast<size_t>(m_xSize) * 3, 0);
+    bool success = true;
+    for (int y = 0; (y < m_ySize) && success; ++y)
+    {
+        const float *pixel = m_pixels.get() + (static_cast<size_t>(y) * m_xSize) * NUM_CHANNELS;
+        for (int x = 0; hasLight && (x < m_xSize); ++x, pixel += NUM_CHANNELS)
+        {
+            rowBuffer[(x * 3) + 0] = static_cast<unsigned char>((pixel[0] / overallMax) * 255.0);
+            rowBuffer[(x * 3) + 1] = static_cast<unsigned char>((pixel[1] / overallMax) * 255.0);
+            rowBuffer[(x * 3) + 2] = static_cast<unsigned char>((pixel[2] / overallMax) * 255.0);
+        }
+
+        success = (std::fwrite(rowBuffer.data(), 1, rowBuffer.size(), pFile) == rowBuffer.size());
+    }
+
+    if (std::fclose(pFile) != 0)
+        success = false;
 
-    // Create the texture that will store the image
-    SDL_Surface *tempSurface = SDL_CreateRGBSurface(0, m_xSize, m_ySize, 32, rmask, gmask, bmask, amask);
-    m_pTexture = SDL_CreateTextureFromSurface(m_pRenderer, tempSurface);
-    SDL_FreeSurface(tempSurface);
+    return success;
+}
+
+// Function to compute the maximum over every pixel, without touching the display state
+double Image::ComputeOverallMax() const
+{
+    float overallMax = 0.0f;
+    const float *pixel = m_pixels.get();
+    size_t numValues = static_cast<size_t>(m_xSize) * static_cast<size_t>(m_ySize) * NUM_CHANNELS;
+    for (size_t i = 0; i < numValues; ++i)
+        overallMax = std::max(overallMax, pixel[i]);
+
+    return overallMax;
 }
 
 // Function to convert colours to Uint32
 Uint32 Image::ConvertColor(const double red, const double green, const double blue)
 {
-    // Convert the colours to unsigned integers
-    unsigned char r = static_cast<unsigned char>((red / m_overallMax) * 255.0);
-    unsigned char g = static_cast<unsigned char>((green / m_overallMax) * 255.0);
-    unsigned char b = static_cast<unsigned char>((blue / m_overallMax) * 255.0);
+    // Convert the colours to unsigned integers. Until something lit has been rendered (eg. in a
+    // partial frame whose tiles are all still black) there is nothing to scale by, so use black
+    unsigned char r = 0;
+    unsigned char g = 0;
+    unsigned char b = 0;
+    if (m_overallMax > 0.0)
+    {
+        r = static_cast<unsigned char>((red / m_overallMax) * 255.0);
+        g = static_cast<unsigned char>((green / m_overallMax) * 255.0);
+        b = static_cast<unsigned char>((blue / m_overallMax) * 255.0);
+    }
 
     #if SDL_BYTEORDER == SDL_BIG_ENDIAN
         Uint32 pixelColor = (b << 24) + (g << 16) + (r << 8) + 255;
@@ -135,35 +297,59 @@ Uint32 Image::ConvertColor(const double red, const double green, const double bl
 // Function to compute maximum values
 void Image::ComputeMaxValues()
 {
-    m_maxRed = 0.0;
-    m_maxGreen = 0.0;
-    m_maxBlue = 0.0;
-    m_overallMax = 0.0;
-    for (int x = 0; x < m_xSize; ++x)
-	{
-		for (int y = 0; y < m_ySize; ++y)
-		{
-			double redValue		= m_rChannel.at(x).at(y);
-			double greenValue	= m_gChannel.at(x).at(y);
-			double blueValue	= m_bChannel.at(x).at(y);
-			
-			if (redValue > m_maxRed)
-				m_maxRed = redValue;
-				
-			if (greenValue > m_maxGreen)
-				m_maxGreen = greenValue;
-				
-			if (blueValue > m_maxBlue)
-				m_maxBlue = blueValue;
-				
-			if (m_maxRed > m_overallMax)
-				m_overallMax = m_maxRed;
-			
-			if (m_maxGreen > m_overallMax)
-				m_overallMax = m_maxGreen;
-				
-			if (m_maxBlue > m_overallMax)
-				m_overallMax = m_maxBlue;
-		}
-	}
-}
\ No newline at end of file
+    // Take the dirty flags, clearing them first so that writes made from now on are seen next time
+    int numDisplayTiles = m_numDisplayTilesX * m_numDisplayTilesY;
+    for (int i = 0; i < numDisplayTiles; ++i)
+        m_updateTiles[i] = m_dirtyTiles[i].exchange(false, std::memory_order_acquire) ? 1 : 0;
+
+    // Update the maxima of the tiles that have changed
+    for (int tileY = 0; tileY < m_numDisplayTilesY; ++tileY)
+    {
+        for (int tileX = 0; tileX < m_numDisplayTilesX; ++tileX)
+        {
+            int tileIndex = (tileY * m_numDisplayTilesX) + tileX;
+            if (!m_updateTiles[tileIndex])
+                continue;
+
+            int x0 = tileX * DISPLAY_TILE_SIZE;
+            int y0 = tileY * DISPLAY_TILE_SIZE;
+            int x1 = std::min(x0 + DISPLAY_TILE_SIZE, m_xSize);
+            int y1 = std::min(y0 + DISPLAY_TILE_SIZE, m_ySize);
+
+            float maxRed = 0.0f;
+            float maxGreen = 0.0f;
+            float maxBlue = 0.0f;
+            for (int y = y0; y < y1; ++y)
+            {
+                const float *pixel = m_pixels.get() + ((static_cast<size_t>(y) * m_xSize) + x0) * NUM_CHANNELS;
+                for (int x = x0; x < x1; ++x, pixel += NUM_CHANNELS)
+                {
+                    maxRed = std::max(maxRed, pixel[0]);
+                    maxGreen = std::max(maxGreen, pixel[1]);
+                    maxBlue = std::max(maxBlue, pixel[2]);
+                }
+            }
+
+            float *tileMax = &m_tileMax[static_cast<size_t>(tileIndex) * NUM_CHANNELS];
+            tileMax[0] = maxRed;
+            tileMax[1] = maxGreen;
+            tileMax[2] = maxBlue;
+        }
+    }
+
+    // The image maxima are the maxima over all of the tiles
+    float maxRed = 0.0f;
+    float maxGreen = 0.0f;
+    float maxBlue = 0.0f;
+    for (int i = 0; i < numDisplayTiles; ++i)
+    {
+        maxRed = std::max(maxRed, m_tileMax[(i * NUM_CHANNELS) + 0]);
+        maxGreen = std::max(maxGreen, m_tileMax[(i * NUM_CHANNELS) + 1]);
+        maxBlue = std::max(maxBlue, m_tileMax[(i * NUM_CHANNELS) + 2]);
+    }
+
+    m_maxRed = maxRed;
+    m_maxGreen = maxGreen;
+    m_maxBlue = maxBlue;
+    m_overallMax = std::max(m_maxRed, std::max(m_maxGreen, m_maxBlue));
+}
@@ -1,6 +1,10 @@
 #ifndef IMAGE_H
 #define IMAGE_H
 
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
 #include <string>
 #include <vector>
 #include <SDL2/SDL.h>
@@ -17,26 +21,92 @@ class Image
         // Function to initialize
         void Initialize(const int xSize, const int ySize, SDL_Renderer *pRenderer);
 
-        // Function to set the colour of a pixel
+        // Function to set the colour of a pixel. Throws std::out_of_range if (x, y) is outside the image
         void SetPixel(const int x, const int y, const double red, const double green, const double blue);
 
-        // Function to return the image for display
+        // Function to return the colour of a pixel. Throws std::out_of_range if (x, y) is outside the image
+        void GetPixel(const int x, const int y, double &red, double &green, double &blue) const;
+
+        // Function to set the colour of a pixel without any bounds checking
+        void SetPixelUnchecked(const int x, const int y, const float red, const float green, const float blue)
+        {
+            float *pixel = m_pixels.get() + ((static_cast<size_t>(y) * m_xSize) + x) * NUM_CHANNELS;
+            pixel[0] = red;
+            pixel[1] = green;
+            pixel[2] = blue;
+            m_dirtyTiles[((y / DISPLAY_TILE_SIZE) * m_numDisplayTilesX) + (x / DISPLAY_TILE_SIZE)].store(true, std::memory_order_relaxed);
+        }
+
+        // Function to return the colour of a pixel without any bounds checking
+        void GetPixelUnchecked(const int x, const int y, float &red, float &green, float &blue) const
+        {
+            const float *pixel = m_pixels.get() + ((static_cast<size_t>(y) * m_xSize) + x) * NUM_CHANNELS;
+            red = pixel[0];
+            green = pixel[1];
+            blue = pixel[2];
+        }
+
+        /*
+            Function to copy a rendered tile into the image without any bounds checking.
+            tileData holds width * height pixels, row-major, NUM_CHANNELS floats per pixel,
+            and the tile must lie entirely inside the image. Render workers own disjoint
+            tiles, so they can call this concurrently
+        */
+        void WriteTile(const int x0, const int y0, const int width, const int height, const float *tileData);
+
+        // Function to copy a rectangle of the image out into a tile laid out as for WriteTile, without any bounds checking
+        void ReadTile(const int x0, const int y0, const int width, const int height, float *tileData) const;
+
+        // Function to return the pixel data, row-major with NUM_CHANNELS floats per pixel
+        const float *GetPixelData() const;
+
+        /*
+            Function to write the image to a binary PPM file, scaled the same way as for display.
+            Does not need SDL, so it can be used for headless rendering. Returns false on failure
+        */
+        bool WritePPM(const std::string &fileName) const;
+
+        /*
+            Function to return the image for display. Only the display tiles written since
+            the last call are converted and uploaded, unless the brightest value in the image
+            has changed, in which case every pixel has to be rescaled
+        */
         void Display();
 
         // Functions to return the dimensions of the image
-        int GetXSize();
-        int GetYSize();
+        int GetXSize() const;
+        int GetYSize() const;
+
+    public:
+        // The number of floats stored per pixel (red, green, blue)
+        static constexpr int NUM_CHANNELS = 3;
+
+        // The alignment of the pixel buffer in bytes
+        static constexpr size_t BUFFER_ALIGNMENT = 64;
+
+        // The size of the square tiles in which changes are tracked for display
+        static constexpr int DISPLAY_TILE_SIZE = 32;
     
     private:
         Uint32 ConvertColor(const double red, const double green, const double blue);
+        double ComputeOverallMax() const;
         void InitTexture();
         void ComputeMaxValues();
+        void MarkDirty(const int x0, const int y0, const int width, const int height);
+        void ConvertTiles(const int tileY, const int firstTileX, const int lastTileX);
+
+        // Deleter for the aligned pixel buffer
+        struct AlignedDelete
+        {
+            void operator()(float *ptr) const
+            {
+                ::operator delete[](ptr, std::align_val_t(BUFFER_ALIGNMENT));
+            }
+        };
 
     private:
-        // Arrays to store image data
-        std::vector<std::vector<double>> m_rChannel;
-        std::vector<std::vector<double>> m_gChannel;
-        std::vector<std::vector<double>> m_bChannel;
+        // The image data, one contiguous row-major buffer of NUM_CHANNELS floats per pixel
+        std::unique_ptr<float[], AlignedDelete> m_pixels;
 
         // Store the dimensions of the image
         int m_xSize, m_ySize;
@@ -44,6 +114,17 @@ class Image
         // Store the maximum values
         double m_maxRed, m_maxGreen, m_maxBlue, m_overallMax;
 
+        // The maximum value that the texture was last converted with
+        double m_displayedMax;
+
+        // Display tiles written since the last Display, set by any thread that writes pixels
+        int m_numDisplayTilesX, m_numDisplayTilesY;
+        std::unique_ptr<std::atomic<bool>[]> m_dirtyTiles;
+
+        // Display tiles to convert in the current Display, and the per-channel maximum of each tile
+        std::vector<unsigned char> m_updateTiles;
+        std::vector<float> m_tileMax;
+
         // SDL2 stuff
         SDL_Renderer *m_pRenderer;
         SDL_Texture *m_pTexture;
@@ -12,13 +12,32 @@ RT::LightBase::~LightBase()
 
 }
 
+// Function to compute the light sample. The base light casts no light
+void RT::LightBase::ComputeSample
+(
+    const Vector3<double> &intPoint, const RT::BVH &sceneBVH,
+    RT::LightSample &sample
+) {
+    sample.m_direction = (m_location - intPoint).Normalized();
+    sample.m_distance = (m_location - intPoint).norm();
+    sample.m_visible = false;
+}
+
+// Function to compute the samples for several points
+void RT::LightBase::ComputeSamples
+(
+    const Vector3<double> *intPoints, int numPoints, const RT::BVH &sceneBVH,
+    RT::LightSample *samples, int sampleStride
+) {
+    for (int i = 0; i < numPoints; ++i)
+        ComputeSample(intPoints[i], sceneBVH, samples[i * sampleStride]);
+}
+
 // Function to compute illumination contribution
 bool RT::LightBase::ComputeIllumination
 (
-    const Vector<double> &intPoint, const Vector<double> &localNormal,
-    const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
-    const std::shared_ptr<RT::ObjectBase> &currentObject,
-    Vector<double> &color, double &intensity
+    const Vector3<double> &localNormal, const RT::LightSample &sample,
+    Vector3<double> &color, double &intensity
 ) {
     return false;   
 }
\ No newline at end of file
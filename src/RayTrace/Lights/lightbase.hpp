@@ -2,9 +2,11 @@
 #define LIGHTBASE_H
 
 #include <memory>
-#include "../../LinAlg/Vector.h"
+#include "../../LinAlg/Vector3.hpp"
 #include "../ray.hpp"
 #include "../Primatives/objectbase.hpp"
+#include "../bvh.hpp"
+#include "lightsample.hpp"
 
 namespace RT
 {
@@ -15,18 +17,34 @@ namespace RT
             LightBase();
             virtual ~LightBase();
 
-            // Function to compute illumination contribution
+            // Function to compute the direction, distance and visibility of the light from a point
+            virtual void ComputeSample
+            (
+                const Vector3<double> &intPoint, const RT::BVH &sceneBVH,
+                RT::LightSample &sample
+            );
+
+            /*
+                Function to compute the samples for several points at once, writing the sample for
+                intPoints[i] to samples[i * sampleStride]. The base class computes them one at a
+                time, lights can override it to trace the shadow rays as packets
+            */
+            virtual void ComputeSamples
+            (
+                const Vector3<double> *intPoints, int numPoints, const RT::BVH &sceneBVH,
+                RT::LightSample *samples, int sampleStride
+            );
+
+            // Function to compute illumination contribution, given the sample for this light
             virtual bool ComputeIllumination
             (
-                const Vector<double> &intPoint, const Vector<double> &localNormal,
-                const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
-                const std::shared_ptr<RT::ObjectBase> &currentObject,
-                Vector<double> &color, double &intensity
+                const Vector3<double> &localNormal, const RT::LightSample &sample,
+                Vector3<double> &color, double &intensity
             );
         
         public:
-            Vector<double>  m_color     {3};
-            Vector<double>  m_location  {3};
+            Vector3<double>  m_color;
+            Vector3<double>  m_location;
             double          m_intensity;
     };
 }
@@ -0,0 +1,100 @@
+#include "lightsample.hpp"
+#include "lightbase.hpp"
+#include <deque>
+
+namespace
+{
+    /*
+        Scratch storage for the samples of lights beyond LightSampleCache::INLINE_LIGHTS. Caches
+        are nested (a reflection creates a new one while the first is still in use), so each
+        takes the next free range and hands it back when it is destroyed. A deque is used so
+        that growing the storage does not move samples an enclosing cache has returned
+    */
+    struct SampleScratch
+    {
+        std::deque<RT::LightSample> m_samples;
+        std::deque<bool> m_computed;
+        size_t m_used = 0;
+    };
+
+    thread_local SampleScratch t_sampleScratch;
+}
+
+// The constructor
+RT::LightSampleCache::LightSampleCache
+(
+    const RT::BVH &sceneBVH,
+    const std::vector<std::shared_ptr<RT::LightBase>> &lightList,
+    const Vector3<double> &intPoint,
+    const RT::LightSample *pPrecomputed
+) : m_sceneBVH(sceneBVH), m_lightList(lightList), m_intPoint(intPoint), m_pPrecomputed(pPrecomputed)
+{
+    // Take scratch storage for the lights that do not fit in the cache itself
+    int numLights = static_cast<int>(m_lightList.size());
+    if ((m_pPrecomputed == nullptr) && (numLights > INLINE_LIGHTS))
+    {
+        SampleScratch &scratch = t_sampleScratch;
+        m_scratchFirst = scratch.m_used;
+        m_scratchCount = static_cast<size_t>(numLights - INLINE_LIGHTS);
+        scratch.m_used += m_scratchCount;
+        if (scratch.m_samples.size() < scratch.m_used)
+        {
+            scratch.m_samples.resize(scratch.m_used);
+            scratch.m_computed.resize(scratch.m_used);
+        }
+
+        for (size_t i = 0; i < m_scratchCount; ++i)
+            scratch.m_computed[m_scratchFirst + i] = false;
+    }
+}
+
+// The destructor
+RT::LightSampleCache::~LightSampleCache()
+{
+    if (m_scratchCount > 0)
+        t_sampleScratch.m_used = m_scratchFirst;
+}
+
+// Function to return the sample for a light, computing it on first use
+const RT::LightSample &RT::LightSampleCache::GetSample(int lightIndex)
+{
+    if (m_pPrecomputed != nullptr)
+        return m_pPrecomputed[lightIndex];
+
+    if (lightIndex < INLINE_LIGHTS)
+    {
+        if (!m_computed[lightIndex])
+        {
+            m_lightList[lightIndex] -> ComputeSample(m_intPoint, m_sceneBVH, m_samples[lightIndex]);
+            m_computed[lightIndex] = true;
+        }
+
+        return m_samples[lightIndex];
+    }
+
+    SampleScratch &scratch = t_sampleScratch;
+    size_t slot = m_scratchFirst + static_cast<size_t>(lightIndex - INLINE_LIGHTS);
+    if (!scratch.m_computed[slot])
+    {
+        m_lightList[lightIndex] -> ComputeSample(m_intPoint, m_sceneBVH, scratch.m_samples[slot]);
+        scratch.m_computed[slot] = true;
+    }
+
+    return scratch.m_samples[slot];
+}
+
+// Functions to return the scene data
+const std::vector<std::shared_ptr<RT::LightBase>> &RT::LightSampleCache::GetLightList() const
+{
+    return m_lightList;
+}
+
+const Vector3<double> &RT::LightSampleCache::GetIntPoint() const
+{
+    return m_intPoint;
+}
+
+int RT::LightSampleCache::GetNumLights() const
+{
+    return static_cast<int>(m_lightList.size());
+}
@@ -0,0 +1,81 @@
+#ifndef LIGHTSAMPLE_H
+#define LIGHTSAMPLE_H
+
+#include <memory>
+#include <vector>
+#include "../../LinAlg/Vector3.hpp"
+#include "../bvh.hpp"
+
+namespace RT
+{
+    class LightBase;
+
+    // What a single light looks like from a point on a surface
+    struct LightSample
+    {
+        // Unit vector pointing from the point towards the light
+        Vector3<double> m_direction;
+
+        // The distance from the point to the light
+        double m_distance = 0.0;
+
+        // Whether the light can be seen from the point (ie. it is not in shadow)
+        bool m_visible = false;
+    };
+
+    /*
+        The light samples for one point of intersection. Each sample is computed, including
+        its shadow ray, the first time it is requested and then reused, so the diffuse and
+        specular parts of a material share a single shadow ray per light.
+        A cache lives on the stack for the duration of one hit. The samples of the first
+        INLINE_LIGHTS lights are kept in the cache itself, and those of any further lights
+        in scratch storage belonging to the thread, which is reused from hit to hit.
+        Samples that were computed in advance (eg. by tracing the shadow rays of several
+        camera rays as a packet) can be passed in, one per light in the light list.
+    */
+    class LightSampleCache
+    {
+        public:
+            // The number of lights whose samples are kept in the cache itself
+            static constexpr int INLINE_LIGHTS = 16;
+
+        public:
+            LightSampleCache
+            (
+                const RT::BVH &sceneBVH,
+                const std::vector<std::shared_ptr<RT::LightBase>> &lightList,
+                const Vector3<double> &intPoint,
+                const RT::LightSample *pPrecomputed = nullptr
+            );
+
+            // The destructor returns any scratch storage to the thread
+            ~LightSampleCache();
+
+            // Caches refer to storage owned by the thread, so they are not copied
+            LightSampleCache(const LightSampleCache&) = delete;
+            LightSampleCache &operator=(const LightSampleCache&) = delete;
+
+            // Function to return the sample for the light at lightIndex in the light list
+            const RT::LightSample &GetSample(int lightIndex);
+
+            // Functions to return the scene data the samples are computed for
+            const std::vector<std::shared_ptr<RT::LightBase>> &GetLightList() const;
+            const Vector3<double> &GetIntPoint() const;
+            int GetNumLights() const;
+
+        private:
+            const RT::BVH &m_sceneBVH;
+            const std::vector<std::shared_ptr<RT::LightBase>> &m_lightList;
+            Vector3<double> m_intPoint;
+            const RT::LightSample *m_pPrecomputed;
+
+            RT::LightSample m_samples[INLINE_LIGHTS];
+            bool m_computed[INLINE_LIGHTS] = {};
+
+            // Where the samples of lights beyond INLINE_LIGHTS start in the thread's scratch storage
+            size_t m_scratchFirst = 0;
+            size_t m_scratchCount = 0;
+    };
+}
+
+#endif
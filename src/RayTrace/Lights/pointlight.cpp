@@ -1,9 +1,10 @@
 #include "pointlight.hpp"
+#include <algorithm>
 
 // The default constructor
 RT::PointLight::PointLight()
 {
-    m_color = Vector<double> {std::vector<double> {1.0, 1.0, 1.0}};
+    m_color = Vector3<double>{1.0, 1.0, 1.0};
     m_intensity = 1.0;
 }
 
@@ -13,57 +14,81 @@ RT::PointLight::~PointLight()
     
 }
 
-// Function to compute illumination contribution
-bool RT::PointLight::ComputeIllumination
-(
-    const Vector<double> &intPoint, const Vector<double> &localNormal,
-    const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
-    const std::shared_ptr<RT::ObjectBase> &currentObject,
-    Vector<double> &color, double &intensity
-) {
+// Function to compute the direction and distance of the light and return the shadow ray
+RT::Ray RT::PointLight::PrepareSample(const Vector3<double> &intPoint, RT::LightSample &sample) const
+{
 	// Construct a vector pointing from the intersection point to the light
-	Vector<double> lightDir = (m_location - intPoint).Normalized();
+	sample.m_direction = (m_location - intPoint).Normalized();
 	
-	// Compute a starting point
-	Vector<double> startPoint = intPoint;
+	sample.m_distance = (m_location - intPoint).norm();
+	
+	// Compute a starting point, just off the surface so that it does not hit itself
+	Vector3<double> startPoint = intPoint + (sample.m_direction * 0.001);
 	
 	// Construct a ray from the point of intersection to the light.
-	RT::Ray lightRay (startPoint, startPoint + lightDir);
+	return RT::Ray(startPoint, startPoint + sample.m_direction);
+}
+
+// Function to compute the direction, distance and visibility of the light
+void RT::PointLight::ComputeSample
+(
+    const Vector3<double> &intPoint, const RT::BVH &sceneBVH,
+    RT::LightSample &sample
+) {
+	RT::Ray lightRay = PrepareSample(intPoint, sample);
 	
 	/*
         Check for intersections with all of the objects
-	    in the scene, except for the current one
+	    in the scene up to the light. Objects beyond the light cannot
+		cast a shadow from it. Any intersection means that an object
+		is blocking light from this light source
     */
-	Vector<double> poi			{3};
-	Vector<double> poiNormal	{3};
-	Vector<double> poiColor		{3};
-	bool validInt = false;
-	for (auto sceneObject : objectList)
+	sample.m_visible = !sceneBVH.Occluded(lightRay, RT::BVH::NO_OBJECT, sample.m_distance - 0.001);
+}
+
+// Function to compute the samples for several points
+void RT::PointLight::ComputeSamples
+(
+    const Vector3<double> *intPoints, int numPoints, const RT::BVH &sceneBVH,
+    RT::LightSample *samples, int sampleStride
+) {
+	// The shadow rays from nearby points to the light are coherent, so trace them as packets
+	for (int first = 0; first < numPoints; first += RT::RayPacket::MAX_SIZE)
 	{
-		if (sceneObject != currentObject)
+		RT::RayPacket shadowPacket;
+		double tMax[RT::RayPacket::MAX_SIZE];
+		shadowPacket.m_size = std::min(numPoints - first, RT::RayPacket::MAX_SIZE);
+		for (int lane = 0; lane < shadowPacket.m_size; ++lane)
 		{
-			validInt = sceneObject -> TestIntersection(lightRay, poi, poiNormal, poiColor);
+			RT::LightSample &sample = samples[(first + lane) * sampleStride];
+			shadowPacket.SetRay(lane, PrepareSample(intPoints[first + lane], sample));
+			tMax[lane] = sample.m_distance - 0.001;
 		}
+		shadowPacket.Finalize();
 		
-		/*
-            If we have an intersection, then there is no point checking further
-			so we can break out of the loop. In other words, this object is
-			blocking light from this light source
-        */
-		if (validInt)
-			break;
+		bool occluded[RT::RayPacket::MAX_SIZE];
+		sceneBVH.OccludedPacket(shadowPacket, tMax, occluded);
+		for (int lane = 0; lane < shadowPacket.m_size; ++lane)
+			samples[(first + lane) * sampleStride].m_visible = !occluded[lane];
 	}
+}
 
+// Function to compute illumination contribution
+bool RT::PointLight::ComputeIllumination
+(
+    const Vector3<double> &localNormal, const RT::LightSample &sample,
+    Vector3<double> &color, double &intensity
+) {
 	/*
         Only continue to compute illumination if the light ray didn't
 	    intersect with any objects in the scene. Ie. no objects are
 		casting a shadow from this light source
     */
-	if (!validInt)
+	if (sample.m_visible)
 	{
 		// Compute the angle between the local normal and the light ray
 		// Note that we assume that localNormal is a unit vector
-		double angle = acos(Vector<double>::dot(localNormal, lightDir));
+		double angle = acos(Vector3<double>::dot(localNormal, sample.m_direction));
 		
 		// If the normal is pointing away from the light, then we have no illumination
 		if (angle > 1.5708)
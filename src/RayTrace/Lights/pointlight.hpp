@@ -14,14 +14,30 @@ namespace RT
             // Override the default destructor
             virtual ~PointLight() override;
 
+            // Function to compute the direction, distance and visibility of the light from a point
+            virtual void ComputeSample
+            (
+                const Vector3<double> &intPoint, const RT::BVH &sceneBVH,
+                RT::LightSample &sample
+            ) override;
+
+            // Function to compute the samples for several points, tracing the shadow rays as packets
+            virtual void ComputeSamples
+            (
+                const Vector3<double> *intPoints, int numPoints, const RT::BVH &sceneBVH,
+                RT::LightSample *samples, int sampleStride
+            ) override;
+
             // Function to compute illumination contribution
             virtual bool ComputeIllumination
             (
-                const Vector<double> &intPoint, const Vector<double> &localNormal,
-                const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
-                const std::shared_ptr<RT::ObjectBase> &currentObject,
-                Vector<double> &color, double &intensity
+                const Vector3<double> &localNormal, const RT::LightSample &sample,
+                Vector3<double> &color, double &intensity
             ) override;
+
+        private:
+            // Function to compute the direction and distance of the light and return the shadow ray
+            RT::Ray PrepareSample(const Vector3<double> &intPoint, RT::LightSample &sample) const;
     };
 }
 
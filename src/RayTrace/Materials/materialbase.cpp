@@ -1,10 +1,10 @@
 #include "materialbase.hpp"
+#include "../renderstats.hpp"
 
 // The default constructor and destructor
 RT::MaterialBase::MaterialBase()
 {
-    m_maxReflectionRays = 3;
-	m_reflectionRayCount = 0;
+
 }
 
 RT::MaterialBase::~MaterialBase()
@@ -13,40 +13,76 @@ RT::MaterialBase::~MaterialBase()
 }
 
 // Function to return the color of the material
-Vector<double> RT::MaterialBase::ComputeColor
+Vector3<double> RT::MaterialBase::ComputeColor
 (
-    const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
+    const RT::BVH &sceneBVH,
 	const std::vector<std::shared_ptr<RT::LightBase>> &lightList,
-	const std::shared_ptr<RT::ObjectBase> &currentObject,
-	const Vector<double> &intPoint, const Vector<double> &localNormal,
-	const RT::Ray &cameraRay
+	RT::BVH::ObjectHandle currentObject,
+	const Vector3<double> &intPoint, const Vector3<double> &localNormal,
+	const RT::Ray &cameraRay, const RT::ShadingContext &context
 ) {
     // Define an initial material color
-    Vector<double> matColor {3};
+    Vector3<double> matColor;
     return matColor;
 }
 
+// Functions to shade without recursion. The base material does not support this
+bool RT::MaterialBase::ComputeLocalShading
+(
+	RT::LightSampleCache &lightSamples, const Vector3<double> &localNormal,
+	const RT::Ray &incidentRay, RT::LocalShading &shading
+) {
+	return false;
+}
+
+Vector3<double> RT::MaterialBase::CombineShading(const RT::LocalShading &shading, const Vector3<double> &reflectionColor)
+{
+	return Vector3<double>();
+}
+
+// Function to return the reflected ray
+RT::Ray RT::MaterialBase::ComputeReflectionRay(const RT::Ray &incidentRay, const Vector3<double> &intPoint, const Vector3<double> &localNormal, bool canHitItself)
+{
+	// Compute the reflection vector
+	Vector3<double> d = incidentRay.m_lab;
+	Vector3<double> reflectionVector = d - (2 * Vector3<double>::dot(d, localNormal) * localNormal);
+	
+	// Construct the reflection ray. The object is not excluded from it if it can hit itself,
+	// so the ray starts just off the surface, as shadow rays do
+	Vector3<double> startPoint = canHitItself ? (intPoint + (localNormal * 0.001)) : intPoint;
+	return RT::Ray(startPoint, startPoint + reflectionVector);
+}
+
 // Function to compute the diffuse color
-Vector<double> RT::MaterialBase::ComputeDiffuseColor
+Vector3<double> RT::MaterialBase::ComputeDiffuseColor
 (
-    const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
+    const RT::BVH &sceneBVH,
 	const std::vector<std::shared_ptr<RT::LightBase>> &lightList,
-	const std::shared_ptr<RT::ObjectBase> &currentObject,
-	const Vector<double> &intPoint, const Vector<double> &localNormal,
-	const Vector<double> &baseColor
+	const Vector3<double> &intPoint, const Vector3<double> &localNormal,
+	const Vector3<double> &baseColor
+) {
+	RT::LightSampleCache lightSamples (sceneBVH, lightList, intPoint);
+	return ComputeDiffuseColor(lightSamples, localNormal, baseColor);
+}
+
+Vector3<double> RT::MaterialBase::ComputeDiffuseColor
+(
+    RT::LightSampleCache &lightSamples,
+	const Vector3<double> &localNormal, const Vector3<double> &baseColor
 ) {
     // Compute the color due to diffuse illumination
-	Vector<double> diffuseColor	{3};
+	Vector3<double> diffuseColor;
 	double intensity;
-	Vector<double> color {3};
+	Vector3<double> color;
 	double red = 0.0;
 	double green = 0.0;
 	double blue = 0.0;
 	bool validIllum = false;
 	bool illumFound = false;
-	for (auto currentLight : lightList)
+	const auto &lightList = lightSamples.GetLightList();
+	for (int i = 0; i < lightSamples.GetNumLights(); ++i)
 	{
-		validIllum = currentLight -> ComputeIllumination(intPoint, localNormal, objectList, currentObject, color, intensity);
+		validIllum = lightList[i] -> ComputeIllumination(localNormal, lightSamples.GetSample(i), color, intensity);
 		if (validIllum)
 		{
 			illumFound = true;
@@ -68,46 +104,51 @@ Vector<double> RT::MaterialBase::ComputeDiffuseColor
 }
 
 // Function to compute the color due to reflection.
-Vector<double> RT::MaterialBase::ComputeReflectionColor
+Vector3<double> RT::MaterialBase::ComputeReflectionColor
 (
-    const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
+    const RT::BVH &sceneBVH,
 	const std::vector<std::shared_ptr<RT::LightBase>> &lightList,
-	const std::shared_ptr<RT::ObjectBase> &currentObject,
-	const Vector<double> &intPoint, const Vector<double> &localNormal,
-	const RT::Ray &incidentRay
+	RT::BVH::ObjectHandle currentObject,
+	const Vector3<double> &intPoint, const Vector3<double> &localNormal,
+	const RT::Ray &incidentRay, const RT::ShadingContext &reflectionContext
 ) {
-	Vector<double> reflectionColor {3};
+	Vector3<double> reflectionColor;
 	
-	// Compute the reflection vector
-	Vector<double> d = incidentRay.m_lab;
-	Vector<double> reflectionVector = d - (2 * Vector<double>::dot(d, localNormal) * localNormal);
+	// Stop if this path has already been reflected as many times as allowed, or if
+	// so little of its color would reach the camera that it cannot change the pixel
+	if (!reflectionContext.WorthTracing())
+		return reflectionColor;
 	
-	// Construct the reflection ray.
-	RT::Ray reflectionRay (intPoint, intPoint + reflectionVector);
+	bool canHitItself = sceneBVH.GetObjects().CanHitItself(currentObject);
+	RT::Ray reflectionRay = ComputeReflectionRay(incidentRay, intPoint, localNormal, canHitItself);
+	RT::RenderCounters *pCounters = RT::RenderCounters::GetCurrent();
+	if (pCounters != nullptr)
+		pCounters -> CountReflectionRays(reflectionContext.m_depth, 1);
 	
-	// Cast this ray into the scene and find the closest object that it intersects with
-	std::shared_ptr<RT::ObjectBase> closestObject;
-	Vector<double> closestIntPoint			{3};
-	Vector<double> closestLocalNormal		{3};
-	Vector<double> closestLocalColor		{3};
-	bool intersectionFound = CastRay(reflectionRay, objectList, currentObject, closestObject, closestIntPoint, closestLocalNormal, closestLocalColor);
+	// Cast this ray into the scene and find the closest object that it intersects with. A convex
+	// object cannot reflect itself, so it is skipped rather than tested
+	RT::BVH::ObjectHandle closestHandle;
+	Vector3<double> closestIntPoint;
+	Vector3<double> closestLocalNormal;
+	Vector3<double> closestLocalColor;
+	RT::BVH::ObjectHandle excludedObject = canHitItself ? RT::BVH::NO_OBJECT : currentObject;
+	bool intersectionFound = CastRay(reflectionRay, sceneBVH, excludedObject, closestHandle, closestIntPoint, closestLocalNormal, closestLocalColor);
 	
 	// Compute illumination for closest object assuming that there was a valid intersection
-	Vector<double> matColor	{3};
-	if ((intersectionFound) && (m_reflectionRayCount < m_maxReflectionRays))
+	Vector3<double> matColor;
+	if (intersectionFound)
 	{
-		// Increment the reflectionRayCount
-		m_reflectionRayCount++;
+		RT::MaterialBase *pClosestMaterial = sceneBVH.GetObjects().GetMaterial(closestHandle);
 		
 		// Check if a material has been assigned
-		if (closestObject -> m_hasMaterial)
+		if (pClosestMaterial != nullptr)
 		{
 			// Use the material to compute the color
-			matColor = closestObject -> m_pMaterial -> ComputeColor(objectList, lightList, closestObject, closestIntPoint, closestLocalNormal, reflectionRay);
+			matColor = pClosestMaterial -> ComputeColor(sceneBVH, lightList, closestHandle, closestIntPoint, closestLocalNormal, reflectionRay, reflectionContext);
 		}
 		else
 		{
-			matColor = RT::MaterialBase::ComputeDiffuseColor(objectList, lightList, closestObject, closestIntPoint, closestLocalNormal, closestObject->m_baseColor);
+			matColor = RT::MaterialBase::ComputeDiffuseColor(sceneBVH, lightList, closestIntPoint, closestLocalNormal, sceneBVH.GetObjects().GetBaseColor(closestHandle));
 		}
 	}
 	else
@@ -122,46 +163,12 @@ Vector<double> RT::MaterialBase::ComputeReflectionColor
 // Function to cast a ray into the scene.
 bool RT::MaterialBase::CastRay
 (
-    const RT::Ray &castRay, const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
-	const std::shared_ptr<RT::ObjectBase> &thisObject,
-	std::shared_ptr<RT::ObjectBase> &closestObject,
-	Vector<double> &closestIntPoint, Vector<double> &closestLocalNormal,
-	Vector<double> &closestLocalColor
+    const RT::Ray &castRay, const RT::BVH &sceneBVH,
+	RT::BVH::ObjectHandle excludedObject,
+	RT::BVH::ObjectHandle &closestObject,
+	Vector3<double> &closestIntPoint, Vector3<double> &closestLocalNormal,
+	Vector3<double> &closestLocalColor
 ) {
-	// Test for intersections with all of the objects in the scene
-	Vector<double> intPoint		{3};
-	Vector<double> localNormal	{3};
-	Vector<double> localColor	{3};
-	
-	double minDist = 1e6;
-	bool intersectionFound = false;
-	for (auto currentObject : objectList)
-	{
-		if (currentObject != thisObject)
-		{
-			bool validInt = currentObject -> TestIntersection(castRay, intPoint, localNormal, localColor);
-			
-			// If we have a valid intersection
-			if (validInt)
-			{
-				// Set the flag to show that we found an intersection
-				intersectionFound = true;
-				
-				// Compute the distance between the source and the intersection point
-				double dist = (intPoint - castRay.m_point1).norm();
-				
-				// Store a reference to this object if it is the closest
-				if (dist < minDist)
-				{
-					minDist = dist;
-					closestObject = currentObject;
-					closestIntPoint = intPoint;
-					closestLocalNormal = localNormal;
-					closestLocalColor = localColor;
-				}
-			}
-		}
-	}
-	
-	return intersectionFound;
+	// Find the closest object other than the excluded one
+	return sceneBVH.CastRay(castRay, excludedObject, closestObject, closestIntPoint, closestLocalNormal, closestLocalColor);
 }
\ No newline at end of file
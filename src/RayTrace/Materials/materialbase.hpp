@@ -4,11 +4,24 @@
 #include <memory>
 #include "../Primatives/objectbase.hpp"
 #include "../Lights/lightbase.hpp"
-#include "../../LinAlg/Vector.h"
+#include "../Lights/lightsample.hpp"
+#include "../../LinAlg/Vector3.hpp"
 #include "../ray.hpp"
+#include "../shadingcontext.hpp"
 
 namespace RT
 {
+	// The part of a material's color at a point that does not depend on any further rays
+	struct LocalShading
+	{
+		Vector3<double> m_diffuse;
+		Vector3<double> m_specular;
+		double m_reflectivity = 0.0;
+		
+		// Whether the color also depends on the color seen along the reflected ray
+		bool m_reflects = false;
+	};
+	
 	class MaterialBase
 	{
 		public:
@@ -17,52 +30,68 @@ namespace RT
 			virtual ~MaterialBase();
 			
 			// Function to return the color of the material
-			virtual Vector<double> ComputeColor
+			virtual Vector3<double> ComputeColor
             (
-                const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
+                const RT::BVH &sceneBVH,
 				const std::vector<std::shared_ptr<RT::LightBase>> &lightList,
-				const std::shared_ptr<RT::ObjectBase> &currentObject,
-				const Vector<double> &intPoint, const Vector<double> &localNormal,
-				const RT::Ray &cameraRay
+				RT::BVH::ObjectHandle currentObject,
+				const Vector3<double> &intPoint, const Vector3<double> &localNormal,
+				const RT::Ray &cameraRay, const RT::ShadingContext &context
             );
 																							
+			/*
+				Functions used to shade without recursion (eg. by the wavefront renderer, which traces
+				all of the reflections at one depth together). ComputeLocalShading computes everything
+				except the reflection, and returns false if the material does not support this, in which
+				case it must be shaded with ComputeColor. CombineShading then adds the color seen along
+				the reflected ray, and gives the same result as ComputeColor
+			*/
+			virtual bool ComputeLocalShading
+			(
+				RT::LightSampleCache &lightSamples, const Vector3<double> &localNormal,
+				const RT::Ray &incidentRay, RT::LocalShading &shading
+			);
+			virtual Vector3<double> CombineShading(const RT::LocalShading &shading, const Vector3<double> &reflectionColor);
+			
+			// Function to return the ray reflected at a point. If the object can hit itself, the ray
+			// starts just off the surface so that it does not hit the point that it leaves from
+			static RT::Ray ComputeReflectionRay(const RT::Ray &incidentRay, const Vector3<double> &intPoint, const Vector3<double> &localNormal, bool canHitItself);
+			
 			// Function to compute the diffuse color
-			static Vector<double> ComputeDiffuseColor
+			static Vector3<double> ComputeDiffuseColor
             (
-                const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
+                const RT::BVH &sceneBVH,
 				const std::vector<std::shared_ptr<RT::LightBase>> &lightList,
-				const std::shared_ptr<RT::ObjectBase> &currentObject,
-				const Vector<double> &intPoint, const Vector<double> &localNormal,
-				const Vector<double> &baseColor
+				const Vector3<double> &intPoint, const Vector3<double> &localNormal,
+				const Vector3<double> &baseColor
+            );
+			
+			// Function to compute the diffuse color, reusing the light samples already taken at this point
+			static Vector3<double> ComputeDiffuseColor
+            (
+                RT::LightSampleCache &lightSamples,
+				const Vector3<double> &localNormal, const Vector3<double> &baseColor
             );
 																										
-			// Function to compute the reflection color
-			Vector<double> ComputeReflectionColor
+			// Function to compute the reflection color. The context describes the reflected ray
+			Vector3<double> ComputeReflectionColor
             (
-                const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
+                const RT::BVH &sceneBVH,
 				const std::vector<std::shared_ptr<RT::LightBase>> &lightList,
-				const std::shared_ptr<RT::ObjectBase> &currentObject,
-				const Vector<double> &intPoint, const Vector<double> &localNormal,
-				const RT::Ray &incidentRay
+				RT::BVH::ObjectHandle currentObject,
+				const Vector3<double> &intPoint, const Vector3<double> &localNormal,
+				const RT::Ray &incidentRay, const RT::ShadingContext &reflectionContext
             );
 																										
-			// Function to cast a ray into the scene
+			// Function to cast a ray into the scene, ignoring excludedObject if it is not NO_OBJECT
 			bool CastRay
             (
-                const RT::Ray &castRay, const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
-				const std::shared_ptr<RT::ObjectBase> &thisObject,
-				std::shared_ptr<RT::ObjectBase> &closestObject,
-				Vector<double> &closestIntPoint, Vector<double> &closestLocalNormal,
-				Vector<double> &closestLocalColor
+                const RT::Ray &castRay, const RT::BVH &sceneBVH,
+				RT::BVH::ObjectHandle excludedObject,
+				RT::BVH::ObjectHandle &closestObject,
+				Vector3<double> &closestIntPoint, Vector3<double> &closestLocalNormal,
+				Vector3<double> &closestLocalColor
             );
-										
-		public:
-			// Counter for the number of relection rays
-			inline static int m_maxReflectionRays;
-			inline static int m_reflectionRayCount;
-		
-		private:
-		
 	};
 }
 
@@ -12,92 +12,91 @@ RT::SimpleMaterial::~SimpleMaterial()
 }
 
 // Function to return the color
-Vector<double> RT::SimpleMaterial::ComputeColor
+Vector3<double> RT::SimpleMaterial::ComputeColor
 (
-    const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
+    const RT::BVH &sceneBVH,
 	const std::vector<std::shared_ptr<RT::LightBase>> &lightList,
-	const std::shared_ptr<RT::ObjectBase> &currentObject,
-	const Vector<double> &intPoint, const Vector<double> &localNormal,
-	const RT::Ray &cameraRay
+	RT::BVH::ObjectHandle currentObject,
+	const Vector3<double> &intPoint, const Vector3<double> &localNormal,
+	const RT::Ray &cameraRay, const RT::ShadingContext &context
 ) {
-	// Define the initial material colors
-	Vector<double> matColor	{3};
-	Vector<double> refColor {3};
-	Vector<double> difColor	{3};
-	Vector<double> spcColor	{3};
+	// The light samples at this point, shared by the diffuse and specular components
+	RT::LightSampleCache lightSamples (sceneBVH, lightList, intPoint, context.m_pLightSamples);
 	
-	// Compute the diffuse component
-	difColor = ComputeDiffuseColor(objectList, lightList, currentObject, intPoint, localNormal, m_baseColor);
+	// Compute the diffuse and specular components
+	RT::LocalShading shading;
+	ComputeLocalShading(lightSamples, localNormal, cameraRay, shading);
 	
 	// Compute the reflection component
-	if (m_reflectivity > 0.0)
-		refColor = ComputeReflectionColor(objectList, lightList, currentObject, intPoint, localNormal, cameraRay);
-		
-	// Combine reflection and diffuse components
-	matColor = (refColor * m_reflectivity) + (difColor * (1 - m_reflectivity));
+	Vector3<double> refColor;
+	if (shading.m_reflects)
+		refColor = ComputeReflectionColor(sceneBVH, lightList, currentObject, intPoint, localNormal, cameraRay, context.Reflected(m_reflectivity));
+	
+	return CombineShading(shading, refColor);
+}
+
+// Function to compute the parts of the color that do not need further rays
+bool RT::SimpleMaterial::ComputeLocalShading
+(
+	RT::LightSampleCache &lightSamples, const Vector3<double> &localNormal,
+	const RT::Ray &incidentRay, RT::LocalShading &shading
+) {
+	// Compute the diffuse component
+	shading.m_diffuse = ComputeDiffuseColor(lightSamples, localNormal, m_baseColor);
 	
 	// Compute the specular component
+	shading.m_specular = Vector3<double>();
 	if (m_shininess > 0.0)
-		spcColor = ComputeSpecular(objectList, lightList, intPoint, localNormal, cameraRay);
-		
+		shading.m_specular = ComputeSpecular(lightSamples, localNormal, incidentRay);
+	
+	shading.m_reflectivity = m_reflectivity;
+	shading.m_reflects = m_reflectivity > 0.0;
+	return true;
+}
+
+// Function to combine the local shading with the reflection
+Vector3<double> RT::SimpleMaterial::CombineShading(const RT::LocalShading &shading, const Vector3<double> &reflectionColor)
+{
+	// Combine reflection and diffuse components
+	Vector3<double> matColor = (reflectionColor * shading.m_reflectivity) + (shading.m_diffuse * (1 - shading.m_reflectivity));
+	
 	// Add the specular component to the final color
-	matColor = matColor + spcColor;
+	matColor = matColor + shading.m_specular;
 	
 	return matColor;
 }
 
 // Function to compute the specular highlights
-Vector<double> RT::SimpleMaterial::ComputeSpecular
+Vector3<double> RT::SimpleMaterial::ComputeSpecular
 (
-    const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
-	const std::vector<std::shared_ptr<RT::LightBase>> &lightList,
-	const Vector<double> &intPoint, const Vector<double> &localNormal,
-	const RT::Ray &cameraRay
+    RT::LightSampleCache &lightSamples,
+	const Vector3<double> &localNormal, const RT::Ray &cameraRay
 ) {
-	Vector<double> spcColor	{3};
+	Vector3<double> spcColor;
 	double red = 0.0;
 	double green = 0.0;
 	double blue = 0.0;
 	
 	// Loop through all of the lights in the scene
-	for (auto currentLight : lightList)
+	const auto &lightList = lightSamples.GetLightList();
+	for (int i = 0; i < lightSamples.GetNumLights(); ++i)
 	{
-		// Check for intersections with all objects in the scene
+		const auto &currentLight = lightList[i];
 		double intensity = 0.0;
 		
-		// Construct a vector pointing from the intersection point to the light
-		Vector<double> lightDir = (currentLight->m_location - intPoint).Normalized();
-		
-		// Compute a start point
-		Vector<double> startPoint = intPoint + (lightDir * 0.001);
-		
-		// Construct a ray from the point of intersection to the light
-		RT::Ray lightRay (startPoint, startPoint + lightDir);
-		
-		// Loop through all objects in the scene to check if any obstruct light from this source
-		Vector<double> poi			{3};
-		Vector<double> poiNormal	{3};
-		Vector<double> poiColor		{3};
-		bool validInt = false;
-		for (auto sceneObject : objectList)
-		{
-			validInt = sceneObject -> TestIntersection(lightRay, poi, poiNormal, poiColor);
-			if (validInt)
-				break;
-		}
-		
-		// If no intersections were found, then proceed with computing the specular component
-		if (!validInt)
+		// If no object obstructs this light, then proceed with computing the specular component
+		const RT::LightSample &sample = lightSamples.GetSample(i);
+		if (sample.m_visible)
 		{
 			// Compute the reflection vector
-			Vector<double> d = lightRay.m_lab;
-			Vector<double> r = d - (2 * Vector<double>::dot(d, localNormal) * localNormal);
+			Vector3<double> d = sample.m_direction;
+			Vector3<double> r = d - (2 * Vector3<double>::dot(d, localNormal) * localNormal);
 			r.Normalize();
 			
 			// Compute the dot product
-			Vector<double> v = cameraRay.m_lab;
+			Vector3<double> v = cameraRay.m_lab;
 			v.Normalize();
-			double dotProduct = Vector<double>::dot(r, v);
+			double dotProduct = Vector3<double>::dot(r, v);
 			
 			// Only proceed if the dot product is positive
 			if (dotProduct > 0.0)
@@ -13,26 +13,32 @@ namespace RT
 			virtual ~SimpleMaterial() override;
 			
 			// Function to return the color
-			virtual Vector<double> ComputeColor
+			virtual Vector3<double> ComputeColor
             (
-                const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
+                const RT::BVH &sceneBVH,
 				const std::vector<std::shared_ptr<RT::LightBase>> &lightList,
-				const std::shared_ptr<RT::ObjectBase> &currentObject,
-				const Vector<double> &intPoint, const Vector<double> &localNormal,
-				const RT::Ray &cameraRay
+				RT::BVH::ObjectHandle currentObject,
+				const Vector3<double> &intPoint, const Vector3<double> &localNormal,
+				const RT::Ray &cameraRay, const RT::ShadingContext &context
             ) override;
 																							
+			// Functions to shade without recursion
+			virtual bool ComputeLocalShading
+			(
+				RT::LightSampleCache &lightSamples, const Vector3<double> &localNormal,
+				const RT::Ray &incidentRay, RT::LocalShading &shading
+			) override;
+			virtual Vector3<double> CombineShading(const RT::LocalShading &shading, const Vector3<double> &reflectionColor) override;
+			
 			// Function to compute specular highlights
-			Vector<double> ComputeSpecular
+			Vector3<double> ComputeSpecular
             (
-                const std::vector<std::shared_ptr<RT::ObjectBase>> &objectList,
-				const std::vector<std::shared_ptr<RT::LightBase>> &lightList,
-				const Vector<double> &intPoint, const Vector<double> &localNormal,
-				const RT::Ray &cameraRay
+                RT::LightSampleCache &lightSamples,
+				const Vector3<double> &localNormal, const RT::Ray &cameraRay
             );
 																				
 		public:
-			Vector<double> m_baseColor {std::vector<double> {1.0, 0.0, 1.0}};
+			Vector3<double> m_baseColor {1.0, 0.0, 1.0};
 			double m_reflectivity = 0.0;
 			double m_shininess = 0.0;
 	};
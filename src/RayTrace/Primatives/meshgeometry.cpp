@@ -0,0 +1,623 @@
+#include "meshgeometry.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+// Build parameters
+namespace
+{
+    // Number of bins used to evaluate the SAH along each axis
+    constexpr int NUM_BINS = 12;
+
+    // Nodes with this many triangles or fewer are always leaves, and nodes with more than
+    // MAX_LEAF_SIZE are always split
+    constexpr int MIN_LEAF_SIZE = 2;
+    constexpr int MAX_LEAF_SIZE = 16;
+
+    // Beyond this depth the build falls back to median splits, which bounds the traversal stack
+    constexpr int MAX_BUILD_DEPTH = 64;
+    constexpr int TRAVERSAL_STACK_SIZE = 128;
+
+    // Relative cost of traversing a node compared to testing a triangle
+    constexpr double TRAVERSAL_COST = 1.0;
+
+    double SurfaceArea(const float *min, const float *max)
+    {
+        double x = static_cast<double>(max[0]) - min[0];
+        double y = static_cast<double>(max[1]) - min[1];
+        double z = static_cast<double>(max[2]) - min[2];
+        return 2.0 * ((x * y) + (y * z) + (z * x));
+    }
+
+    // Bounds in floats, which are exact for bounds of float vertices. The arrays are padded to
+    // four so that growing one box by another compiles to a pair of SIMD min and max operations
+    struct FloatBounds
+    {
+        float m_min[4] = { std::numeric_limits<float>::max(),  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max(), 0.0f};
+        float m_max[4] = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), 0.0f};
+
+        void Grow(const float *min, const float *max)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                m_min[axis] = std::min(m_min[axis], min[axis]);
+                m_max[axis] = std::max(m_max[axis], max[axis]);
+            }
+        }
+
+        void Grow(const FloatBounds &bounds)
+        {
+            for (int axis = 0; axis < 4; ++axis)
+            {
+                m_min[axis] = std::min(m_min[axis], bounds.m_min[axis]);
+                m_max[axis] = std::max(m_max[axis], bounds.m_max[axis]);
+            }
+        }
+    };
+}
+
+// A ray in local coordinates. The kernel works in a frame where the ray runs along +z,
+// so the axes are permuted and the other two are sheared, as described by Woop et al.
+struct RT::MeshGeometry::LocalRay
+{
+    double m_origin[3];
+    double m_invDir[3];
+    int m_kx;
+    int m_ky;
+    int m_kz;
+    double m_sx;
+    double m_sy;
+    double m_sz;
+
+    explicit LocalRay(const RT::Ray &ray)
+    {
+        const double dir[3] = {ray.m_lab.m_x, ray.m_lab.m_y, ray.m_lab.m_z};
+        m_origin[0] = ray.m_point1.m_x;
+        m_origin[1] = ray.m_point1.m_y;
+        m_origin[2] = ray.m_point1.m_z;
+        for (int axis = 0; axis < 3; ++axis)
+            m_invDir[axis] = 1.0 / dir[axis];
+
+        // Make the largest component of the direction z, keeping the winding of the frame
+        m_kz = 0;
+        if (std::abs(dir[1]) > std::abs(dir[m_kz]))
+            m_kz = 1;
+        if (std::abs(dir[2]) > std::abs(dir[m_kz]))
+            m_kz = 2;
+        m_kx = (m_kz + 1) % 3;
+        m_ky = (m_kx + 1) % 3;
+        if (dir[m_kz] < 0.0)
+            std::swap(m_kx, m_ky);
+
+        m_sx = dir[m_kx] / dir[m_kz];
+        m_sy = dir[m_ky] / dir[m_kz];
+        m_sz = 1.0 / dir[m_kz];
+    }
+};
+
+// The default constructor, which makes an empty mesh
+RT::MeshGeometry::MeshGeometry()
+{
+
+}
+
+// Function to test whether the arrays describe a valid mesh
+bool RT::MeshGeometry::IsValid(const RT::MappableArray<float> &positions, const RT::MappableArray<uint32_t> &indices, const RT::MappableArray<float> &normals)
+{
+    size_t numVertices = positions.size() / 3;
+    bool valid = (positions.size() % 3 == 0) && (indices.size() % 3 == 0) && (numVertices <= static_cast<size_t>(std::numeric_limits<int32_t>::max()));
+    valid = valid && (indices.size() / 3 <= static_cast<size_t>(std::numeric_limits<int32_t>::max() / 2));
+    valid = valid && (normals.empty() || (normals.size() == positions.size()));
+    for (size_t i = 0; valid && (i < indices.size()); ++i)
+        valid = (indices[i] < numVertices);
+
+    return valid;
+}
+
+// Function to set the triangles
+bool RT::MeshGeometry::SetTriangles(std::vector<float> positions, std::vector<uint32_t> indices, std::vector<float> normals)
+{
+    RT::MappableArray<float> positionArray (std::move(positions));
+    RT::MappableArray<uint32_t> indexArray (std::move(indices));
+    RT::MappableArray<float> normalArray (std::move(normals));
+    if (!IsValid(positionArray, indexArray, normalArray))
+        return false;
+
+    m_positions = std::move(positionArray);
+    m_indices = std::move(indexArray);
+    m_normals = std::move(normalArray);
+    BuildTree();
+    UpdateBounds();
+    return true;
+}
+
+// Function to set the triangles with an existing BVH
+bool RT::MeshGeometry::Restore
+(
+    RT::MappableArray<float> positions, RT::MappableArray<uint32_t> indices,
+    RT::MappableArray<float> normals, RT::MappableArray<Node> nodes
+) {
+    // The tree must be a tree over the triangles, not deeper than the traversal stack allows
+    int numTriangles = static_cast<int>(indices.size() / 3);
+    bool valid = IsValid(positions, indices, normals) && (nodes.empty() == (numTriangles == 0));
+    valid = valid && (nodes.size() <= 2 * static_cast<size_t>(numTriangles));
+    int numNodes = static_cast<int>(nodes.size());
+    std::vector<char> visited (nodes.size(), 0);
+    std::vector<std::pair<int, int>> pending;
+    if (valid && (numNodes > 0))
+        pending.emplace_back(0, 0);
+
+    while (valid && !pending.empty())
+    {
+        int nodeIndex = pending.back().first;
+        int depth = pending.back().second;
+        pending.pop_back();
+        const Node &node = nodes[nodeIndex];
+        valid = !visited[nodeIndex] && (depth < TRAVERSAL_STACK_SIZE - 2);
+        visited[nodeIndex] = 1;
+        if (!valid)
+            break;
+
+        if (node.m_count > 0)
+        {
+            valid = (node.m_first >= 0) && (node.m_first <= numTriangles - node.m_count);
+        }
+        else
+        {
+            valid = (node.m_count == 0) && (node.m_first > 0) && (node.m_first < numNodes - 1);
+            pending.emplace_back(node.m_first, depth + 1);
+            pending.emplace_back(node.m_first + 1, depth + 1);
+        }
+    }
+
+    if (!valid)
+        return false;
+
+    m_positions = std::move(positions);
+    m_indices = std::move(indices);
+    m_normals = std::move(normals);
+    m_nodes = std::move(nodes);
+    UpdateBounds();
+    return true;
+}
+
+// Functions to return the size of the mesh
+int RT::MeshGeometry::GetNumVertices() const
+{
+    return static_cast<int>(m_positions.size() / 3);
+}
+
+int RT::MeshGeometry::GetNumTriangles() const
+{
+    return static_cast<int>(m_indices.size() / 3);
+}
+
+// Functions to return the arrays of the mesh
+const RT::MappableArray<float> &RT::MeshGeometry::GetPositions() const
+{
+    return m_positions;
+}
+
+const RT::MappableArray<float> &RT::MeshGeometry::GetNormals() const
+{
+    return m_normals;
+}
+
+const RT::MappableArray<uint32_t> &RT::MeshGeometry::GetIndices() const
+{
+    return m_indices;
+}
+
+const RT::MappableArray<RT::MeshGeometry::Node> &RT::MeshGeometry::GetNodes() const
+{
+    return m_nodes;
+}
+
+// Function to return the bounds of the mesh
+const RT::AABB &RT::MeshGeometry::GetBounds() const
+{
+    return m_bounds;
+}
+
+// Function to return the memory used by the arrays
+size_t RT::MeshGeometry::GetMemorySize() const
+{
+    return (m_positions.capacity() * sizeof(float)) + (m_normals.capacity() * sizeof(float)) +
+           (m_indices.capacity() * sizeof(uint32_t)) + (m_nodes.capacity() * sizeof(Node));
+}
+
+// Function to set the bounds from the root of the BVH
+void RT::MeshGeometry::UpdateBounds()
+{
+    m_bounds = RT::AABB();
+    if (m_nodes.empty())
+        return;
+
+    const Node &root = m_nodes[0];
+    m_bounds.m_min = Vector3<double>{root.m_min[0], root.m_min[1], root.m_min[2]};
+    m_bounds.m_max = Vector3<double>{root.m_max[0], root.m_max[1], root.m_max[2]};
+}
+
+// A triangle's bounds and centroid. The build partitions these records rather than indices
+// into separate arrays, so that every pass over a node reads memory in order
+struct RT::MeshGeometry::BuildTriangle
+{
+    FloatBounds m_bounds;
+    float m_centroid[3];
+    int m_triangle;
+};
+
+// Function to build the BVH over the triangles
+void RT::MeshGeometry::BuildTree()
+{
+    m_nodes.clear();
+    int numTriangles = GetNumTriangles();
+    if (numTriangles == 0)
+        return;
+
+    std::vector<BuildTriangle> triangles (numTriangles);
+    for (int triangle = 0; triangle < numTriangles; ++triangle)
+    {
+        BuildTriangle &record = triangles[triangle];
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            const float *vertex = &m_positions[3 * static_cast<size_t>(m_indices[(3 * static_cast<size_t>(triangle)) + corner])];
+            record.m_bounds.Grow(vertex, vertex);
+        }
+        for (int axis = 0; axis < 3; ++axis)
+            record.m_centroid[axis] = 0.5f * (record.m_bounds.m_min[axis] + record.m_bounds.m_max[axis]);
+        record.m_triangle = triangle;
+    }
+
+    m_nodes.reserve(2 * static_cast<size_t>(numTriangles));
+    m_nodes.push_back(Node());
+    BuildNode(0, triangles, 0, numTriangles, 0);
+
+    // Store the triangles in leaf order so that each leaf is a contiguous range
+    std::vector<uint32_t> indices (m_indices.size());
+    for (int i = 0; i < numTriangles; ++i)
+        std::copy_n(&m_indices[3 * static_cast<size_t>(triangles[i].m_triangle)], 3, &indices[3 * static_cast<size_t>(i)]);
+    m_indices = std::move(indices);
+    m_nodes.shrink_to_fit();
+}
+
+// Function to build one node (and, recursively, its children)
+void RT::MeshGeometry::BuildNode(int nodeIndex, std::vector<BuildTriangle> &triangles, int first, int count, int depth)
+{
+    BuildTriangle *begin = triangles.data() + first;
+    BuildTriangle *end = begin + count;
+
+    // Compute the bounds of the triangles, and of their centroids
+    FloatBounds bounds;
+    FloatBounds centroidBounds;
+    for (const BuildTriangle *triangle = begin; triangle < end; ++triangle)
+    {
+        bounds.Grow(triangle -> m_bounds);
+        centroidBounds.Grow(triangle -> m_centroid, triangle -> m_centroid);
+    }
+
+    Node &node = m_nodes.Modify(nodeIndex);
+    std::copy(bounds.m_min, bounds.m_min + 3, node.m_min);
+    std::copy(bounds.m_max, bounds.m_max + 3, node.m_max);
+    node.m_first = first;
+    node.m_count = count;
+    if (count <= MIN_LEAF_SIZE)
+        return;
+
+    // Bin the centroids along all three axes in one pass
+    FloatBounds binBounds[3][NUM_BINS];
+    int binCounts[3][NUM_BINS] = {};
+    double binScale[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        double extent = static_cast<double>(centroidBounds.m_max[axis]) - centroidBounds.m_min[axis];
+        binScale[axis] = (extent > 0.0) ? NUM_BINS / extent : 0.0;
+    }
+
+    auto getBin = [&](const BuildTriangle &triangle, int axis)
+    {
+        return std::min(NUM_BINS - 1, static_cast<int>((static_cast<double>(triangle.m_centroid[axis]) - centroidBounds.m_min[axis]) * binScale[axis]));
+    };
+
+    double parentArea = SurfaceArea(bounds.m_min, bounds.m_max);
+    bool useSAH = (depth < MAX_BUILD_DEPTH) && (parentArea > 0.0);
+    if (useSAH)
+    {
+        for (const BuildTriangle *triangle = begin; triangle < end; ++triangle)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                int bin = getBin(*triangle, axis);
+                binBounds[axis][bin].Grow(triangle -> m_bounds);
+                ++binCounts[axis][bin];
+            }
+        }
+    }
+
+    // Find the cheapest split between two bins
+    int bestAxis = -1;
+    int bestBin = 0;
+    double bestCost = static_cast<double>(count);
+    for (int axis = 0; useSAH && (axis < 3); ++axis)
+    {
+        if (binScale[axis] == 0.0)
+            continue;
+
+        // Sweep from the right to get the area and count on the right of each boundary
+        double rightArea[NUM_BINS];
+        int rightCount[NUM_BINS];
+        FloatBounds accumulated;
+        int accumulatedCount = 0;
+        for (int bin = NUM_BINS - 1; bin > 0; --bin)
+        {
+            accumulated.Grow(binBounds[axis][bin]);
+            accumulatedCount += binCounts[axis][bin];
+            rightArea[bin - 1] = (accumulatedCount > 0) ? SurfaceArea(accumulated.m_min, accumulated.m_max) : 0.0;
+            rightCount[bin - 1] = accumulatedCount;
+        }
+
+        accumulated = FloatBounds();
+        accumulatedCount = 0;
+        for (int bin = 0; bin < NUM_BINS - 1; ++bin)
+        {
+            accumulated.Grow(binBounds[axis][bin]);
+            accumulatedCount += binCounts[axis][bin];
+            if ((accumulatedCount == 0) || (rightCount[bin] == 0))
+                continue;
+
+            double cost = TRAVERSAL_COST + ((SurfaceArea(accumulated.m_min, accumulated.m_max) * accumulatedCount) + (rightArea[bin] * rightCount[bin])) / parentArea;
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = bin;
+            }
+        }
+    }
+
+    // Splitting is not worth it
+    if ((bestAxis < 0) && (count <= MAX_LEAF_SIZE))
+        return;
+
+    BuildTriangle *mid = begin;
+    if (bestAxis >= 0)
+    {
+        mid = std::partition(begin, end, [&](const BuildTriangle &triangle)
+        {
+            return getBin(triangle, bestAxis) <= bestBin;
+        });
+    }
+
+    if ((mid == begin) || (mid == end))
+    {
+        // Fall back to a median split along the longest axis of the centroids
+        int axis = 0;
+        for (int a = 1; a < 3; ++a)
+        {
+            if (centroidBounds.m_max[a] - centroidBounds.m_min[a] > centroidBounds.m_max[axis] - centroidBounds.m_min[axis])
+                axis = a;
+        }
+
+        mid = begin + (count / 2);
+        std::nth_element(begin, mid, end, [axis](const BuildTriangle &a, const BuildTriangle &b)
+        {
+            return a.m_centroid[axis] < b.m_centroid[axis];
+        });
+    }
+
+    // Create the two children (note that this may reallocate m_nodes, so node is not used again)
+    int leftIndex = static_cast<int>(m_nodes.size());
+    int leftCount = static_cast<int>(mid - begin);
+    m_nodes.push_back(Node());
+    m_nodes.push_back(Node());
+    m_nodes.Modify(nodeIndex).m_first = leftIndex;
+    m_nodes.Modify(nodeIndex).m_count = 0;
+
+    BuildNode(leftIndex, triangles, first, leftCount, depth + 1);
+    BuildNode(leftIndex + 1, triangles, first + leftCount, count - leftCount, depth + 1);
+}
+
+// Function to test a ray against one triangle with the watertight kernel
+bool RT::MeshGeometry::IntersectTriangle(const LocalRay &ray, int triangle, double tMin, double tMax, double &t, double &u, double &v) const
+{
+    const uint32_t *corners = &m_indices[3 * static_cast<size_t>(triangle)];
+    const float *p0 = &m_positions[3 * static_cast<size_t>(corners[0])];
+    const float *p1 = &m_positions[3 * static_cast<size_t>(corners[1])];
+    const float *p2 = &m_positions[3 * static_cast<size_t>(corners[2])];
+    const int kx = ray.m_kx;
+    const int ky = ray.m_ky;
+    const int kz = ray.m_kz;
+
+    // The vertices relative to the ray origin, sheared so that the ray runs along +z
+    double az = p0[kz] - ray.m_origin[kz];
+    double bz = p1[kz] - ray.m_origin[kz];
+    double cz = p2[kz] - ray.m_origin[kz];
+    double ax = (p0[kx] - ray.m_origin[kx]) - (ray.m_sx * az);
+    double ay = (p0[ky] - ray.m_origin[ky]) - (ray.m_sy * az);
+    double bx = (p1[kx] - ray.m_origin[kx]) - (ray.m_sx * bz);
+    double by = (p1[ky] - ray.m_origin[ky]) - (ray.m_sy * bz);
+    double cx = (p2[kx] - ray.m_origin[kx]) - (ray.m_sx * cz);
+    double cy = (p2[ky] - ray.m_origin[ky]) - (ray.m_sy * cz);
+
+    // The scaled barycentric coordinates must all have the same sign. An edge that the ray
+    // passes exactly through gives zero for both triangles that share it, so neither is missed
+    double eu = (cx * by) - (cy * bx);
+    double ev = (ax * cy) - (ay * cx);
+    double ew = (bx * ay) - (by * ax);
+    if (((eu < 0.0) || (ev < 0.0) || (ew < 0.0)) && ((eu > 0.0) || (ev > 0.0) || (ew > 0.0)))
+        return false;
+
+    double det = eu + ev + ew;
+    if (det == 0.0)
+        return false;
+
+    double scaledT = (eu * az + ev * bz + ew * cz) * ray.m_sz;
+    double hitT = scaledT / det;
+    if (!((hitT > tMin) && (hitT < tMax)))
+        return false;
+
+    t = hitT;
+    u = ev / det;
+    v = ew / det;
+    return true;
+}
+
+/*
+    Function to test a ray against the bounds of a node. The exit distance is enlarged by a
+    few rounding errors, so that a ray that grazes a vertex on the boundary of a node is not
+    culled before the watertight kernel gets to test it
+*/
+static inline bool IntersectBounds(const float *min, const float *max, const double *origin, const double *invDir, double tMin, double tMax, double &tEntry)
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        double t1 = (min[axis] - origin[axis]) * invDir[axis];
+        double t2 = (max[axis] - origin[axis]) * invDir[axis];
+        tMin = std::max(tMin, std::min(t1, t2));
+        tMax = std::min(tMax, std::max(t1, t2) * (1.0 + (4.0 * std::numeric_limits<double>::epsilon())));
+    }
+
+    tEntry = tMin;
+    return tMin <= tMax;
+}
+
+// Function to find the closest triangle hit of a local ray
+bool RT::MeshGeometry::FindClosest(const LocalRay &ray, double tMin, Hit &hit) const
+{
+    double tEntry;
+    if (m_nodes.empty() || !IntersectBounds(m_nodes[0].m_min, m_nodes[0].m_max, ray.m_origin, ray.m_invDir, tMin, hit.m_t, tEntry))
+        return false;
+
+    // Visit the nearer child first, and skip nodes that are further than the closest hit when they are popped
+    int stack[TRAVERSAL_STACK_SIZE];
+    double stackEntry[TRAVERSAL_STACK_SIZE];
+    int stackSize = 0;
+    int nodeIndex = 0;
+    bool found = false;
+    while (true)
+    {
+        const Node &node = m_nodes[nodeIndex];
+        if (node.m_count > 0)
+        {
+            for (int triangle = node.m_first; triangle < node.m_first + node.m_count; ++triangle)
+            {
+                double t, u, v;
+                if (IntersectTriangle(ray, triangle, tMin, hit.m_t, t, u, v))
+                {
+                    hit = Hit{t, triangle, u, v};
+                    found = true;
+                }
+            }
+        }
+        else
+        {
+            const Node &left = m_nodes[node.m_first];
+            const Node &right = m_nodes[node.m_first + 1];
+            double tLeft, tRight;
+            bool hitLeft = IntersectBounds(left.m_min, left.m_max, ray.m_origin, ray.m_invDir, tMin, hit.m_t, tLeft);
+            bool hitRight = IntersectBounds(right.m_min, right.m_max, ray.m_origin, ray.m_invDir, tMin, hit.m_t, tRight);
+            if (hitLeft && hitRight)
+            {
+                bool leftFirst = tLeft <= tRight;
+                stack[stackSize] = leftFirst ? node.m_first + 1 : node.m_first;
+                stackEntry[stackSize] = leftFirst ? tRight : tLeft;
+                ++stackSize;
+                nodeIndex = leftFirst ? node.m_first : node.m_first + 1;
+                continue;
+            }
+            if (hitLeft || hitRight)
+            {
+                nodeIndex = hitLeft ? node.m_first : node.m_first + 1;
+                continue;
+            }
+        }
+
+        // Pop the next node that could still hold a closer hit
+        do
+        {
+            if (stackSize == 0)
+                return found;
+            --stackSize;
+        } while (stackEntry[stackSize] > hit.m_t);
+        nodeIndex = stack[stackSize];
+    }
+}
+
+// Function to test whether any triangle is hit by a local ray
+bool RT::MeshGeometry::FindAny(const LocalRay &ray, double tMin, double tMax) const
+{
+    double tEntry;
+    if (m_nodes.empty() || !IntersectBounds(m_nodes[0].m_min, m_nodes[0].m_max, ray.m_origin, ray.m_invDir, tMin, tMax, tEntry))
+        return false;
+
+    int stack[TRAVERSAL_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const Node &node = m_nodes[stack[--stackSize]];
+        if (node.m_count > 0)
+        {
+            for (int triangle = node.m_first; triangle < node.m_first + node.m_count; ++triangle)
+            {
+                double t, u, v;
+                if (IntersectTriangle(ray, triangle, tMin, tMax, t, u, v))
+                    return true;
+            }
+            continue;
+        }
+
+        for (int child = node.m_first; child < node.m_first + 2; ++child)
+        {
+            if (IntersectBounds(m_nodes[child].m_min, m_nodes[child].m_max, ray.m_origin, ray.m_invDir, tMin, tMax, tEntry))
+                stack[stackSize++] = child;
+        }
+    }
+
+    return false;
+}
+
+// Function to find the closest triangle hit
+bool RT::MeshGeometry::FindClosest(const RT::Ray &ray, double tMin, Hit &hit) const
+{
+    return FindClosest(LocalRay(ray), tMin, hit);
+}
+
+// Function to test whether any triangle is hit
+bool RT::MeshGeometry::FindAny(const RT::Ray &ray, double tMin, double tMax) const
+{
+    return FindAny(LocalRay(ray), tMin, tMax);
+}
+
+// Function to return the geometric normal of a triangle
+Vector3<double> RT::MeshGeometry::GetGeometricNormal(int triangle) const
+{
+    const uint32_t *corners = &m_indices[3 * static_cast<size_t>(triangle)];
+    const float *p0 = &m_positions[3 * static_cast<size_t>(corners[0])];
+    const float *p1 = &m_positions[3 * static_cast<size_t>(corners[1])];
+    const float *p2 = &m_positions[3 * static_cast<size_t>(corners[2])];
+    Vector3<double> edge1 {static_cast<double>(p1[0]) - p0[0], static_cast<double>(p1[1]) - p0[1], static_cast<double>(p1[2]) - p0[2]};
+    Vector3<double> edge2 {static_cast<double>(p2[0]) - p0[0], static_cast<double>(p2[1]) - p0[1], static_cast<double>(p2[2]) - p0[2]};
+    return Vector3<double>::cross(edge1, edge2);
+}
+
+// Function to return the shading normal at a hit
+Vector3<double> RT::MeshGeometry::GetShadingNormal(const Hit &hit) const
+{
+    if (m_normals.empty())
+        return GetGeometricNormal(hit.m_triangle);
+
+    const uint32_t *corners = &m_indices[3 * static_cast<size_t>(hit.m_triangle)];
+    const float *n0 = &m_normals[3 * static_cast<size_t>(corners[0])];
+    const float *n1 = &m_normals[3 * static_cast<size_t>(corners[1])];
+    const float *n2 = &m_normals[3 * static_cast<size_t>(corners[2])];
+    double w = 1.0 - hit.m_u - hit.m_v;
+    return Vector3<double>
+    {
+        (w * n0[0]) + (hit.m_u * n1[0]) + (hit.m_v * n2[0]),
+        (w * n0[1]) + (hit.m_u * n1[1]) + (hit.m_v * n2[1]),
+        (w * n0[2]) + (hit.m_u * n1[2]) + (hit.m_v * n2[2])
+    };
+}
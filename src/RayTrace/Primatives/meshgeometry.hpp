@@ -0,0 +1,143 @@
+#ifndef MESHGEOMETRY_H
+#define MESHGEOMETRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../../LinAlg/Vector3.hpp"
+#include "../ray.hpp"
+#include "../aabb.hpp"
+#include "../mappablearray.hpp"
+
+namespace RT
+{
+    /*
+        The triangles of a mesh and the BVH over them, in the mesh's own coordinates.
+        The vertices and triangles are kept in flat arrays, and rays are tested against
+        the triangles with a watertight kernel, so rays cannot slip through the shared
+        edges and vertices of neighbouring triangles.
+
+        The geometry has no transform. It is shared, read-only, by any number of ObjMesh
+        instances, each of which places it in the scene with its own transform, so the
+        memory used grows with the number of distinct meshes rather than with the
+        number of times they appear. The scene BVH over the instances is the top level
+        of a two-level structure, and this BVH is the bottom level.
+    */
+    class MeshGeometry
+    {
+        public:
+            /*
+                A node of the triangle BVH, with its bounds stored as floats (which is exact, since
+                the vertices are floats) so that a node is 32 bytes. Leaves have m_count > 0 and
+                reference m_count triangles starting at m_first, interior nodes have two children
+                at m_first and m_first + 1
+            */
+            struct Node
+            {
+                float m_min[3];
+                int32_t m_first;
+                float m_max[3];
+                int32_t m_count;
+            };
+
+            // A hit on a triangle, with the barycentric coordinates of its second and third corners
+            struct Hit
+            {
+                double m_t;
+                int m_triangle;
+                double m_u;
+                double m_v;
+            };
+
+            // The default constructor, which makes an empty mesh
+            MeshGeometry();
+
+            /*
+                Function to set the triangles, replacing any earlier ones, and build their BVH.
+                positions holds x, y, z for each vertex, indices holds the three vertex indices
+                of each triangle, and normals is either empty or holds a normal for each vertex.
+                Returns false, leaving the mesh unchanged, if an index or the number of normals is out of range
+            */
+            bool SetTriangles(std::vector<float> positions, std::vector<uint32_t> indices, std::vector<float> normals = {});
+
+            /*
+                Function to set the triangles together with a BVH that was built for them earlier,
+                as returned by the functions below, so that the BVH is not built again. The arrays
+                may be views of a mapped file, which are used in place. Returns false, leaving the
+                mesh unchanged, if the arrays or the nodes are inconsistent
+            */
+            bool Restore
+            (
+                RT::MappableArray<float> positions, RT::MappableArray<uint32_t> indices,
+                RT::MappableArray<float> normals, RT::MappableArray<Node> nodes
+            );
+
+            // Functions to return the size of the mesh
+            int GetNumVertices() const;
+            int GetNumTriangles() const;
+
+            // Functions to return the arrays of the mesh, with the triangles in BVH leaf order
+            const RT::MappableArray<float> &GetPositions() const;
+            const RT::MappableArray<float> &GetNormals() const;
+            const RT::MappableArray<uint32_t> &GetIndices() const;
+            const RT::MappableArray<Node> &GetNodes() const;
+
+            // Function to return the bounds of the mesh
+            const RT::AABB &GetBounds() const;
+
+            // Function to return the number of bytes used by the arrays, counting mapped ones at their size
+            size_t GetMemorySize() const;
+
+            // Function to find the closest triangle hit by a ray in the mesh's coordinates within (tMin, hit.m_t). Returns false if there is none
+            bool FindClosest(const RT::Ray &ray, double tMin, Hit &hit) const;
+
+            // Function to test whether a ray in the mesh's coordinates hits any triangle within (tMin, tMax)
+            bool FindAny(const RT::Ray &ray, double tMin, double tMax) const;
+
+            // Function to return the (unnormalised) normal of the plane of a triangle
+            Vector3<double> GetGeometricNormal(int triangle) const;
+
+            // Function to return the (unnormalised) normal at a hit, interpolated if the mesh has vertex normals
+            Vector3<double> GetShadingNormal(const Hit &hit) const;
+
+        private:
+            // A ray with the values that the traversal and the kernel need
+            struct LocalRay;
+
+            // A triangle's bounds and centroid, which the build sorts in place of the triangle
+            struct BuildTriangle;
+
+            // Function to test whether the arrays describe a valid mesh
+            static bool IsValid(const RT::MappableArray<float> &positions, const RT::MappableArray<uint32_t> &indices, const RT::MappableArray<float> &normals);
+
+            // Function to set the bounds from the root of the BVH
+            void UpdateBounds();
+
+            // Functions to build the BVH over the triangles
+            void BuildTree();
+            void BuildNode(int nodeIndex, std::vector<BuildTriangle> &triangles, int first, int count, int depth);
+
+            // Functions to traverse the BVH
+            bool FindClosest(const LocalRay &ray, double tMin, Hit &hit) const;
+            bool FindAny(const LocalRay &ray, double tMin, double tMax) const;
+
+            // Function to test a ray against one triangle, returning the ray parameter and barycentric coordinates
+            bool IntersectTriangle(const LocalRay &ray, int triangle, double tMin, double tMax, double &t, double &u, double &v) const;
+
+        private:
+            // x, y, z of each vertex, and optionally of each vertex normal
+            RT::MappableArray<float> m_positions;
+            RT::MappableArray<float> m_normals;
+
+            // Three vertex indices per triangle, reordered so that each leaf is a contiguous range
+            RT::MappableArray<uint32_t> m_indices;
+
+            // The BVH over the triangles, with the root at index 0
+            RT::MappableArray<Node> m_nodes;
+
+            // The bounds of the whole mesh
+            RT::AABB m_bounds;
+    };
+}
+
+#endif
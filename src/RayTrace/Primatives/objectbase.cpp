@@ -1,5 +1,6 @@
 #include "objectbase.hpp"
 #include <math.h>
+#include <limits>
 
 #define EPSILON 1e-21f;
 
@@ -16,17 +17,67 @@ RT::ObjectBase::~ObjectBase()
 }
 
 // Function to test for intersections
-bool RT::ObjectBase::TestIntersection(const Ray &castRay, Vector<double> &intPoint, Vector<double> &localNormal, Vector<double> &localColor)
+bool RT::ObjectBase::TestIntersection(const Ray &castRay, Vector3<double> &intPoint, Vector3<double> &localNormal, Vector3<double> &localColor)
 {
     return false;
 }
 
+// Function to test for occlusion. Derived classes should override this with a cheaper test
+bool RT::ObjectBase::Occluded(const Ray &castRay, double tMax)
+{
+    Vector3<double> intPoint;
+    Vector3<double> localNormal;
+    Vector3<double> localColor;
+    if (!TestIntersection(castRay, intPoint, localNormal, localColor))
+        return false;
+
+    // TestIntersection has already applied the ray's own interval
+    double t = (intPoint - castRay.m_point1).norm() / castRay.m_lab.norm();
+    return t < tMax;
+}
+
+// Function to test a packet of rays, one ray at a time
+void RT::ObjectBase::TestIntersectionPacket(const RT::RayPacket &packet, double *tHit)
+{
+    Vector3<double> intPoint;
+    Vector3<double> localNormal;
+    Vector3<double> localColor;
+    for (int lane = 0; lane < RT::RayPacket::MAX_SIZE; ++lane)
+    {
+        tHit[lane] = std::numeric_limits<double>::infinity();
+        if (lane >= packet.m_size)
+            continue;
+
+        RT::Ray castRay = packet.GetRay(lane);
+        if (TestIntersection(castRay, intPoint, localNormal, localColor))
+            tHit[lane] = (intPoint - castRay.m_point1).norm() / castRay.m_lab.norm();
+    }
+}
+
+// Function to return the local bounds. The base class has no geometry to bound
+RT::AABB RT::ObjectBase::GetLocalBounds() const
+{
+    return RT::AABB::Unbounded();
+}
+
 // Function to transform matrix
 void RT::ObjectBase::SetTransformMatrix(const RT::GTform &transformMatrix)
 {
     m_transformMatrix = transformMatrix;
 }
 
+// Function to return the kind of primitive
+RT::PrimitiveType RT::ObjectBase::GetPrimitiveType() const
+{
+    return RT::PrimitiveType::OTHER;
+}
+
+// Function to return whether a ray leaving the object can hit it again
+bool RT::ObjectBase::CanHitItself() const
+{
+    return false;
+}
+
 // Function to assign a material
 bool RT::ObjectBase::AssignMaterial(const std::shared_ptr<RT::MaterialBase> &objectMaterial)
 {
@@ -1,15 +1,36 @@
 #ifndef OBJECTBASE_H
 #define OBJECTBASE_H
 
-#include "../../LinAlg/Vector.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "../../LinAlg/Vector3.hpp"
 #include "../ray.hpp"
+#include "../raypacket.hpp"
 #include "../gtfm.hpp"
+#include "../aabb.hpp"
 
 namespace RT
 {
     // Forward-declare the material base class. This will be overriden later
 	class MaterialBase;
 
+    // The kinds of primitive, used to count intersection tests separately for each
+    enum class PrimitiveType
+    {
+        SPHERE,
+        PLANE,
+        MESH,
+        OTHER
+    };
+
+    constexpr int NUM_PRIMITIVE_TYPES = 4;
+
+    /*
+        An object as it is described to a scene: its primitive, transform, color and material.
+        A scene does not keep the object itself. It copies what it needs into its ObjectStore,
+        so changing an object after adding it to a scene has no effect on the scene
+    */
     class ObjectBase
     {
         public:
@@ -17,14 +38,42 @@ namespace RT
             ObjectBase();
             virtual ~ObjectBase();
 
-            // Function to test for intersections
-            virtual bool TestIntersection(const Ray &castRay, Vector<double> &intPoint, Vector<double> &localNormal, Vector<double> &localColor);
+            // Function to test for intersections within the ray's [m_tMin, m_tMax] interval
+            virtual bool TestIntersection(const Ray &castRay, Vector3<double> &intPoint, Vector3<double> &localNormal, Vector3<double> &localColor);
+
+            /*
+                Function to test whether the ray hits the object within the ray's [m_tMin, m_tMax]
+                interval and before the ray parameter tMax. Unlike TestIntersection this does not
+                compute the point of intersection, normal or color
+            */
+            virtual bool Occluded(const Ray &castRay, double tMax);
+
+            /*
+                Function to test every ray of a packet for an intersection. For each ray, writes the
+                ray parameter of the hit within the ray's interval to tHit[lane], or infinity if the
+                ray misses. tHit must have room for RayPacket::MAX_SIZE values. The base class tests
+                one ray at a time, derived classes can override it with a packet kernel
+            */
+            virtual void TestIntersectionPacket(const RT::RayPacket &packet, double *tHit);
+
+            // Function to return the bounds of the object in its own (untransformed) coordinates
+            virtual RT::AABB GetLocalBounds() const;
+
+            // Function to return the kind of primitive
+            virtual RT::PrimitiveType GetPrimitiveType() const;
+
+            /*
+                Function to return whether a ray leaving the surface of the object can hit the object
+                again. Convex objects cannot, so their reflection rays simply skip them. Objects that
+                can, such as meshes, have to be intersected by their own reflections
+            */
+            virtual bool CanHitItself() const;
 
-            // Function to transform matrix
+            // Function to set the transform matrix
             void SetTransformMatrix(const RT::GTform &transformMatrix);
 
             // Function to test whether two floating-point numbers are close to being equal
-            bool CloseEnough(const double f1, const double f2);
+            static bool CloseEnough(const double f1, const double f2);
 
             // Function to assign a material
             bool AssignMaterial(const std::shared_ptr<RT::MaterialBase> &objectMaterial);
@@ -32,7 +81,7 @@ namespace RT
         // Public member variables
         public:
             // The base colour of the object
-            Vector<double> m_baseColor {3};
+            Vector3<double> m_baseColor;
 
             // The geometric translation applied to the object
             RT::GTform m_transformMatrix;
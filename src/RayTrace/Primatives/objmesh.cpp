@@ -0,0 +1,147 @@
+#include "objmesh.hpp"
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+// The default constructor
+RT::ObjMesh::ObjMesh()
+    : m_pGeometry(std::make_shared<RT::MeshGeometry> ())
+{
+
+}
+
+// Construct an instance of existing geometry
+RT::ObjMesh::ObjMesh(std::shared_ptr<const RT::MeshGeometry> pGeometry)
+    : m_pGeometry(pGeometry ? std::move(pGeometry) : std::make_shared<RT::MeshGeometry> ())
+{
+
+}
+
+// The destructor
+RT::ObjMesh::~ObjMesh()
+{
+
+}
+
+// Function to set the geometry
+void RT::ObjMesh::SetGeometry(std::shared_ptr<const RT::MeshGeometry> pGeometry)
+{
+    m_pGeometry = pGeometry ? std::move(pGeometry) : std::make_shared<RT::MeshGeometry> ();
+}
+
+// Function to return the geometry
+const std::shared_ptr<const RT::MeshGeometry> &RT::ObjMesh::GetGeometry() const
+{
+    return m_pGeometry;
+}
+
+// Function to give this instance new geometry
+bool RT::ObjMesh::SetTriangles(std::vector<float> positions, std::vector<uint32_t> indices, std::vector<float> normals)
+{
+    auto pGeometry = std::make_shared<RT::MeshGeometry> ();
+    if (!pGeometry -> SetTriangles(std::move(positions), std::move(indices), std::move(normals)))
+        return false;
+
+    SetGeometry(std::move(pGeometry));
+    return true;
+}
+
+// Functions to return the size of the mesh
+int RT::ObjMesh::GetNumVertices() const
+{
+    return m_pGeometry -> GetNumVertices();
+}
+
+int RT::ObjMesh::GetNumTriangles() const
+{
+    return m_pGeometry -> GetNumTriangles();
+}
+
+// Function to test for intersections
+bool RT::ObjMesh::TestIntersection
+(
+    const RT::Ray &castRay, Vector3<double> &intPoint,
+    Vector3<double> &localNormal, Vector3<double> &localColor
+) {
+    if (!Intersect(m_transformMatrix.GetAffine(RT::BCKTFORM), *m_pGeometry, castRay, intPoint, localNormal))
+        return false;
+
+    localColor = m_baseColor;
+    return true;
+}
+
+// Function to test for occlusion
+bool RT::ObjMesh::Occluded(const RT::Ray &castRay, double tMax)
+{
+    return Occludes(m_transformMatrix.GetAffine(RT::BCKTFORM), *m_pGeometry, castRay, tMax);
+}
+
+// Function to test a packet of rays
+void RT::ObjMesh::TestIntersectionPacket(const RT::RayPacket &packet, double *tHit)
+{
+    IntersectPacket(m_transformMatrix.GetAffine(RT::BCKTFORM), *m_pGeometry, packet, tHit);
+}
+
+// Function to return the local bounds of the triangles
+RT::AABB RT::ObjMesh::GetLocalBounds() const
+{
+    return m_pGeometry -> GetBounds();
+}
+
+// Function to return the kind of primitive
+RT::PrimitiveType RT::ObjMesh::GetPrimitiveType() const
+{
+    return RT::PrimitiveType::MESH;
+}
+
+// Function to return whether a ray leaving the mesh can hit it again
+bool RT::ObjMesh::CanHitItself() const
+{
+    return true;
+}
+
+// Function to test a ray against geometry placed by bckTfm
+bool RT::ObjMesh::Intersect
+(
+    const RT::AffineMatrix &bckTfm, const RT::MeshGeometry &geometry, const RT::Ray &castRay,
+    Vector3<double> &intPoint, Vector3<double> &localNormal
+) {
+    // The ray parameter is the same in local and world coordinates, so the ray's interval carries over
+    RT::MeshGeometry::Hit hit {castRay.m_tMax, -1, 0.0, 0.0};
+    if (!geometry.FindClosest(bckTfm.TransformRay(castRay), std::max(castRay.m_tMin, 0.0), hit))
+        return false;
+
+    intPoint = castRay.m_point1 + (hit.m_t * castRay.m_lab);
+
+    // Normals are transformed by the transpose of the backward transform. The triangles are
+    // two-sided, so the normal is flipped to face the ray when it hits the back
+    Vector3<double> geometricNormal = bckTfm.TransformTransposed(geometry.GetGeometricNormal(hit.m_triangle));
+    bool backFace = Vector3<double>::dot(geometricNormal, castRay.m_lab) > 0.0;
+
+    Vector3<double> worldNormal = bckTfm.TransformTransposed(geometry.GetShadingNormal(hit));
+    worldNormal.Normalize();
+    localNormal = backFace ? (-1.0 * worldNormal) : worldNormal;
+    return true;
+}
+
+// Function to test whether a ray is blocked by geometry placed by bckTfm
+bool RT::ObjMesh::Occludes(const RT::AffineMatrix &bckTfm, const RT::MeshGeometry &geometry, const RT::Ray &castRay, double tMax)
+{
+    return geometry.FindAny(bckTfm.TransformRay(castRay), std::max(castRay.m_tMin, 0.0), std::min(castRay.m_tMax, tMax));
+}
+
+// Function to test a packet of rays, one ray at a time through the triangle BVH
+void RT::ObjMesh::IntersectPacket(const RT::AffineMatrix &bckTfm, const RT::MeshGeometry &geometry, const RT::RayPacket &packet, double *tHit)
+{
+    for (int lane = 0; lane < RT::RayPacket::MAX_SIZE; ++lane)
+    {
+        tHit[lane] = std::numeric_limits<double>::infinity();
+        if (lane >= packet.m_size)
+            continue;
+
+        RT::Ray castRay = packet.GetRay(lane);
+        RT::MeshGeometry::Hit hit {castRay.m_tMax, -1, 0.0, 0.0};
+        if (geometry.FindClosest(bckTfm.TransformRay(castRay), std::max(castRay.m_tMin, 0.0), hit))
+            tHit[lane] = hit.m_t;
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef OBJMESH_H
+#define OBJMESH_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "objectbase.hpp"
+#include "meshgeometry.hpp"
+#include "../gtfm.hpp"
+
+namespace RT
+{
+    /*
+        An instance of a triangle mesh. The triangles and their BVH are a MeshGeometry,
+        which may be shared by any number of ObjMesh objects, and each instance places
+        it in the scene with its own transform. A ray is transformed into the mesh's
+        coordinates once per instance and then traverses the shared BVH, so a mesh of
+        any size is a single object to the scene.
+
+        The triangles are two-sided. If the mesh has vertex normals they are interpolated
+        across each triangle, otherwise each triangle is flat. Unlike the convex objects, a
+        mesh is not excluded from the reflection rays that leave it, so that it can reflect
+        itself.
+    */
+    class ObjMesh : public ObjectBase
+    {
+        public:
+            // The default constructor, which makes an empty mesh
+            ObjMesh();
+
+            // Construct an instance of existing geometry
+            explicit ObjMesh(std::shared_ptr<const RT::MeshGeometry> pGeometry);
+
+            // Override the destructor
+            virtual ~ObjMesh() override;
+
+            // Function to set the geometry, which may be shared with other instances
+            void SetGeometry(std::shared_ptr<const RT::MeshGeometry> pGeometry);
+
+            // Function to return the geometry
+            const std::shared_ptr<const RT::MeshGeometry> &GetGeometry() const;
+
+            /*
+                Function to give this instance new geometry of its own, made from the triangles as
+                for MeshGeometry::SetTriangles. Returns false, leaving the mesh unchanged, if the
+                triangles are invalid
+            */
+            bool SetTriangles(std::vector<float> positions, std::vector<uint32_t> indices, std::vector<float> normals = {});
+
+            // Functions to return the size of the mesh
+            int GetNumVertices() const;
+            int GetNumTriangles() const;
+
+            // Override the function to test for intersections
+            virtual bool TestIntersection
+            (
+                const RT::Ray &castRay, Vector3<double> &intPoint,
+                Vector3<double> &localNormal, Vector3<double> &localColor
+            ) override;
+
+            // Override the function to test for occlusion
+            virtual bool Occluded(const RT::Ray &castRay, double tMax) override;
+
+            // Override the function to test a packet of rays, finding only the distance of each hit
+            virtual void TestIntersectionPacket(const RT::RayPacket &packet, double *tHit) override;
+
+            // Override the function to return the local bounds
+            virtual RT::AABB GetLocalBounds() const override;
+
+            // Override the function to return the kind of primitive
+            virtual RT::PrimitiveType GetPrimitiveType() const override;
+
+            // Override the function to say that a mesh, which need not be convex, can reflect itself
+            virtual bool CanHitItself() const override;
+
+            /*
+                Functions to test geometry placed by the backward transform bckTfm. These need
+                nothing else from the object, so that the ObjectStore can call them with its own arrays
+            */
+            static bool Intersect
+            (
+                const RT::AffineMatrix &bckTfm, const RT::MeshGeometry &geometry, const RT::Ray &castRay,
+                Vector3<double> &intPoint, Vector3<double> &localNormal
+            );
+            static bool Occludes(const RT::AffineMatrix &bckTfm, const RT::MeshGeometry &geometry, const RT::Ray &castRay, double tMax);
+            static void IntersectPacket(const RT::AffineMatrix &bckTfm, const RT::MeshGeometry &geometry, const RT::RayPacket &packet, double *tHit);
+
+        private:
+            std::shared_ptr<const RT::MeshGeometry> m_pGeometry;
+    };
+}
+
+#endif
@@ -1,5 +1,6 @@
 #include "objplane.hpp"
 #include <cmath>
+#include "../packetkernels.hpp"
 
 // The default constructor
 RT::ObjPlane::ObjPlane()
@@ -16,14 +17,53 @@ RT::ObjPlane::~ObjPlane()
 // Function to test for intersections
 bool RT::ObjPlane::TestIntersection
 (
-    const RT::Ray &castRay, Vector<double> &intPoint,
-    Vector<double> &localNormal, Vector<double> &localColor
+    const RT::Ray &castRay, Vector3<double> &intPoint,
+    Vector3<double> &localNormal, Vector3<double> &localColor
+) {
+	if (!Intersect(m_transformMatrix.GetAffine(RT::BCKTFORM), castRay, intPoint, localNormal))
+		return false;
+	
+	// Return the base color
+	localColor = m_baseColor;
+	return true;
+}
+
+// Function to test for occlusion
+bool RT::ObjPlane::Occluded(const RT::Ray &castRay, double tMax)
+{
+	return Occludes(m_transformMatrix.GetAffine(RT::BCKTFORM), castRay, tMax);
+}
+
+// Function to test a packet of rays
+void RT::ObjPlane::TestIntersectionPacket(const RT::RayPacket &packet, double *tHit)
+{
+    RT::PacketKernels::IntersectPlane(m_transformMatrix.GetAffine(RT::BCKTFORM), packet, tHit);
+}
+
+// Function to return the local bounds
+RT::AABB RT::ObjPlane::GetLocalBounds() const
+{
+    return UnitBounds();
+}
+
+// Function to return the kind of primitive
+RT::PrimitiveType RT::ObjPlane::GetPrimitiveType() const
+{
+    return RT::PrimitiveType::PLANE;
+}
+
+// Function to test a ray against a unit square placed by bckTfm
+bool RT::ObjPlane::Intersect
+(
+    const RT::AffineMatrix &bckTfm, const RT::Ray &castRay,
+    Vector3<double> &intPoint, Vector3<double> &localNormal
 ) {
     // Copy the ray and apply the backwards transform
-	RT::Ray bckRay = m_transformMatrix.Apply(castRay, RT::BCKTFORM);
+	RT::Ray bckRay = bckTfm.TransformRay(castRay);
 	
 	// Copy the m_lab vector from bckRay and normalize it
-	Vector<double> k = bckRay.m_lab;
+	double labLength = bckRay.m_lab.norm();
+	Vector3<double> k = bckRay.m_lab;
 	k.Normalize();
 	
 	// Check if there is an intersection, ie. if the castRay is not parallel to the plane
@@ -32,8 +72,14 @@ bool RT::ObjPlane::TestIntersection
 		// There is an intersection.
 		double t = bckRay.m_point1.GetElement(2) / -k.GetElement(2);
 		
-		// If t is negative, then the intersection point must be behind the camera and we can ignore it
-		if (t > 0.0)
+		// Convert t to the ray parameter, which is the same in local and world coordinates
+		double tRay = t / labLength;
+		
+		/*
+			If t is negative, then the intersection point must be behind the camera and we can ignore it.
+			The same goes for intersections outside of the ray's interval
+		*/
+		if ((t > 0.0) && (tRay >= castRay.m_tMin) && (tRay <= castRay.m_tMax))
 		{
 			// Compute the values for u and v
 			double u = bckRay.m_point1.GetElement(0) + (k.GetElement(0) * t);
@@ -42,22 +88,13 @@ bool RT::ObjPlane::TestIntersection
 			// If the magnitude of both u and v is less than or equal to one then we must be in the plane
 			if ((abs(u) < 1.0) && (abs(v) < 1.0))
 			{
-				// Compute the point of intersection.
-				Vector<double> poi = bckRay.m_point1 + t * k;
-				
-				// Transform the intersection point back into world coordinates
-				intPoint = m_transformMatrix.Apply(poi, RT::FWDTFORM);
+				// Compute the point of intersection in world coordinates, where the ray parameter is the same
+				intPoint = castRay.m_point1 + (tRay * castRay.m_lab);
 				
-				// Compute the local normal
-				Vector<double> localOrigin {std::vector<double> {0.0, 0.0, 0.0}};
-				Vector<double> normalVector {std::vector<double> {0.0, 0.0, -1.0}};
-				Vector<double> globalOrigin = m_transformMatrix.Apply(localOrigin, RT::FWDTFORM);
-				localNormal = m_transformMatrix.Apply(normalVector, RT::FWDTFORM) - globalOrigin;
+				// The normal is the same everywhere on the plane, and is transformed by the transpose of the backward transform
+				localNormal = bckTfm.TransformTransposed(Vector3<double>{0.0, 0.0, -1.0});
 				localNormal.Normalize();
 				
-				// Return the base color
-				localColor = m_baseColor;
-				
 				return true;
 			}
 			else
@@ -72,4 +109,41 @@ bool RT::ObjPlane::TestIntersection
 	}
 	
 	return false;
-}
\ No newline at end of file
+}
+
+// Function to test whether a ray is blocked by a unit square placed by bckTfm
+bool RT::ObjPlane::Occludes(const RT::AffineMatrix &bckTfm, const RT::Ray &castRay, double tMax)
+{
+    // Copy the ray and apply the backwards transform
+	RT::Ray bckRay = bckTfm.TransformRay(castRay);
+	
+	double labLength = bckRay.m_lab.norm();
+	Vector3<double> k = bckRay.m_lab * (1.0 / labLength);
+	
+	// A ray parallel to the plane cannot hit it
+	if (CloseEnough(k.GetElement(2), 0.0))
+		return false;
+	
+	double t = bckRay.m_point1.GetElement(2) / -k.GetElement(2);
+	if (t <= 0.0)
+		return false;
+	
+	// Check that the point lies within the bounds of the plane
+	double u = bckRay.m_point1.GetElement(0) + (k.GetElement(0) * t);
+	double v = bckRay.m_point1.GetElement(1) + (k.GetElement(1) * t);
+	if ((std::abs(u) >= 1.0) || (std::abs(v) >= 1.0))
+		return false;
+	
+	// Convert the distance along the normalized local direction to the ray parameter
+	double tRay = t / labLength;
+	return (tRay >= castRay.m_tMin) && (tRay <= castRay.m_tMax) && (tRay < tMax);
+}
+
+// Function to return the bounds of a unit square in the x-y plane
+RT::AABB RT::ObjPlane::UnitBounds()
+{
+    RT::AABB bounds;
+    bounds.m_min = Vector3<double>{-1.0, -1.0, 0.0};
+    bounds.m_max = Vector3<double>{1.0, 1.0, 0.0};
+    return bounds;
+}
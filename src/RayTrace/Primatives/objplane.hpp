@@ -18,12 +18,36 @@ namespace RT
             // Override the function to test for intersections
             virtual bool TestIntersection
             (
-                const RT::Ray &castRay, Vector<double> &intPoint,
-                Vector<double> &localNormal, Vector<double> &localColor
+                const RT::Ray &castRay, Vector3<double> &intPoint,
+                Vector3<double> &localNormal, Vector3<double> &localColor
             ) override;
-        
-        private:
-            
+
+            // Override the function to test for occlusion
+            virtual bool Occluded(const RT::Ray &castRay, double tMax) override;
+
+            // Override the function to test a packet of rays, using the SIMD kernel
+            virtual void TestIntersectionPacket(const RT::RayPacket &packet, double *tHit) override;
+
+            // Override the function to return the local bounds
+            virtual RT::AABB GetLocalBounds() const override;
+
+            // Override the function to return the kind of primitive
+            virtual RT::PrimitiveType GetPrimitiveType() const override;
+
+            /*
+                Functions to test a unit square in the x-y plane placed by the backward transform
+                bckTfm. These need nothing else from the object, so that the ObjectStore can call
+                them with its own arrays
+            */
+            static bool Intersect
+            (
+                const RT::AffineMatrix &bckTfm, const RT::Ray &castRay,
+                Vector3<double> &intPoint, Vector3<double> &localNormal
+            );
+            static bool Occludes(const RT::AffineMatrix &bckTfm, const RT::Ray &castRay, double tMax);
+
+            // Function to return the bounds of a unit square in the x-y plane
+            static RT::AABB UnitBounds();
     };
 }
 
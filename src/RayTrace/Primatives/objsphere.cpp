@@ -1,5 +1,6 @@
 #include "objsphere.hpp"
 #include <cmath>
+#include "../packetkernels.hpp"
 
 // The default constructor
 RT::ObjSphere::ObjSphere()
@@ -13,17 +14,76 @@ RT::ObjSphere::~ObjSphere()
 
 }
 
+/*
+    Function to choose the first of the two roots (tNear <= tFar, as distances along the normalized
+    local direction) whose ray parameter is in [tMin, tMax]. Returns false if neither is
+*/
+bool RT::ObjSphere::SelectRoot(double tNear, double tFar, double labLength, double tMin, double tMax, double &tRoot, double &tRay)
+{
+    tRoot = tNear;
+    tRay = tNear / labLength;
+    if (tRay < tMin)
+    {
+        tRoot = tFar;
+        tRay = tFar / labLength;
+    }
+
+    return (tRay >= tMin) && (tRay <= tMax);
+}
+
 // Function to test for intersections
 bool RT::ObjSphere::TestIntersection
 (
-    const RT::Ray &castRay, Vector<double> &intPoint,
-    Vector<double> &localNormal, Vector<double> &localColor
+    const RT::Ray &castRay, Vector3<double> &intPoint,
+    Vector3<double> &localNormal, Vector3<double> &localColor
+) {
+    // The centre is the translation column of the forward transform
+    const RT::AffineMatrix &fwdtfm = m_transformMatrix.GetAffine(RT::FWDTFORM);
+    Vector3<double> centre {fwdtfm.m[0][3], fwdtfm.m[1][3], fwdtfm.m[2][3]};
+    if (!Intersect(m_transformMatrix.GetAffine(RT::BCKTFORM), centre, castRay, intPoint, localNormal))
+        return false;
+
+    // Return the base color
+    localColor = m_baseColor;
+    return true;
+}
+
+// Function to test for occlusion
+bool RT::ObjSphere::Occluded(const RT::Ray &castRay, double tMax)
+{
+    return Occludes(m_transformMatrix.GetAffine(RT::BCKTFORM), castRay, tMax);
+}
+
+// Function to test a packet of rays
+void RT::ObjSphere::TestIntersectionPacket(const RT::RayPacket &packet, double *tHit)
+{
+    RT::PacketKernels::IntersectSphere(m_transformMatrix.GetAffine(RT::BCKTFORM), packet, tHit);
+}
+
+// Function to return the local bounds
+RT::AABB RT::ObjSphere::GetLocalBounds() const
+{
+    return UnitBounds();
+}
+
+// Function to return the kind of primitive
+RT::PrimitiveType RT::ObjSphere::GetPrimitiveType() const
+{
+    return RT::PrimitiveType::SPHERE;
+}
+
+// Function to test a ray against a unit sphere placed by bckTfm
+bool RT::ObjSphere::Intersect
+(
+    const RT::AffineMatrix &bckTfm, const Vector3<double> &centre, const RT::Ray &castRay,
+    Vector3<double> &intPoint, Vector3<double> &localNormal
 ) {
     // Copy the ray and apply the backward transform
-    RT::Ray bckRay = m_transformMatrix.Apply(castRay, RT::BCKTFORM);
+    RT::Ray bckRay = bckTfm.TransformRay(castRay);
 
     // Compute the values of a, b and c
-    Vector<double> vhat = bckRay.m_lab;
+    double labLength = bckRay.m_lab.norm();
+    Vector3<double> vhat = bckRay.m_lab;
     vhat.Normalize();
 
     /*
@@ -34,15 +94,14 @@ bool RT::ObjSphere::TestIntersection
     // a = 1.0;
 
     // Calculate b
-    double b = 2.0 * Vector<double>::dot(bckRay.m_point1, vhat);
+    double b = 2.0 * Vector3<double>::dot(bckRay.m_point1, vhat);
 
     // Calculate c
-    double c = Vector<double>::dot(bckRay.m_point1, bckRay.m_point1) - 1.0;
+    double c = Vector3<double>::dot(bckRay.m_point1, bckRay.m_point1) - 1.0;
 
     // Test whether we actually have an intersection
     double intTest = (b * b) - 4.0 * c;
 
-    Vector<double> poi;
     if (intTest > 0.0)
     {
         double numSQRT = sqrtf(intTest);
@@ -50,36 +109,26 @@ bool RT::ObjSphere::TestIntersection
 		double t2 = (-b - numSQRT) / 2.0;
 		
 		/*
-        If either t1 or t2 are negative, then at least part of the object is
-			behind the camera and so we will ignore it
-        */
-		if ((t1 < 0.0) || (t2 < 0.0))
+			The roots are distances along the normalized local direction, with t2 <= t1.
+			Dividing by the local length of m_lab gives the ray parameter, which is the
+			same in local and world coordinates. The hit is the nearer root if it is in
+			the ray's interval, otherwise the further one (eg. when the interval starts
+			inside the sphere)
+		*/
+		double tNear = 0.0;
+		double tRay = 0.0;
+		if (!SelectRoot(t2, t1, labLength, castRay.m_tMin, castRay.m_tMax, tNear, tRay))
 		{
 			return false;
 		}
 		else
 		{
-			// Determine which point of intersection was closest to the camera
-			if (t1 < t2)
-			{
-				poi = bckRay.m_point1 + (vhat * t1);
-			}
-			else
-			{
-				poi = bckRay.m_point1 + (vhat * t2);
-			}
-
-            // Transform the intersection point back into world coordinates
-            intPoint = m_transformMatrix.Apply(poi, RT::FWDTFORM);
-
-            // Compute the local normal (easy for a sphere at the origin)
-            Vector<double> objOrigin = Vector<double>{std::vector<double>{0.0, 0.0, 0.0}};
-            Vector<double> newObjOrigin = m_transformMatrix.Apply(objOrigin, RT::FWDTFORM);
-            localNormal = intPoint - newObjOrigin;
-            localNormal.Normalize();
+            // The ray parameter is the same in world coordinates, so the point can be found there directly
+            intPoint = castRay.m_point1 + (tRay * castRay.m_lab);
 
-            // Return the base color
-            localColor = m_baseColor;
+            // Compute the local normal (easy for a sphere)
+            localNormal = intPoint - centre;
+            localNormal.Normalize();
 		}
 		
 		return true;
@@ -88,4 +137,37 @@ bool RT::ObjSphere::TestIntersection
     {
         return false;
     }
-}
\ No newline at end of file
+}
+
+// Function to test whether a ray is blocked by a unit sphere placed by bckTfm
+bool RT::ObjSphere::Occludes(const RT::AffineMatrix &bckTfm, const RT::Ray &castRay, double tMax)
+{
+    // Copy the ray and apply the backward transform
+    RT::Ray bckRay = bckTfm.TransformRay(castRay);
+
+    // Compute b and c exactly as in Intersect
+    double labLength = bckRay.m_lab.norm();
+    Vector3<double> vhat = bckRay.m_lab * (1.0 / labLength);
+    double b = 2.0 * Vector3<double>::dot(bckRay.m_point1, vhat);
+    double c = Vector3<double>::dot(bckRay.m_point1, bckRay.m_point1) - 1.0;
+    double intTest = (b * b) - 4.0 * c;
+    if (intTest <= 0.0)
+        return false;
+
+    double numSQRT = sqrtf(intTest);
+    double t1 = (-b + numSQRT) / 2.0;
+    double t2 = (-b - numSQRT) / 2.0;
+
+    // Take the first root in the ray's interval, as Intersect does
+    double tRoot, tRay;
+    return SelectRoot(t2, t1, labLength, castRay.m_tMin, castRay.m_tMax, tRoot, tRay) && (tRay < tMax);
+}
+
+// Function to return the bounds of a unit sphere at the origin
+RT::AABB RT::ObjSphere::UnitBounds()
+{
+    RT::AABB bounds;
+    bounds.m_min = Vector3<double>{-1.0, -1.0, -1.0};
+    bounds.m_max = Vector3<double>{1.0, 1.0, 1.0};
+    return bounds;
+}
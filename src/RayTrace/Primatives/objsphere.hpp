@@ -21,12 +21,40 @@ namespace RT
             // Override the function to test for intersections
             virtual bool TestIntersection
             (
-                const RT::Ray &castRay, Vector<double> &intPoint,
-                Vector<double> &localNormal, Vector<double> &localColor
+                const RT::Ray &castRay, Vector3<double> &intPoint,
+                Vector3<double> &localNormal, Vector3<double> &localColor
             ) override;
+
+            // Override the function to test for occlusion
+            virtual bool Occluded(const RT::Ray &castRay, double tMax) override;
+
+            // Override the function to test a packet of rays, using the SIMD kernel
+            virtual void TestIntersectionPacket(const RT::RayPacket &packet, double *tHit) override;
+
+            // Override the function to return the local bounds
+            virtual RT::AABB GetLocalBounds() const override;
+
+            // Override the function to return the kind of primitive
+            virtual RT::PrimitiveType GetPrimitiveType() const override;
+
+            /*
+                Functions to test a unit sphere placed by the backward transform bckTfm, with its
+                centre in world coordinates. These need nothing else from the object, so that the
+                ObjectStore can call them with its own arrays
+            */
+            static bool Intersect
+            (
+                const RT::AffineMatrix &bckTfm, const Vector3<double> &centre, const RT::Ray &castRay,
+                Vector3<double> &intPoint, Vector3<double> &localNormal
+            );
+            static bool Occludes(const RT::AffineMatrix &bckTfm, const RT::Ray &castRay, double tMax);
+
+            // Function to return the bounds of a unit sphere at the origin
+            static RT::AABB UnitBounds();
         
         private:
-            
+            // Function to choose the first root of the ray-sphere equation in the ray's interval
+            static bool SelectRoot(double tNear, double tFar, double labLength, double tMin, double tMax, double &tRoot, double &tRay);
     };
 }
 
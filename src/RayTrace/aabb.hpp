@@ -0,0 +1,110 @@
+#ifndef AABB_H
+#define AABB_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "../LinAlg/Vector3.hpp"
+
+namespace RT
+{
+    // An axis-aligned bounding box
+    struct AABB
+    {
+        Vector3<double> m_min { std::numeric_limits<double>::max(),  std::numeric_limits<double>::max(),  std::numeric_limits<double>::max()};
+        Vector3<double> m_max {-std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max()};
+
+        // Function to return a box that contains everything (for objects with no finite bounds)
+        static AABB Unbounded()
+        {
+            const double inf = std::numeric_limits<double>::infinity();
+            AABB box;
+            box.m_min = Vector3<double>{-inf, -inf, -inf};
+            box.m_max = Vector3<double>{ inf,  inf,  inf};
+            return box;
+        }
+
+        // Function to test whether the box is finite
+        bool IsBounded() const
+        {
+            return std::isfinite(m_min.m_x) && std::isfinite(m_min.m_y) && std::isfinite(m_min.m_z) &&
+                   std::isfinite(m_max.m_x) && std::isfinite(m_max.m_y) && std::isfinite(m_max.m_z);
+        }
+
+        // Function to test whether the box contains anything at all
+        bool IsEmpty() const
+        {
+            return (m_min.m_x > m_max.m_x) || (m_min.m_y > m_max.m_y) || (m_min.m_z > m_max.m_z);
+        }
+
+        // Functions to grow the box to include a point or another box
+        void Grow(const Vector3<double> &point)
+        {
+            m_min.m_x = std::min(m_min.m_x, point.m_x);
+            m_min.m_y = std::min(m_min.m_y, point.m_y);
+            m_min.m_z = std::min(m_min.m_z, point.m_z);
+            m_max.m_x = std::max(m_max.m_x, point.m_x);
+            m_max.m_y = std::max(m_max.m_y, point.m_y);
+            m_max.m_z = std::max(m_max.m_z, point.m_z);
+        }
+
+        void Grow(const AABB &box)
+        {
+            if (box.IsEmpty())
+                return;
+
+            Grow(box.m_min);
+            Grow(box.m_max);
+        }
+
+        // Function to return the centre of the box
+        Vector3<double> Centroid() const
+        {
+            return (m_min + m_max) * 0.5;
+        }
+
+        // Function to return the surface area of the box (zero if empty)
+        double SurfaceArea() const
+        {
+            if (IsEmpty())
+                return 0.0;
+
+            Vector3<double> extent = m_max - m_min;
+            return 2.0 * ((extent.m_x * extent.m_y) + (extent.m_y * extent.m_z) + (extent.m_z * extent.m_x));
+        }
+
+        /*
+            Function to test a ray against the box using the slab method. The ray is given
+            as an origin and the reciprocal of its direction. On success tEntry holds the
+            ray parameter at which the ray enters the box (clamped to tMin).
+        */
+        bool IntersectRay
+        (
+            const Vector3<double> &origin, const Vector3<double> &invDir,
+            double tMin, double tMax, double &tEntry
+        ) const
+        {
+            double tx1 = (m_min.m_x - origin.m_x) * invDir.m_x;
+            double tx2 = (m_max.m_x - origin.m_x) * invDir.m_x;
+            double tNear = std::min(tx1, tx2);
+            double tFar = std::max(tx1, tx2);
+
+            double ty1 = (m_min.m_y - origin.m_y) * invDir.m_y;
+            double ty2 = (m_max.m_y - origin.m_y) * invDir.m_y;
+            tNear = std::max(tNear, std::min(ty1, ty2));
+            tFar = std::min(tFar, std::max(ty1, ty2));
+
+            double tz1 = (m_min.m_z - origin.m_z) * invDir.m_z;
+            double tz2 = (m_max.m_z - origin.m_z) * invDir.m_z;
+            tNear = std::max(tNear, std::min(tz1, tz2));
+            tFar = std::min(tFar, std::max(tz1, tz2));
+
+            tNear = std::max(tNear, tMin);
+            tFar = std::min(tFar, tMax);
+            tEntry = tNear;
+            return tNear <= tFar;
+        }
+    };
+}
+
+#endif
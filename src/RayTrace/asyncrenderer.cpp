@@ -0,0 +1,117 @@
+#include "asyncrenderer.hpp"
+#include "tracer.hpp"
+#include <limits>
+
+// The constructor
+RT::AsyncRenderer::AsyncRenderer(RT::Scene &scene) : m_scene(scene)
+{
+
+}
+
+// The destructor
+RT::AsyncRenderer::~AsyncRenderer()
+{
+    Cancel();
+}
+
+// Function to start a new frame
+void RT::AsyncRenderer::StartFrame(int xSize, int ySize)
+{
+    Cancel();
+
+    if ((xSize != m_backImage.GetXSize()) || (ySize != m_backImage.GetYSize()))
+        m_backImage.Initialize(xSize, ySize, NULL);
+
+    // Nothing else is using the slots at this point, so they can all be made free again
+    int tileSize = RT::Scene::PROGRESSIVE_TILE_SIZE;
+    int numSlots = ((xSize + tileSize - 1) / tileSize) * ((ySize + tileSize - 1) / tileSize);
+    if (m_slotData.size() < static_cast<size_t>(numSlots) * SLOT_VALUES)
+        m_slotData.resize(static_cast<size_t>(numSlots) * SLOT_VALUES);
+
+    m_pFreeSlots = std::make_unique<RT::BoundedQueue<int>> (numSlots);
+    m_pPublishedTiles = std::make_unique<RT::BoundedQueue<PublishedTile>> (numSlots);
+    for (int slot = 0; slot < numSlots; ++slot)
+        m_pFreeSlots -> TryPush(slot);
+
+    m_cancel.Reset();
+    m_tilesPushed.store(0, std::memory_order_relaxed);
+    m_tilesPublished = 0;
+    m_renderFinished.store(false, std::memory_order_release);
+    m_scene.StartProgressive(m_backImage);
+    m_renderThread = std::thread(&RT::AsyncRenderer::RenderFrame, this);
+}
+
+// Function to cancel the frame in progress
+void RT::AsyncRenderer::Cancel()
+{
+    m_cancel.Cancel();
+    if (m_renderThread.joinable())
+        m_renderThread.join();
+}
+
+// The function run by the render thread
+void RT::AsyncRenderer::RenderFrame()
+{
+    RT::Tracer::SetThreadName("render");
+    m_scene.RenderProgressive
+    (
+        m_backImage, std::numeric_limits<double>::infinity(), &m_cancel,
+        [this](const RT::TileRect &tile) { PublishTile(tile); }
+    );
+
+    m_renderFinished.store(true, std::memory_order_release);
+}
+
+// Function called by a render thread when it has finished a tile
+void RT::AsyncRenderer::PublishTile(const RT::TileRect &tile)
+{
+    // Every slot is waiting to be displayed, so wait for the displaying thread to catch up
+    PublishedTile published;
+    while (!m_pFreeSlots -> TryPop(published.m_slot))
+    {
+        if (m_cancel.IsCancelled())
+            return;
+        std::this_thread::yield();
+    }
+
+    // The next pass will overwrite this tile of the back image, so publish a copy
+    published.m_rect = tile;
+    m_backImage.ReadTile(tile.m_x0, tile.m_y0, tile.m_x1 - tile.m_x0, tile.m_y1 - tile.m_y0, &m_slotData[published.m_slot * SLOT_VALUES]);
+
+    // There is always room, as there are no more published tiles than slots
+    m_pPublishedTiles -> TryPush(published);
+    m_tilesPushed.fetch_add(1, std::memory_order_release);
+}
+
+// Function to copy the published tiles into the displayed image
+int RT::AsyncRenderer::PublishTiles(Image &displayImage)
+{
+    if (!m_pPublishedTiles)
+        return 0;
+
+    RT::TraceScope publishScope("publish tiles");
+
+    // Popping a tile makes the pixels copied into its slot before it was pushed visible to this thread
+    int numTiles = 0;
+    PublishedTile published;
+    while (m_pPublishedTiles -> TryPop(published))
+    {
+        const RT::TileRect &tile = published.m_rect;
+        displayImage.WriteTile(tile.m_x0, tile.m_y0, tile.m_x1 - tile.m_x0, tile.m_y1 - tile.m_y0, &m_slotData[published.m_slot * SLOT_VALUES]);
+        m_pFreeSlots -> TryPush(published.m_slot);
+        ++numTiles;
+    }
+
+    m_tilesPublished += numTiles;
+    return numTiles;
+}
+
+// Function to test whether the frame is complete
+bool RT::AsyncRenderer::IsFrameComplete() const
+{
+    if (!m_renderFinished.load(std::memory_order_acquire) || m_cancel.IsCancelled())
+        return false;
+
+    // Finished rendering, but the last tiles may not have been published yet
+    return m_tilesPublished == m_tilesPushed.load(std::memory_order_acquire);
+}
@@ -0,0 +1,80 @@
+#ifndef ASYNCRENDERER_H
+#define ASYNCRENDERER_H
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Image.hpp"
+#include "scene.hpp"
+#include "canceltoken.hpp"
+#include "tilequeue.hpp"
+
+namespace RT
+{
+    /*
+        Renders a scene on background threads so that the thread that owns the window
+        only handles events and presents. Frames are rendered progressively into a
+        private back image by the scene's thread pool. Each finished tile is copied into
+        a free slot and the slot is published through a lock-free queue. PublishTiles
+        copies the published slots into the displayed image on the calling thread and
+        hands the slots back, so the displayed image is only ever touched by that thread
+        and the render threads never wait for it.
+    */
+    class AsyncRenderer
+    {
+        public:
+            explicit AsyncRenderer(RT::Scene &scene);
+            ~AsyncRenderer();
+
+            AsyncRenderer(const AsyncRenderer &) = delete;
+            AsyncRenderer &operator= (const AsyncRenderer &) = delete;
+
+            // Function to start rendering a new frame of the given size, cancelling any frame in progress
+            void StartFrame(int xSize, int ySize);
+
+            // Function to cancel the frame in progress and wait for the render threads to stop
+            void Cancel();
+
+            // Function to copy every tile published since the last call into the image.
+            // Returns the number of tiles copied
+            int PublishTiles(Image &displayImage);
+
+            // Function to test whether the current frame has been rendered and fully published
+            bool IsFrameComplete() const;
+
+        private:
+            // A finished tile and the slot holding its pixels
+            struct PublishedTile
+            {
+                RT::TileRect m_rect;
+                int m_slot = 0;
+            };
+
+            void RenderFrame();
+            void PublishTile(const RT::TileRect &tile);
+
+        private:
+            RT::Scene &m_scene;
+
+            // The image the render threads write to
+            Image m_backImage;
+
+            // Tile-sized pixel buffers, and the queues of free and published slots. There is one
+            // slot per tile, so a whole pass can be waiting to be displayed
+            static constexpr size_t SLOT_VALUES = static_cast<size_t>(RT::Scene::PROGRESSIVE_TILE_SIZE) * RT::Scene::PROGRESSIVE_TILE_SIZE * Image::NUM_CHANNELS;
+            std::vector<float> m_slotData;
+            std::unique_ptr<RT::BoundedQueue<int>> m_pFreeSlots;
+            std::unique_ptr<RT::BoundedQueue<PublishedTile>> m_pPublishedTiles;
+
+            RT::CancelToken m_cancel;
+            std::thread m_renderThread;
+            std::atomic<bool> m_renderFinished {true};
+
+            // The number of tiles published by the render threads and copied by PublishTiles in this frame
+            std::atomic<long> m_tilesPushed {0};
+            long m_tilesPublished = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,767 @@
+#include "bvh.hpp"
+#include "renderstats.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Build parameters
+namespace
+{
+    // Number of bins used to evaluate the SAH along each axis
+    constexpr int NUM_BINS = 16;
+
+    // Leaves are never split below this size, and always split above MAX_LEAF_SIZE
+    constexpr int MIN_LEAF_SIZE = 2;
+    constexpr int MAX_LEAF_SIZE = 8;
+
+    // Beyond this depth the build falls back to median splits
+    constexpr int MAX_BUILD_DEPTH = 48;
+
+    /*
+        Traversal keeps at most one sibling per level on its stack, plus the two children of the
+        node being visited, so nodes at MAX_TREE_DEPTH (the root is at depth 0) are always made
+        leaves to keep the stack within TRAVERSAL_STACK_SIZE entries
+    */
+    constexpr int TRAVERSAL_STACK_SIZE = 64;
+    constexpr int MAX_TREE_DEPTH = TRAVERSAL_STACK_SIZE - 1;
+
+    // Relative cost of traversing a node compared to testing an object
+    constexpr double TRAVERSAL_COST = 1.0;
+
+    // Hits further away than this are ignored, as in the original linear search
+    constexpr double MAX_HIT_DISTANCE = 1e6;
+
+    double GetAxis(const Vector3<double> &v, int axis)
+    {
+        return (axis == 0) ? v.m_x : ((axis == 1) ? v.m_y : v.m_z);
+    }
+
+    Vector3<double> Reciprocal(const Vector3<double> &v)
+    {
+        return Vector3<double>{1.0 / v.m_x, 1.0 / v.m_y, 1.0 / v.m_z};
+    }
+
+    // Functions to round a bound to the float on its outer side, clamping values beyond the range of a float
+    float RoundDown(double value)
+    {
+        if (value > std::numeric_limits<float>::max())
+            return std::numeric_limits<float>::max();
+        if (value < -std::numeric_limits<float>::max())
+            return -std::numeric_limits<float>::infinity();
+
+        float rounded = static_cast<float>(value);
+        return (static_cast<double>(rounded) > value) ? std::nextafter(rounded, -std::numeric_limits<float>::infinity()) : rounded;
+    }
+
+    float RoundUp(double value)
+    {
+        if (value < -std::numeric_limits<float>::max())
+            return -std::numeric_limits<float>::max();
+        if (value > std::numeric_limits<float>::max())
+            return std::numeric_limits<float>::infinity();
+
+        float rounded = static_cast<float>(value);
+        return (static_cast<double>(rounded) < value) ? std::nextafter(rounded, std::numeric_limits<float>::infinity()) : rounded;
+    }
+}
+
+// Function to return the bounds of a node
+RT::AABB RT::BVH::Node::GetBounds() const
+{
+    RT::AABB bounds;
+    bounds.m_min = Vector3<double>{m_min[0], m_min[1], m_min[2]};
+    bounds.m_max = Vector3<double>{m_max[0], m_max[1], m_max[2]};
+    return bounds;
+}
+
+// Function to set the bounds of a node, rounding outwards
+void RT::BVH::Node::SetBounds(const RT::AABB &bounds)
+{
+    m_min[0] = RoundDown(bounds.m_min.m_x);
+    m_min[1] = RoundDown(bounds.m_min.m_y);
+    m_min[2] = RoundDown(bounds.m_min.m_z);
+    m_max[0] = RoundUp(bounds.m_max.m_x);
+    m_max[1] = RoundUp(bounds.m_max.m_y);
+    m_max[2] = RoundUp(bounds.m_max.m_z);
+}
+
+// The default constructor
+RT::BVH::BVH()
+{
+
+}
+
+// Functions to return the objects
+RT::ObjectStore &RT::BVH::GetObjects()
+{
+    return m_objects;
+}
+
+const RT::ObjectStore &RT::BVH::GetObjects() const
+{
+    return m_objects;
+}
+
+// Function to build the tree
+void RT::BVH::Build()
+{
+    Clear();
+
+    // Gather the world-space bounds of every object
+    ObjectHandle numObjects = m_objects.GetSize();
+    std::vector<BuildItem> items;
+    std::vector<ObjectHandle> unbounded;
+    items.reserve(numObjects);
+    for (ObjectHandle handle = 0; handle < numObjects; ++handle)
+    {
+        RT::AABB bounds = m_objects.GetWorldBounds(handle);
+        if (!bounds.IsBounded())
+        {
+            unbounded.push_back(handle);
+            continue;
+        }
+
+        BuildItem item;
+        item.m_bounds = bounds;
+        item.m_centroid = bounds.Centroid();
+        item.m_object = handle;
+        items.push_back(item);
+    }
+
+    // Build the tree recursively from the root
+    if (!items.empty())
+    {
+        m_nodes.reserve(2 * items.size());
+        m_nodes.push_back(Node());
+        BuildNode(0, items, 0, static_cast<int>(items.size()), 0);
+        m_nodes.shrink_to_fit();
+    }
+
+    // Store the objects in leaf order so that each leaf is a contiguous range
+    std::vector<ObjectHandle> order;
+    order.reserve(numObjects);
+    for (const auto &item : items)
+        order.push_back(item.m_object);
+    order.insert(order.end(), unbounded.begin(), unbounded.end());
+    m_objects.Reorder(order);
+
+    m_numBounded = static_cast<int>(items.size());
+    m_builtVersion = m_objects.GetVersion();
+}
+
+// Function to use a tree that was built earlier
+bool RT::BVH::Restore(RT::MappableArray<Node> nodes, int numBounded)
+{
+    Clear();
+
+    // The leaves can only reference objects that exist, and a non-empty tree needs nodes
+    int numObjects = static_cast<int>(m_objects.GetSize());
+    if (nodes.size() > static_cast<size_t>(std::numeric_limits<int>::max()))
+        return false;
+
+    int numNodes = static_cast<int>(nodes.size());
+    if ( (numBounded < 0) || (numBounded > numObjects) || ((numBounded > 0) != (numNodes > 0)))
+        return false;
+
+    /*
+        Walk the tree to check that the traversal stays within the nodes, the objects and the
+        traversal stack, and that no node is reached twice
+    */
+    if (numNodes > 0)
+    {
+        std::vector<bool> visited (numNodes, false);
+        std::vector<std::pair<int, int>> stack {{0, 1}};
+        while (!stack.empty())
+        {
+            auto [nodeIndex, depth] = stack.back();
+            stack.pop_back();
+            if (visited[nodeIndex])
+                return false;
+            visited[nodeIndex] = true;
+
+            const Node &node = nodes[nodeIndex];
+            if (node.m_count > 0)
+            {
+                if ((node.m_first < 0) || (node.m_first > numBounded - node.m_count))
+                    return false;
+                continue;
+            }
+
+            if ((node.m_count < 0) || (node.m_first < 0) || (node.m_first > numNodes - 2) || (depth >= TRAVERSAL_STACK_SIZE))
+                return false;
+            stack.push_back({node.m_first, depth + 1});
+            stack.push_back({node.m_first + 1, depth + 1});
+        }
+    }
+
+    m_nodes = std::move(nodes);
+    m_numBounded = numBounded;
+    m_builtVersion = m_objects.GetVersion();
+    return true;
+}
+
+// Function to clear the tree
+void RT::BVH::Clear()
+{
+    m_nodes.clear();
+    m_numBounded = 0;
+}
+
+// Function to build one node (and, recursively, its children)
+void RT::BVH::BuildNode(int nodeIndex, std::vector<BuildItem> &items, int first, int count, int depth)
+{
+    // Compute the bounds of the objects in this node
+    RT::AABB bounds;
+    for (int i = first; i < first + count; ++i)
+        bounds.Grow(items[i].m_bounds);
+
+    Node &node = m_nodes.Modify(nodeIndex);
+    node.SetBounds(bounds);
+    node.m_first = first;
+    node.m_count = count;
+
+    if ((count <= MIN_LEAF_SIZE) || (depth >= MAX_TREE_DEPTH))
+        return;
+
+    int axis = 0;
+    double splitPos = 0.0;
+    bool useSAH = (depth < MAX_BUILD_DEPTH) && FindSplit(items, first, count, bounds, axis, splitPos);
+
+    int mid = first;
+    if (useSAH)
+    {
+        // Partition around the chosen plane
+        auto midIt = std::partition(items.begin() + first, items.begin() + first + count, [&](const BuildItem &item)
+        {
+            return GetAxis(item.m_centroid, axis) < splitPos;
+        });
+        mid = static_cast<int>(midIt - items.begin());
+    }
+    else if (count <= MAX_LEAF_SIZE)
+    {
+        // Splitting is not worth it
+        return;
+    }
+
+    if ((mid == first) || (mid == first + count))
+    {
+        // Fall back to a median split along the longest axis
+        Vector3<double> extent = bounds.m_max - bounds.m_min;
+        axis = (extent.m_x > extent.m_y) ? ((extent.m_x > extent.m_z) ? 0 : 2) : ((extent.m_y > extent.m_z) ? 1 : 2);
+        mid = first + (count / 2);
+        std::nth_element(items.begin() + first, items.begin() + mid, items.begin() + first + count, [&](const BuildItem &a, const BuildItem &b)
+        {
+            return GetAxis(a.m_centroid, axis) < GetAxis(b.m_centroid, axis);
+        });
+    }
+
+    // Create the two children (note that this may reallocate m_nodes)
+    int leftIndex = static_cast<int>(m_nodes.size());
+    m_nodes.push_back(Node());
+    m_nodes.push_back(Node());
+    m_nodes.Modify(nodeIndex).m_first = leftIndex;
+    m_nodes.Modify(nodeIndex).m_count = 0;
+
+    BuildNode(leftIndex, items, first, mid - first, depth + 1);
+    BuildNode(leftIndex + 1, items, mid, first + count - mid, depth + 1);
+}
+
+// Function to find the best split plane using binned SAH. Returns false if a leaf is cheaper
+bool RT::BVH::FindSplit
+(
+    const std::vector<BuildItem> &items, int first, int count,
+    const RT::AABB &bounds, int &axis, double &splitPos
+) const {
+    // The bins are laid out over the bounds of the centroids
+    RT::AABB centroidBounds;
+    for (int i = first; i < first + count; ++i)
+        centroidBounds.Grow(items[i].m_centroid);
+
+    double bestCost = static_cast<double>(count);
+    bool found = false;
+    double parentArea = bounds.SurfaceArea();
+    if (parentArea <= 0.0)
+        return false;
+
+    for (int a = 0; a < 3; ++a)
+    {
+        double axisMin = GetAxis(centroidBounds.m_min, a);
+        double axisMax = GetAxis(centroidBounds.m_max, a);
+        if (axisMax <= axisMin)
+            continue;
+
+        // Place every object into a bin
+        RT::AABB binBounds[NUM_BINS];
+        int binCounts[NUM_BINS] = {0};
+        double scale = NUM_BINS / (axisMax - axisMin);
+        for (int i = first; i < first + count; ++i)
+        {
+            int bin = std::min(NUM_BINS - 1, static_cast<int>((GetAxis(items[i].m_centroid, a) - axisMin) * scale));
+            binCounts[bin]++;
+            binBounds[bin].Grow(items[i].m_bounds);
+        }
+
+        // Sweep from the right to get the area and count on the right of each plane
+        double rightArea[NUM_BINS - 1];
+        int rightCount[NUM_BINS - 1];
+        RT::AABB accumulated;
+        int accumulatedCount = 0;
+        for (int b = NUM_BINS - 1; b > 0; --b)
+        {
+            accumulated.Grow(binBounds[b]);
+            accumulatedCount += binCounts[b];
+            rightArea[b - 1] = accumulated.SurfaceArea();
+            rightCount[b - 1] = accumulatedCount;
+        }
+
+        // Sweep from the left and evaluate the cost of each plane
+        accumulated = RT::AABB();
+        accumulatedCount = 0;
+        for (int b = 0; b < NUM_BINS - 1; ++b)
+        {
+            accumulated.Grow(binBounds[b]);
+            accumulatedCount += binCounts[b];
+            if ((accumulatedCount == 0) || (rightCount[b] == 0))
+                continue;
+
+            double cost = TRAVERSAL_COST + ((accumulated.SurfaceArea() * accumulatedCount) + (rightArea[b] * rightCount[b])) / parentArea;
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                axis = a;
+                splitPos = axisMin + (static_cast<double>(b + 1) / scale);
+                found = true;
+            }
+        }
+    }
+
+    return found;
+}
+
+// Function to test whether the tree needs to be rebuilt
+bool RT::BVH::NeedsRebuild() const
+{
+    return m_objects.GetVersion() != m_builtVersion;
+}
+
+// Function to find the closest intersection
+bool RT::BVH::CastRay
+(
+    const RT::Ray &castRay, ObjectHandle excludedObject,
+    ObjectHandle &closestObject,
+    Vector3<double> &closestIntPoint, Vector3<double> &closestLocalNormal,
+    Vector3<double> &closestLocalColor
+) const {
+    RT::RenderCounters *pCounters = RT::RenderCounters::GetCurrent();
+    bool intersectionFound = FindClosest(castRay, excludedObject, closestObject, closestIntPoint, closestLocalNormal, closestLocalColor, pCounters);
+    if (pCounters != nullptr)
+        ++(intersectionFound ? pCounters -> m_hits : pCounters -> m_misses);
+
+    return intersectionFound;
+}
+
+bool RT::BVH::FindClosest
+(
+    const RT::Ray &castRay, ObjectHandle excludedObject,
+    ObjectHandle &closestObject,
+    Vector3<double> &closestIntPoint, Vector3<double> &closestLocalNormal,
+    Vector3<double> &closestLocalColor, RT::RenderCounters *pCounters
+) const {
+    Vector3<double> intPoint;
+    Vector3<double> localNormal;
+    Vector3<double> localColor;
+    double minDist = MAX_HIT_DISTANCE;
+    bool intersectionFound = false;
+    closestObject = NO_OBJECT;
+
+    auto testObject = [&](ObjectHandle handle)
+    {
+        if (handle == excludedObject)
+            return;
+
+        if (pCounters != nullptr)
+            pCounters -> CountIntersectionTests(m_objects.GetPrimitiveType(handle), 1);
+
+        if (m_objects.TestIntersection(handle, castRay, intPoint, localNormal, localColor))
+        {
+            // Store the handle of this object if it is the closest so far
+            double dist = (intPoint - castRay.m_point1).norm();
+            if (dist < minDist)
+            {
+                minDist = dist;
+                closestObject = handle;
+                closestIntPoint = intPoint;
+                closestLocalNormal = localNormal;
+                closestLocalColor = localColor;
+                intersectionFound = true;
+            }
+        }
+    };
+
+    for (ObjectHandle handle = m_numBounded; handle < m_objects.GetSize(); ++handle)
+        testObject(handle);
+
+    if (m_nodes.empty())
+        return intersectionFound;
+
+    // Box tests are done in terms of the ray parameter, so distances are scaled by the length of m_lab
+    Vector3<double> invDir = Reciprocal(castRay.m_lab);
+    double labLength = castRay.m_lab.norm();
+
+    int stack[TRAVERSAL_STACK_SIZE];
+    double stackEntry[TRAVERSAL_STACK_SIZE];
+    int stackSize = 0;
+
+    double tEntry;
+    if (m_nodes[0].GetBounds().IntersectRay(castRay.m_point1, invDir, castRay.m_tMin, std::min(castRay.m_tMax, minDist / labLength), tEntry))
+    {
+        stack[stackSize] = 0;
+        stackEntry[stackSize++] = tEntry;
+    }
+
+    while (stackSize > 0)
+    {
+        --stackSize;
+        int nodeIndex = stack[stackSize];
+
+        // Skip nodes that start beyond the closest hit found since they were pushed
+        if (stackEntry[stackSize] * labLength > minDist)
+            continue;
+
+        const Node &node = m_nodes[nodeIndex];
+        if (node.m_count > 0)
+        {
+            for (ObjectHandle handle = node.m_first; handle < static_cast<ObjectHandle>(node.m_first + node.m_count); ++handle)
+                testObject(handle);
+            continue;
+        }
+
+        // Visit the nearer child first by pushing it last
+        double tMax = std::min(castRay.m_tMax, minDist / labLength);
+        double tLeft, tRight;
+        bool hitLeft = m_nodes[node.m_first].GetBounds().IntersectRay(castRay.m_point1, invDir, castRay.m_tMin, tMax, tLeft);
+        bool hitRight = m_nodes[node.m_first + 1].GetBounds().IntersectRay(castRay.m_point1, invDir, castRay.m_tMin, tMax, tRight);
+        if (hitLeft && hitRight)
+        {
+            bool leftFirst = tLeft <= tRight;
+            stack[stackSize] = leftFirst ? node.m_first + 1 : node.m_first;
+            stackEntry[stackSize++] = leftFirst ? tRight : tLeft;
+            stack[stackSize] = leftFirst ? node.m_first : node.m_first + 1;
+            stackEntry[stackSize++] = leftFirst ? tLeft : tRight;
+        }
+        else if (hitLeft)
+        {
+            stack[stackSize] = node.m_first;
+            stackEntry[stackSize++] = tLeft;
+        }
+        else if (hitRight)
+        {
+            stack[stackSize] = node.m_first + 1;
+            stackEntry[stackSize++] = tRight;
+        }
+    }
+
+    return intersectionFound;
+}
+
+// Function to test for occlusion
+bool RT::BVH::Occluded(const RT::Ray &castRay, ObjectHandle excludedObject, double tMax) const
+{
+    RT::RenderCounters *pCounters = RT::RenderCounters::GetCurrent();
+    bool occluded = FindOccluder(castRay, excludedObject, tMax, pCounters);
+    if (pCounters != nullptr)
+    {
+        ++pCounters -> m_shadowRays;
+        pCounters -> m_shadowRaysOccluded += occluded ? 1 : 0;
+    }
+
+    return occluded;
+}
+
+bool RT::BVH::FindOccluder(const RT::Ray &castRay, ObjectHandle excludedObject, double tMax, RT::RenderCounters *pCounters) const
+{
+    auto testObject = [&](ObjectHandle handle)
+    {
+        if (handle == excludedObject)
+            return false;
+
+        if (pCounters != nullptr)
+            pCounters -> CountIntersectionTests(m_objects.GetPrimitiveType(handle), 1);
+
+        return m_objects.Occluded(handle, castRay, tMax);
+    };
+
+    for (ObjectHandle handle = m_numBounded; handle < m_objects.GetSize(); ++handle)
+    {
+        if (testObject(handle))
+            return true;
+    }
+
+    if (m_nodes.empty())
+        return false;
+
+    // Only the part of the ray inside both its own interval and [.., tMax] can be occluded
+    Vector3<double> invDir = Reciprocal(castRay.m_lab);
+    double tBoxMax = std::min(castRay.m_tMax, tMax);
+
+    int stack[TRAVERSAL_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const Node &node = m_nodes[stack[--stackSize]];
+
+        double tEntry;
+        if (!node.GetBounds().IntersectRay(castRay.m_point1, invDir, castRay.m_tMin, tBoxMax, tEntry))
+            continue;
+
+        if (node.m_count > 0)
+        {
+            for (ObjectHandle handle = node.m_first; handle < static_cast<ObjectHandle>(node.m_first + node.m_count); ++handle)
+            {
+                if (testObject(handle))
+                    return true;
+            }
+            continue;
+        }
+
+        stack[stackSize++] = node.m_first + 1;
+        stack[stackSize++] = node.m_first;
+    }
+
+    return false;
+}
+
+// Function to find the closest intersection for each ray of a packet
+void RT::BVH::CastPacket
+(
+    const RT::RayPacket &packet,
+    ObjectHandle *closestObjects, double *closestT,
+    const ObjectHandle *excludedObjects
+) const {
+    RT::RenderCounters *pCounters = RT::RenderCounters::GetCurrent();
+    FindClosestPacket(packet, closestObjects, closestT, excludedObjects, pCounters);
+    if (pCounters != nullptr)
+    {
+        for (int lane = 0; lane < packet.m_size; ++lane)
+            ++((closestObjects[lane] != NO_OBJECT) ? pCounters -> m_hits : pCounters -> m_misses);
+    }
+}
+
+void RT::BVH::FindClosestPacket
+(
+    const RT::RayPacket &packet,
+    ObjectHandle *closestObjects, double *closestT,
+    const ObjectHandle *excludedObjects, RT::RenderCounters *pCounters
+) const {
+    constexpr int MAX_SIZE = RT::RayPacket::MAX_SIZE;
+    const int size = packet.m_size;
+
+    // The scalar search ignores hits beyond MAX_HIT_DISTANCE, which is a different ray parameter for each ray
+    Vector3<double> origin[MAX_SIZE];
+    Vector3<double> invDir[MAX_SIZE];
+    for (int lane = 0; lane < size; ++lane)
+    {
+        Vector3<double> lab {packet.m_labX[lane], packet.m_labY[lane], packet.m_labZ[lane]};
+        origin[lane] = Vector3<double>{packet.m_originX[lane], packet.m_originY[lane], packet.m_originZ[lane]};
+        invDir[lane] = Reciprocal(lab);
+        closestObjects[lane] = NO_OBJECT;
+        closestT[lane] = MAX_HIT_DISTANCE / lab.norm();
+    }
+
+    double tHit[MAX_SIZE];
+    auto testObject = [&](ObjectHandle handle)
+    {
+        if (pCounters != nullptr)
+            pCounters -> CountIntersectionTests(m_objects.GetPrimitiveType(handle), size);
+
+        m_objects.TestIntersectionPacket(handle, packet, tHit);
+        for (int lane = 0; lane < size; ++lane)
+        {
+            if ((excludedObjects != nullptr) && (excludedObjects[lane] == handle))
+                continue;
+
+            if (tHit[lane] < closestT[lane])
+            {
+                closestT[lane] = tHit[lane];
+                closestObjects[lane] = handle;
+            }
+        }
+    };
+
+    // Function to test a box against every ray, returning whether any ray hits it and the nearest entry
+    auto testBox = [&](const Node &node, double &tNearest)
+    {
+        RT::AABB bounds = node.GetBounds();
+        bool hit = false;
+        tNearest = std::numeric_limits<double>::infinity();
+        for (int lane = 0; lane < size; ++lane)
+        {
+            double tEntry;
+            if (bounds.IntersectRay(origin[lane], invDir[lane], packet.m_tMin[lane], std::min(packet.m_tMax[lane], closestT[lane]), tEntry))
+            {
+                hit = true;
+                tNearest = std::min(tNearest, tEntry);
+            }
+        }
+        return hit;
+    };
+
+    for (ObjectHandle handle = m_numBounded; handle < m_objects.GetSize(); ++handle)
+        testObject(handle);
+
+    if (m_nodes.empty())
+        return;
+
+    int stack[TRAVERSAL_STACK_SIZE];
+    int stackSize = 0;
+
+    double tEntry;
+    if (testBox(m_nodes[0], tEntry))
+        stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const Node &node = m_nodes[stack[--stackSize]];
+        if (node.m_count > 0)
+        {
+            for (ObjectHandle handle = node.m_first; handle < static_cast<ObjectHandle>(node.m_first + node.m_count); ++handle)
+                testObject(handle);
+            continue;
+        }
+
+        // Visit the child that the packet reaches first by pushing it last. A child is
+        // visited if any ray of the packet reaches it before its closest hit so far
+        double tLeft, tRight;
+        bool hitLeft = testBox(m_nodes[node.m_first], tLeft);
+        bool hitRight = testBox(m_nodes[node.m_first + 1], tRight);
+        if (hitLeft && hitRight)
+        {
+            bool leftFirst = tLeft <= tRight;
+            stack[stackSize++] = leftFirst ? node.m_first + 1 : node.m_first;
+            stack[stackSize++] = leftFirst ? node.m_first : node.m_first + 1;
+        }
+        else if (hitLeft)
+        {
+            stack[stackSize++] = node.m_first;
+        }
+        else if (hitRight)
+        {
+            stack[stackSize++] = node.m_first + 1;
+        }
+    }
+}
+
+// Function to test a packet of rays for occlusion
+void RT::BVH::OccludedPacket(const RT::RayPacket &packet, const double *tMax, bool *occluded) const
+{
+    RT::RenderCounters *pCounters = RT::RenderCounters::GetCurrent();
+    FindOccludersPacket(packet, tMax, occluded, pCounters);
+    if (pCounters != nullptr)
+    {
+        pCounters -> m_shadowRays += packet.m_size;
+        for (int lane = 0; lane < packet.m_size; ++lane)
+            pCounters -> m_shadowRaysOccluded += occluded[lane] ? 1 : 0;
+    }
+}
+
+void RT::BVH::FindOccludersPacket(const RT::RayPacket &packet, const double *tMax, bool *occluded, RT::RenderCounters *pCounters) const
+{
+    constexpr int MAX_SIZE = RT::RayPacket::MAX_SIZE;
+    const int size = packet.m_size;
+
+    Vector3<double> origin[MAX_SIZE];
+    Vector3<double> invDir[MAX_SIZE];
+    for (int lane = 0; lane < size; ++lane)
+    {
+        origin[lane] = Vector3<double>{packet.m_originX[lane], packet.m_originY[lane], packet.m_originZ[lane]};
+        invDir[lane] = Reciprocal(Vector3<double>{packet.m_labX[lane], packet.m_labY[lane], packet.m_labZ[lane]});
+        occluded[lane] = false;
+    }
+
+    // Function to test an object against the rays, returning true once every ray is blocked
+    double tHit[MAX_SIZE];
+    int numOccluded = 0;
+    auto testObject = [&](ObjectHandle handle)
+    {
+        if (pCounters != nullptr)
+            pCounters -> CountIntersectionTests(m_objects.GetPrimitiveType(handle), size);
+
+        m_objects.TestIntersectionPacket(handle, packet, tHit);
+        for (int lane = 0; lane < size; ++lane)
+        {
+            if (!occluded[lane] && (tHit[lane] < tMax[lane]))
+            {
+                occluded[lane] = true;
+                ++numOccluded;
+            }
+        }
+        return numOccluded == size;
+    };
+
+    for (ObjectHandle handle = m_numBounded; handle < m_objects.GetSize(); ++handle)
+    {
+        if (testObject(handle))
+            return;
+    }
+
+    if (m_nodes.empty())
+        return;
+
+    int stack[TRAVERSAL_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const Node &node = m_nodes[stack[--stackSize]];
+
+        // Only the rays that are not yet blocked need to reach the box
+        RT::AABB bounds = node.GetBounds();
+        bool hit = false;
+        for (int lane = 0; (lane < size) && !hit; ++lane)
+        {
+            double tEntry;
+            hit = !occluded[lane] && bounds.IntersectRay(origin[lane], invDir[lane], packet.m_tMin[lane], std::min(packet.m_tMax[lane], tMax[lane]), tEntry);
+        }
+        if (!hit)
+            continue;
+
+        if (node.m_count > 0)
+        {
+            for (ObjectHandle handle = node.m_first; handle < static_cast<ObjectHandle>(node.m_first + node.m_count); ++handle)
+            {
+                if (testObject(handle))
+                    return;
+            }
+            continue;
+        }
+
+        stack[stackSize++] = node.m_first + 1;
+        stack[stackSize++] = node.m_first;
+    }
+}
+
+// Function to return the number of nodes
+int RT::BVH::GetNumNodes() const
+{
+    return static_cast<int>(m_nodes.size());
+}
+
+// Functions to return the tree, eg. to save it
+const RT::MappableArray<RT::BVH::Node> &RT::BVH::GetNodes() const
+{
+    return m_nodes;
+}
+
+int RT::BVH::GetNumBounded() const
+{
+    return m_numBounded;
+}
+
+// Function to return the memory used
+size_t RT::BVH::GetMemorySize() const
+{
+    return (m_nodes.capacity() * sizeof(Node)) + m_objects.GetMemorySize();
+}
@@ -0,0 +1,170 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "../LinAlg/Vector3.hpp"
+#include "aabb.hpp"
+#include "ray.hpp"
+#include "raypacket.hpp"
+#include "mappablearray.hpp"
+#include "objectstore.hpp"
+
+namespace RT
+{
+    struct RenderCounters;
+
+    /*
+        Bounding volume hierarchy over the world-space bounds of the objects in a scene.
+        The tree is built with the surface area heuristic (SAH) and supports closest-hit
+        queries (for camera and reflection rays) and any-hit occlusion queries (for shadow rays).
+        Objects without finite bounds are not in the tree and are always tested.
+
+        The tree owns the objects, in an ObjectStore that is reordered into tree order when the
+        tree is built, and the queries refer to them by a 32-bit handle, their index in the store.
+        The nodes store their bounds as floats so that each is 32 bytes.
+    */
+    class BVH
+    {
+        public:
+            // A reference to an object of the tree, its index in GetObjects. Handles stay valid until the tree is next built
+            using ObjectHandle = RT::ObjectStore::Handle;
+            static constexpr ObjectHandle NO_OBJECT = 0xffffffff;
+
+            // A node of the tree. Leaves have m_count > 0 and reference m_count objects
+            // starting at m_first, interior nodes have two children at m_first and m_first + 1
+            struct Node
+            {
+                float m_min[3] = {0.0f, 0.0f, 0.0f};
+                int32_t m_first = 0;
+                float m_max[3] = {0.0f, 0.0f, 0.0f};
+                int32_t m_count = 0;
+
+                // Functions to return and set the bounds. Setting them rounds outwards, so that
+                // the node always contains the box it was given
+                RT::AABB GetBounds() const;
+                void SetBounds(const RT::AABB &bounds);
+            };
+
+            // The default constructor
+            BVH();
+
+            /*
+                Functions to return the objects. Objects are added to the store and the tree is then
+                built over them, which reorders the store and so changes their handles
+            */
+            RT::ObjectStore &GetObjects();
+            const RT::ObjectStore &GetObjects() const;
+
+            // Function to build the tree over the objects
+            void Build();
+
+            /*
+                Function to use a tree that was built earlier (eg. saved with a compiled scene)
+                instead of building one. The nodes may be a view of a mapped file, which is used
+                in place. The objects must already be in the tree order, with the first numBounded
+                of them the objects referenced by the leaves. Returns false, leaving the tree
+                empty, if the nodes do not describe a valid tree over the objects
+            */
+            bool Restore(RT::MappableArray<Node> nodes, int numBounded);
+
+            // Function to test whether the objects have changed since the tree was built
+            bool NeedsRebuild() const;
+
+            // Function to find the closest object hit by a ray within its [m_tMin, m_tMax] interval,
+            // ignoring excludedObject (which may be NO_OBJECT)
+            bool CastRay
+            (
+                const RT::Ray &castRay, ObjectHandle excludedObject,
+                ObjectHandle &closestObject,
+                Vector3<double> &closestIntPoint, Vector3<double> &closestLocalNormal,
+                Vector3<double> &closestLocalColor
+            ) const;
+
+            // Function to test whether a ray hits any object other than excludedObject (which may be
+            // NO_OBJECT) within its [m_tMin, m_tMax] interval and before the ray parameter tMax.
+            // Returns as soon as any hit is found
+            bool Occluded(const RT::Ray &castRay, ObjectHandle excludedObject, double tMax) const;
+
+            /*
+                Function to find the closest object hit by each ray of a packet within its interval.
+                closestObjects[lane] is the handle of the object (or NO_OBJECT if the ray hits nothing)
+                and closestT[lane] holds the ray parameter of the hit. If excludedObjects is not null,
+                the ray in each lane ignores the object excludedObjects[lane] (which may be NO_OBJECT),
+                as CastRay does for excludedObject. The packet is traversed as a whole, so this is best
+                suited to coherent rays, such as neighbouring camera rays
+            */
+            void CastPacket
+            (
+                const RT::RayPacket &packet,
+                ObjectHandle *closestObjects, double *closestT,
+                const ObjectHandle *excludedObjects = nullptr
+            ) const;
+
+            // Function to test, for each ray of a packet, whether any object blocks it within its
+            // interval and before the ray parameter tMax[lane]
+            void OccludedPacket(const RT::RayPacket &packet, const double *tMax, bool *occluded) const;
+
+            // Function to return the number of nodes in the tree
+            int GetNumNodes() const;
+
+            // Functions to return the nodes, and the number of objects (which come first) referenced by the leaves
+            const RT::MappableArray<Node> &GetNodes() const;
+            int GetNumBounded() const;
+
+            // Function to return the number of bytes used by the tree and its objects
+            size_t GetMemorySize() const;
+
+        private:
+
+            // Per-object data used while building
+            struct BuildItem
+            {
+                RT::AABB m_bounds;
+                Vector3<double> m_centroid;
+                ObjectHandle m_object;
+            };
+
+            void BuildNode(int nodeIndex, std::vector<BuildItem> &items, int first, int count, int depth);
+            bool FindSplit(const std::vector<BuildItem> &items, int first, int count, const RT::AABB &bounds, int &axis, double &splitPos) const;
+
+            // Function to clear the tree, keeping the objects
+            void Clear();
+
+            // The queries behind the public functions, which count the object tests in pCounters if it is not null
+            bool FindClosest
+            (
+                const RT::Ray &castRay, ObjectHandle excludedObject,
+                ObjectHandle &closestObject,
+                Vector3<double> &closestIntPoint, Vector3<double> &closestLocalNormal,
+                Vector3<double> &closestLocalColor, RT::RenderCounters *pCounters
+            ) const;
+            bool FindOccluder(const RT::Ray &castRay, ObjectHandle excludedObject, double tMax, RT::RenderCounters *pCounters) const;
+            void FindClosestPacket
+            (
+                const RT::RayPacket &packet,
+                ObjectHandle *closestObjects, double *closestT,
+                const ObjectHandle *excludedObjects, RT::RenderCounters *pCounters
+            ) const;
+            void FindOccludersPacket(const RT::RayPacket &packet, const double *tMax, bool *occluded, RT::RenderCounters *pCounters) const;
+
+        private:
+            // The tree nodes, with the root at index 0
+            RT::MappableArray<Node> m_nodes;
+
+            /*
+                The objects, indexed by handle. Once the tree is built, the bounded objects come first,
+                ordered so that each leaf references a contiguous range, followed by the objects without
+                finite bounds
+            */
+            RT::ObjectStore m_objects;
+            int m_numBounded = 0;
+
+            // The version of the objects when the tree was built, used to detect changes
+            uint32_t m_builtVersion = 0;
+    };
+}
+
+#endif
@@ -5,25 +5,25 @@
 RT::Camera::Camera()
 {
     // The default constructor
-    m_cameraPosition = Vector<double>   {std::vector<double> {0.0, -10.0, 0.0}};
-    m_cameraLookAt = Vector<double>     {std::vector<double> {0.0, 0.0, 0.0}};
-    m_cameraUp = Vector<double>         {std::vector<double> {0.0, 0.0, 1.0}};
+    m_cameraPosition = Vector3<double>{0.0, -10.0, 0.0};
+    m_cameraLookAt = Vector3<double>{0.0, 0.0, 0.0};
+    m_cameraUp = Vector3<double>{0.0, 0.0, 1.0};
     m_cameraLength = 1.0;
     m_cameraHorzSize = 1.0;
     m_cameraAspectRatio = 1.0;
 }
 
-void RT::Camera::SetPosition(const Vector<double> &newPosition)
+void RT::Camera::SetPosition(const Vector3<double> &newPosition)
 {
     m_cameraPosition = newPosition;
 }
 
-void RT::Camera::SetLookAt(const Vector<double> &newLookAt)
+void RT::Camera::SetLookAt(const Vector3<double> &newLookAt)
 {
     m_cameraLookAt = newLookAt;
 }
 
-void RT::Camera::SetUp(const Vector<double> &upVector)
+void RT::Camera::SetUp(const Vector3<double> &upVector)
 {
     m_cameraUp = upVector;
 }
@@ -44,19 +44,19 @@ void RT::Camera::SetAspect(double newAspect)
 }
 
 // Method to return the position of the camera
-Vector<double> RT::Camera::GetPosition()
+Vector3<double> RT::Camera::GetPosition()
 {
     return m_cameraPosition;
 }
 
 // Method to return the LookAt of the camera
-Vector<double> RT::Camera::GetLookAt()
+Vector3<double> RT::Camera::GetLookAt()
 {
     return m_cameraLookAt;
 }
 
 // Method to return the up vector of the camera
-Vector<double> RT::Camera::GetUp()
+Vector3<double> RT::Camera::GetUp()
 {
     return m_cameraUp;
 }
@@ -80,19 +80,19 @@ double RT::Camera::GetAspect()
 }
 
 // Method to return the U vector of the camera
-Vector<double> RT::Camera::GetU()
+Vector3<double> RT::Camera::GetU()
 {
     return m_projectionScreenU;
 }
 
 // Method to return the V vector of the camera
-Vector<double> RT::Camera::GetV()
+Vector3<double> RT::Camera::GetV()
 {
     return m_projectionScreenV;
 }
 
 // Method to return the projection screen centre of the camera
-Vector<double> RT::Camera::GetScreenCentre()
+Vector3<double> RT::Camera::GetScreenCentre()
 {
     return m_projectionScreenCentre;
 }
@@ -105,9 +105,9 @@ void RT::Camera::UpdateCameraGeometry()
     m_alignmentVector.Normalize();
 
     // Second, compute the U and V vectors
-    m_projectionScreenU = Vector<double>::cross(m_alignmentVector, m_cameraUp);
+    m_projectionScreenU = Vector3<double>::cross(m_alignmentVector, m_cameraUp);
     m_projectionScreenU.Normalize();
-    m_projectionScreenV = Vector<double>::cross(m_projectionScreenU, m_alignmentVector);
+    m_projectionScreenV = Vector3<double>::cross(m_projectionScreenU, m_alignmentVector);
     m_alignmentVector.Normalize();
 
     // Third, compute the position of the centre point of the screen
@@ -122,8 +122,8 @@ void RT::Camera::UpdateCameraGeometry()
 bool RT::Camera::GenerateRay(float proScreenX, float proScreenY, RT::Ray &cameraRay)
 {
     // Compute the location of the screen point in the world coordinates
-    Vector<double> screenWorldPart1 = m_projectionScreenCentre + (m_projectionScreenU * proScreenX);
-    Vector<double> screenWorldCoordinate = screenWorldPart1 + (m_projectionScreenV * proScreenY);
+    Vector3<double> screenWorldPart1 = m_projectionScreenCentre + (m_projectionScreenU * proScreenX);
+    Vector3<double> screenWorldCoordinate = screenWorldPart1 + (m_projectionScreenV * proScreenY);
 
     // Use this point along with the camera position to compute the ray
     cameraRay.m_point1 = m_cameraPosition;
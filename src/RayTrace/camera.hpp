@@ -1,7 +1,7 @@
 #ifndef CAMERA_H
 #define CAMERA_H
 
-#include "../LinAlg/Vector.h"
+#include "../LinAlg/Vector3.hpp"
 #include "ray.hpp"
 
 namespace RT
@@ -13,20 +13,20 @@ namespace RT
             Camera();
 
             // Functions to set camera parameters
-            void SetPosition    (const Vector<double> &newPosition);
-            void SetLookAt      (const Vector<double> &newLookAt);
-            void SetUp          (const Vector<double> &upVector);
+            void SetPosition    (const Vector3<double> &newPosition);
+            void SetLookAt      (const Vector3<double> &newLookAt);
+            void SetUp          (const Vector3<double> &upVector);
             void SetLength      (double newLength);
             void SetHorzSize    (double newSize);
             void SetAspect      (double newAspect);
 
             // Functions to return camera parameters
-            Vector<double>      GetPosition();
-            Vector<double>      GetLookAt();
-            Vector<double>      GetUp();
-            Vector<double>      GetU();
-            Vector<double>      GetV();
-            Vector<double>      GetScreenCentre();
+            Vector3<double>     GetPosition();
+            Vector3<double>     GetLookAt();
+            Vector3<double>     GetUp();
+            Vector3<double>     GetU();
+            Vector3<double>     GetV();
+            Vector3<double>     GetScreenCentre();
             double              GetLength();
             double              GetHorzSize();
             double              GetAspect();
@@ -38,17 +38,17 @@ namespace RT
             void UpdateCameraGeometry();
         
         private:
-            Vector<double> m_cameraPosition {3};
-            Vector<double> m_cameraLookAt   {3};
-            Vector<double> m_cameraUp       {3};
+            Vector3<double> m_cameraPosition;
+            Vector3<double> m_cameraLookAt;
+            Vector3<double> m_cameraUp;
             double m_cameraLength;
             double m_cameraHorzSize;
             double m_cameraAspectRatio;
 
-            Vector<double> m_alignmentVector        {3};
-            Vector<double> m_projectionScreenU      {3};
-            Vector<double> m_projectionScreenV      {3};
-            Vector<double> m_projectionScreenCentre {3};
+            Vector3<double> m_alignmentVector;
+            Vector3<double> m_projectionScreenU;
+            Vector3<double> m_projectionScreenV;
+            Vector3<double> m_projectionScreenCentre;
 
     };
 }
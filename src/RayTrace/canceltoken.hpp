@@ -0,0 +1,39 @@
+#ifndef CANCELTOKEN_H
+#define CANCELTOKEN_H
+
+#include <atomic>
+
+namespace RT
+{
+    /*
+        A flag used to ask a render in progress to stop. Any thread may call Cancel,
+        and the render threads poll IsCancelled between small units of work (rows
+        of a tile), so a cancelled frame stops within a fraction of a millisecond.
+    */
+    class CancelToken
+    {
+        public:
+            // Function to request cancellation
+            void Cancel()
+            {
+                m_cancelled.store(true, std::memory_order_relaxed);
+            }
+
+            // Function to test whether cancellation has been requested
+            bool IsCancelled() const
+            {
+                return m_cancelled.load(std::memory_order_relaxed);
+            }
+
+            // Function to clear the flag before the token is used for a new render
+            void Reset()
+            {
+                m_cancelled.store(false, std::memory_order_relaxed);
+            }
+
+        private:
+            std::atomic<bool> m_cancelled {false};
+    };
+}
+
+#endif
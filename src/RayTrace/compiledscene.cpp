@@ -0,0 +1,464 @@
+#include "compiledscene.hpp"
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include "mappedfile.hpp"
+
+// The layout of the file. Every record is a multiple of 8 bytes, so each section stays aligned
+namespace
+{
+    const char MAGIC[8] = {'R', 'T', 'S', 'C', 'E', 'N', 'E', '\0'};
+
+    struct FileSection
+    {
+        uint64_t m_offset;
+        uint64_t m_count;
+    };
+
+    struct FileHeader
+    {
+        char m_magic[8];
+        uint32_t m_version;
+        uint32_t m_headerSize;
+        uint64_t m_fileSize;
+
+        double m_cameraPosition[3];
+        double m_cameraLookAt[3];
+        double m_cameraUp[3];
+        double m_cameraLength;
+        double m_cameraHorzSize;
+        double m_cameraAspect;
+
+        FileSection m_materials;
+        FileSection m_lights;
+
+        // The arrays of the object store, in tree order, and the BVH nodes
+        FileSection m_shapes;
+        FileSection m_transforms;
+        FileSection m_colors;
+        FileSection m_materialIndices;
+        FileSection m_sphereCentres;
+        FileSection m_nodes;
+
+        // The mesh geometry, with the arrays of every mesh stored one after another
+        FileSection m_meshes;
+        FileSection m_meshPositions;
+        FileSection m_meshNormals;
+        FileSection m_meshIndices;
+        FileSection m_meshNodes;
+
+        // The number of objects in the BVH leaves, the rest are tested against every ray
+        uint64_t m_numBounded;
+    };
+
+    struct MaterialRecord
+    {
+        double m_color[3];
+        double m_reflectivity;
+        double m_shininess;
+    };
+
+    struct LightRecord
+    {
+        double m_position[3];
+        double m_color[3];
+        double m_intensity;
+    };
+
+    // A range of elements within one of the mesh array sections
+    struct MeshRange
+    {
+        uint64_t m_first;
+        uint64_t m_count;
+    };
+
+    // The mesh geometry shared by any number of mesh objects, whose triangle BVH is saved as is
+    struct MeshRecord
+    {
+        MeshRange m_positions;
+        MeshRange m_normals;
+        MeshRange m_indices;
+        MeshRange m_nodes;
+    };
+
+    static_assert(sizeof(FileHeader) == 336, "The compiled scene header must not change size");
+    static_assert(sizeof(MaterialRecord) == 40, "The compiled scene records must not change size");
+    static_assert(sizeof(LightRecord) == 56, "The compiled scene records must not change size");
+    static_assert(sizeof(MeshRecord) == 64, "The compiled scene records must not change size");
+
+    // The arrays that are used in place are part of the format too
+    static_assert(sizeof(RT::ObjectStore::Shape) == 8, "The compiled scene records must not change size");
+    static_assert(sizeof(RT::AffineMatrix) == 96, "The compiled scene records must not change size");
+    static_assert(sizeof(Vector3<double>) == 24, "The compiled scene records must not change size");
+    static_assert(sizeof(RT::BVH::Node) == 32, "The compiled scene records must not change size");
+    static_assert(sizeof(RT::MeshGeometry::Node) == 32, "The compiled scene records must not change size");
+    static_assert(std::is_trivially_copyable<RT::AffineMatrix>::value && std::is_trivially_copyable<Vector3<double>>::value,
+                  "The arrays used in place must be plain data");
+    static_assert(std::is_trivially_copyable<RT::BVH::Node>::value && std::is_trivially_copyable<RT::MeshGeometry::Node>::value,
+                  "The arrays used in place must be plain data");
+
+    // The primitive types are saved in ObjectStore::Shape, so they must never be renumbered
+    static_assert((static_cast<int>(RT::PrimitiveType::SPHERE) == 0) && (static_cast<int>(RT::PrimitiveType::PLANE) == 1) &&
+                  (static_cast<int>(RT::PrimitiveType::MESH) == 2), "The primitive types are part of the compiled scene format");
+
+    // The records are read and written directly, which relies on the host being little-endian
+    bool IsLittleEndian()
+    {
+        const uint16_t value = 1;
+        unsigned char firstByte;
+        std::memcpy(&firstByte, &value, 1);
+        return firstByte == 1;
+    }
+
+    void ToArray(const Vector3<double> &vector, double *values)
+    {
+        values[0] = vector.m_x;
+        values[1] = vector.m_y;
+        values[2] = vector.m_z;
+    }
+
+    Vector3<double> FromArray(const double *values)
+    {
+        return Vector3<double>{values[0], values[1], values[2]};
+    }
+
+    // Function to return a section of the file as records, or null if it does not fit in the file
+    template <typename T>
+    const T *GetSection(const RT::MappedFile &file, const FileSection &section)
+    {
+        if ((section.m_offset % alignof(T) != 0) || (section.m_offset > file.GetSize()))
+            return nullptr;
+        if (section.m_count > (file.GetSize() - section.m_offset) / sizeof(T))
+            return nullptr;
+        if (section.m_count > static_cast<uint64_t>(std::numeric_limits<int>::max()))
+            return nullptr;
+
+        return reinterpret_cast<const T *>(file.GetData() + section.m_offset);
+    }
+
+    // Function to view a whole section in place, keeping the file mapped for as long as the view is used
+    template <typename T>
+    RT::MappableArray<T> MapSection(const T *records, const FileSection &section, const std::shared_ptr<const RT::MappedFile> &pFile)
+    {
+        RT::MappableArray<T> values;
+        values.Map(records, section.m_count, pFile);
+        return values;
+    }
+
+    // Function to view a range of a mesh array section in place, returning false if it is outside the section
+    template <typename T>
+    bool MapRange
+    (
+        const T *records, const FileSection &section, const MeshRange &range,
+        const std::shared_ptr<const RT::MappedFile> &pFile, RT::MappableArray<T> &values
+    ) {
+        if ((range.m_first > section.m_count) || (range.m_count > section.m_count - range.m_first))
+            return false;
+
+        values.Map(records + range.m_first, range.m_count, pFile);
+        return true;
+    }
+
+    // Function to append an array to a mesh array section, returning its range
+    template <typename T>
+    MeshRange AppendRange(const RT::MappableArray<T> &source, std::vector<T> &values)
+    {
+        MeshRange range {values.size(), source.size()};
+        values.insert(values.end(), source.begin(), source.end());
+        return range;
+    }
+}
+
+// The default constructor
+RT::CompiledScene::CompiledScene()
+{
+
+}
+
+// Function to save a scene
+bool RT::CompiledScene::Save(const std::string &fileName, RT::Scene &scene)
+{
+    m_fileName = fileName;
+    m_error.clear();
+    if (!IsLittleEndian())
+        return Fail("compiled scenes are only supported on little-endian machines");
+
+    // The arrays of the store are saved as they are, in the tree order that the BVH leaves reference
+    const RT::BVH &bvh = scene.GetBVH();
+    const RT::ObjectStore &store = bvh.GetObjects();
+    const auto &lightList = scene.GetLightList();
+
+    std::vector<MaterialRecord> materials (store.GetMaterials().size());
+    for (size_t i = 0; i < materials.size(); ++i)
+    {
+        auto *pMaterial = dynamic_cast<const RT::SimpleMaterial *>(store.GetMaterials()[i].get());
+        if (pMaterial == nullptr)
+            return Fail("material " + std::to_string(i) + " is not a SimpleMaterial");
+
+        ToArray(pMaterial -> m_baseColor, materials[i].m_color);
+        materials[i].m_reflectivity = pMaterial -> m_reflectivity;
+        materials[i].m_shininess = pMaterial -> m_shininess;
+    }
+
+    // The store holds each mesh geometry once, however many instances share it
+    std::vector<MeshRecord> meshes (store.GetMeshes().size());
+    std::vector<float> meshPositions;
+    std::vector<float> meshNormals;
+    std::vector<uint32_t> meshIndexValues;
+    std::vector<RT::MeshGeometry::Node> meshNodes;
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        const RT::MeshGeometry &geometry = *store.GetMeshes()[i];
+        meshes[i].m_positions = AppendRange(geometry.GetPositions(), meshPositions);
+        meshes[i].m_normals = AppendRange(geometry.GetNormals(), meshNormals);
+        meshes[i].m_indices = AppendRange(geometry.GetIndices(), meshIndexValues);
+        meshes[i].m_nodes = AppendRange(geometry.GetNodes(), meshNodes);
+    }
+
+    std::vector<LightRecord> lights (lightList.size());
+    for (size_t i = 0; i < lightList.size(); ++i)
+    {
+        if (dynamic_cast<const RT::PointLight *>(lightList[i].get()) == nullptr)
+            return Fail("light " + std::to_string(i) + " is not a point light");
+
+        ToArray(lightList[i] -> m_location, lights[i].m_position);
+        ToArray(lightList[i] -> m_color, lights[i].m_color);
+        lights[i].m_intensity = lightList[i] -> m_intensity;
+    }
+
+    // Lay out the sections one after another
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.m_magic, MAGIC, sizeof(MAGIC));
+    header.m_version = VERSION;
+    header.m_headerSize = sizeof(FileHeader);
+
+    RT::Camera &camera = scene.GetCamera();
+    ToArray(camera.GetPosition(), header.m_cameraPosition);
+    ToArray(camera.GetLookAt(), header.m_cameraLookAt);
+    ToArray(camera.GetUp(), header.m_cameraUp);
+    header.m_cameraLength = camera.GetLength();
+    header.m_cameraHorzSize = camera.GetHorzSize();
+    header.m_cameraAspect = camera.GetAspect();
+
+    // Sections start on 8 byte boundaries, padding the ones made of 4 byte values as needed
+    uint64_t offset = sizeof(FileHeader);
+    auto placeSection = [&offset](FileSection &section, size_t count, size_t recordSize)
+    {
+        section.m_offset = offset;
+        section.m_count = count;
+        offset += (count * recordSize + 7) & ~static_cast<uint64_t>(7);
+    };
+    placeSection(header.m_materials, materials.size(), sizeof(MaterialRecord));
+    placeSection(header.m_lights, lights.size(), sizeof(LightRecord));
+    placeSection(header.m_shapes, store.GetShapes().size(), sizeof(RT::ObjectStore::Shape));
+    placeSection(header.m_transforms, store.GetTransforms().size(), sizeof(RT::AffineMatrix));
+    placeSection(header.m_colors, store.GetColors().size(), sizeof(Vector3<double>));
+    placeSection(header.m_materialIndices, store.GetMaterialIndices().size(), sizeof(uint32_t));
+    placeSection(header.m_sphereCentres, store.GetSphereCentres().size(), sizeof(Vector3<double>));
+    placeSection(header.m_nodes, bvh.GetNodes().size(), sizeof(RT::BVH::Node));
+    placeSection(header.m_meshes, meshes.size(), sizeof(MeshRecord));
+    placeSection(header.m_meshPositions, meshPositions.size(), sizeof(float));
+    placeSection(header.m_meshNormals, meshNormals.size(), sizeof(float));
+    placeSection(header.m_meshIndices, meshIndexValues.size(), sizeof(uint32_t));
+    placeSection(header.m_meshNodes, meshNodes.size(), sizeof(RT::MeshGeometry::Node));
+    header.m_numBounded = bvh.GetNumBounded();
+    header.m_fileSize = offset;
+
+    /*
+        Write to a temporary file and then replace the file with it, rather than writing over
+        the file, which may be the one that the scene was loaded from and is still using
+    */
+    std::string tempFileName = fileName + ".tmp";
+    FILE *file = std::fopen(tempFileName.c_str(), "wb");
+    if (file == nullptr)
+        return Fail("could not create the file");
+
+    // Function to write a section followed by the padding that placeSection allowed for
+    auto writeSection = [file](const void *data, size_t count, size_t recordSize)
+    {
+        const char padding[8] = {};
+        size_t paddingSize = ((count * recordSize + 7) & ~static_cast<size_t>(7)) - count * recordSize;
+        return (std::fwrite(data, recordSize, count, file) == count) && (std::fwrite(padding, 1, paddingSize, file) == paddingSize);
+    };
+
+    bool written = (std::fwrite(&header, sizeof(header), 1, file) == 1);
+    written = written && writeSection(materials.data(), materials.size(), sizeof(MaterialRecord));
+    written = written && writeSection(lights.data(), lights.size(), sizeof(LightRecord));
+    written = written && writeSection(store.GetShapes().data(), store.GetShapes().size(), sizeof(RT::ObjectStore::Shape));
+    written = written && writeSection(store.GetTransforms().data(), store.GetTransforms().size(), sizeof(RT::AffineMatrix));
+    written = written && writeSection(store.GetColors().data(), store.GetColors().size(), sizeof(Vector3<double>));
+    written = written && writeSection(store.GetMaterialIndices().data(), store.GetMaterialIndices().size(), sizeof(uint32_t));
+    written = written && writeSection(store.GetSphereCentres().data(), store.GetSphereCentres().size(), sizeof(Vector3<double>));
+    written = written && writeSection(bvh.GetNodes().data(), bvh.GetNodes().size(), sizeof(RT::BVH::Node));
+    written = written && writeSection(meshes.data(), meshes.size(), sizeof(MeshRecord));
+    written = written && writeSection(meshPositions.data(), meshPositions.size(), sizeof(float));
+    written = written && writeSection(meshNormals.data(), meshNormals.size(), sizeof(float));
+    written = written && writeSection(meshIndexValues.data(), meshIndexValues.size(), sizeof(uint32_t));
+    written = written && writeSection(meshNodes.data(), meshNodes.size(), sizeof(RT::MeshGeometry::Node));
+    written = (std::fclose(file) == 0) && written;
+    if (!written)
+    {
+        std::remove(tempFileName.c_str());
+        return Fail("could not write the file");
+    }
+
+    // Renaming over an existing file fails on some systems, so remove it and try again
+    if ((std::rename(tempFileName.c_str(), fileName.c_str()) != 0) &&
+        ((std::remove(fileName.c_str()) != 0) || (std::rename(tempFileName.c_str(), fileName.c_str()) != 0)))
+    {
+        std::remove(tempFileName.c_str());
+        return Fail("could not replace the file");
+    }
+
+    return true;
+}
+
+// Function to load a compiled scene
+bool RT::CompiledScene::Load(const std::string &fileName, RT::Scene &scene)
+{
+    m_fileName = fileName;
+    m_error.clear();
+    if (!IsLittleEndian())
+        return Fail("compiled scenes are only supported on little-endian machines");
+
+    // The mapping is shared by the arrays that use it in place, and is closed when the last of them goes
+    auto pFile = std::make_shared<RT::MappedFile> ();
+    if (!pFile -> Open(fileName))
+        return Fail("could not open the file");
+
+    const RT::MappedFile &file = *pFile;
+
+    // Check the header before anything is read through it
+    if (file.GetSize() < sizeof(FileHeader) || (std::memcmp(file.GetData(), MAGIC, sizeof(MAGIC)) != 0))
+        return Fail("not a compiled scene");
+
+    const FileHeader &header = *reinterpret_cast<const FileHeader *>(file.GetData());
+    if (header.m_version != VERSION)
+        return Fail("compiled with format version " + std::to_string(header.m_version) + ", expected version " + std::to_string(VERSION));
+    if ((header.m_headerSize != sizeof(FileHeader)) || (header.m_fileSize != file.GetSize()))
+        return Fail("the file is truncated or corrupt");
+
+    const MaterialRecord *materialRecords = GetSection<MaterialRecord>(file, header.m_materials);
+    const LightRecord *lightRecords = GetSection<LightRecord>(file, header.m_lights);
+    const RT::ObjectStore::Shape *shapes = GetSection<RT::ObjectStore::Shape>(file, header.m_shapes);
+    const RT::AffineMatrix *transforms = GetSection<RT::AffineMatrix>(file, header.m_transforms);
+    const Vector3<double> *colors = GetSection<Vector3<double>>(file, header.m_colors);
+    const uint32_t *materialIndices = GetSection<uint32_t>(file, header.m_materialIndices);
+    const Vector3<double> *sphereCentres = GetSection<Vector3<double>>(file, header.m_sphereCentres);
+    const RT::BVH::Node *nodes = GetSection<RT::BVH::Node>(file, header.m_nodes);
+    const MeshRecord *meshRecords = GetSection<MeshRecord>(file, header.m_meshes);
+    const float *meshPositions = GetSection<float>(file, header.m_meshPositions);
+    const float *meshNormals = GetSection<float>(file, header.m_meshNormals);
+    const uint32_t *meshIndices = GetSection<uint32_t>(file, header.m_meshIndices);
+    const RT::MeshGeometry::Node *meshNodes = GetSection<RT::MeshGeometry::Node>(file, header.m_meshNodes);
+    if (!materialRecords || !lightRecords || !shapes || !transforms || !colors || !materialIndices || !sphereCentres || !nodes)
+        return Fail("the file is truncated or corrupt");
+    if (!meshRecords || !meshPositions || !meshNormals || !meshIndices || !meshNodes)
+        return Fail("the file is truncated or corrupt");
+
+    int numMaterials = static_cast<int>(header.m_materials.m_count);
+    int numLights = static_cast<int>(header.m_lights.m_count);
+    int numMeshes = static_cast<int>(header.m_meshes.m_count);
+    if (header.m_numBounded > header.m_shapes.m_count)
+        return Fail("the BVH does not match the objects");
+
+    // Only the materials, lights and distinct meshes are created, which are few even in large scenes
+    std::vector<std::shared_ptr<RT::MaterialBase>> materials (numMaterials);
+    for (int i = 0; i < numMaterials; ++i)
+    {
+        auto material = std::make_shared<RT::SimpleMaterial> ();
+        material -> m_baseColor = FromArray(materialRecords[i].m_color);
+        material -> m_reflectivity = materialRecords[i].m_reflectivity;
+        material -> m_shininess = materialRecords[i].m_shininess;
+        materials[i] = material;
+    }
+
+    // The mesh geometry uses its arrays and its saved triangle BVH in place, which Restore checks against each other
+    std::vector<std::shared_ptr<const RT::MeshGeometry>> meshes (numMeshes);
+    for (int i = 0; i < numMeshes; ++i)
+    {
+        const MeshRecord &record = meshRecords[i];
+        RT::MappableArray<float> positions, normals;
+        RT::MappableArray<uint32_t> indices;
+        RT::MappableArray<RT::MeshGeometry::Node> meshNodeList;
+        bool mapped = MapRange(meshPositions, header.m_meshPositions, record.m_positions, pFile, positions);
+        mapped = mapped && MapRange(meshNormals, header.m_meshNormals, record.m_normals, pFile, normals);
+        mapped = mapped && MapRange(meshIndices, header.m_meshIndices, record.m_indices, pFile, indices);
+        mapped = mapped && MapRange(meshNodes, header.m_meshNodes, record.m_nodes, pFile, meshNodeList);
+
+        auto geometry = std::make_shared<RT::MeshGeometry> ();
+        if (!mapped || !geometry -> Restore(std::move(positions), std::move(indices), std::move(normals), std::move(meshNodeList)))
+            return Fail("mesh " + std::to_string(i) + " is corrupt");
+        meshes[i] = geometry;
+    }
+
+    std::vector<std::shared_ptr<RT::LightBase>> lights (numLights);
+    for (int i = 0; i < numLights; ++i)
+    {
+        auto light = std::make_shared<RT::PointLight> ();
+        light -> m_location = FromArray(lightRecords[i].m_position);
+        light -> m_color = FromArray(lightRecords[i].m_color);
+        light -> m_intensity = lightRecords[i].m_intensity;
+        lights[i] = light;
+    }
+
+    // The objects and the tree are used in place, so nothing is created for each object
+    RT::BVH bvh;
+    bool restored = bvh.GetObjects().Restore
+    (
+        MapSection(shapes, header.m_shapes, pFile), MapSection(transforms, header.m_transforms, pFile),
+        MapSection(colors, header.m_colors, pFile), MapSection(materialIndices, header.m_materialIndices, pFile),
+        MapSection(sphereCentres, header.m_sphereCentres, pFile), std::move(materials), std::move(meshes)
+    );
+    if (!restored)
+        return Fail("the objects are corrupt");
+
+    if (!bvh.Restore(MapSection(nodes, header.m_nodes, pFile), static_cast<int>(header.m_numBounded)))
+        return Fail("the BVH does not match the objects");
+
+    // Everything loaded, so replace the contents of the scene
+    RT::Camera &camera = scene.GetCamera();
+    camera.SetPosition(FromArray(header.m_cameraPosition));
+    camera.SetLookAt(FromArray(header.m_cameraLookAt));
+    camera.SetUp(FromArray(header.m_cameraUp));
+    camera.SetLength(header.m_cameraLength);
+    camera.SetHorzSize(header.m_cameraHorzSize);
+    camera.SetAspect(header.m_cameraAspect);
+    camera.UpdateCameraGeometry();
+
+    scene.ClearScene();
+    for (const auto &light : lights)
+        scene.AddLight(light);
+    scene.SetBVH(std::move(bvh));
+
+    return true;
+}
+
+// Function to test whether a file is a compiled scene
+bool RT::CompiledScene::IsCompiledScene(const std::string &fileName)
+{
+    FILE *file = std::fopen(fileName.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+
+    char magic[sizeof(MAGIC)];
+    bool matches = (std::fread(magic, 1, sizeof(magic), file) == sizeof(magic)) && (std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0);
+    std::fclose(file);
+    return matches;
+}
+
+// Function to return the last error
+const std::string &RT::CompiledScene::GetError() const
+{
+    return m_error;
+}
+
+// Function to record an error
+bool RT::CompiledScene::Fail(const std::string &message)
+{
+    m_error = m_fileName + ": " + message;
+    return false;
+}
@@ -0,0 +1,71 @@
+#ifndef COMPILEDSCENE_H
+#define COMPILEDSCENE_H
+
+#include <cstdint>
+#include <string>
+#include "scene.hpp"
+
+namespace RT
+{
+    /*
+        Saves a scene as a compiled binary file, and loads one back. The file holds
+        everything that is otherwise worked out at startup: the materials, the lights, the
+        camera, the arrays of the scene's ObjectStore, the BVH nodes and the triangles of
+        each mesh together with their BVH.
+
+        Loading maps the file into memory and uses the object arrays, the BVH nodes and the
+        mesh arrays in place, as views of the mapping (see MappableArray), so nothing is
+        created or copied for each object and neither BVH is rebuilt. Only the materials,
+        the lights and one MeshGeometry per distinct mesh are created. The mapping stays
+        open for as long as the scene uses it, and the file must not be changed by anything
+        else in the meantime. Save never writes over a file in place, so a scene can be
+        saved over the file it was loaded from.
+
+        The layout is fixed-size little-endian records after a header that holds the
+        format version and the offset and count of each section, each starting on an
+        8 byte boundary:
+
+            header | materials | lights | object shapes | object transforms |
+            object colors | object material indices | sphere centres | BVH nodes |
+            meshes | mesh positions | mesh normals | mesh indices | mesh BVH nodes
+
+        The object sections are the arrays of the ObjectStore, already in tree order. Mesh
+        geometry that is shared between instances is saved once. Only SimpleMaterials,
+        spheres, planes, meshes and point lights can be compiled.
+    */
+    class CompiledScene
+    {
+        public:
+            // The version of the file format, which changes whenever the layout does
+            static constexpr uint32_t VERSION = 3;
+
+            // The default constructor
+            CompiledScene();
+
+            // Function to save a scene. Returns false on an error, see GetError
+            bool Save(const std::string &fileName, RT::Scene &scene);
+
+            /*
+                Function to load a compiled scene, replacing the objects and lights of the scene
+                and setting up its camera. Returns false, leaving the scene unchanged, if the file
+                cannot be read, is not a compiled scene of this version or is inconsistent
+            */
+            bool Load(const std::string &fileName, RT::Scene &scene);
+
+            // Function to test whether a file starts like a compiled scene
+            static bool IsCompiledScene(const std::string &fileName);
+
+            // Function to return the description of the last error
+            const std::string &GetError() const;
+
+        private:
+            // Function to record an error. Always returns false
+            bool Fail(const std::string &message);
+
+        private:
+            std::string m_fileName;
+            std::string m_error;
+    };
+}
+
+#endif
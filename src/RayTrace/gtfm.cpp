@@ -1,11 +1,13 @@
 #include "gtfm.hpp"
+#include <cmath>
 
 // The default constructor and destructor
 RT::GTform::GTform()
 {
     // Set forward and backward transforms to identify matrices
-    m_fwdtfm.SetToIdentity();
-    m_bcktfm.SetToIdentity();
+    Matrix44<double> identity;
+    identity.SetToIdentity();
+    SetMatrices(identity, identity);
 }
 
 RT::GTform::~GTform()
@@ -14,6 +16,11 @@ RT::GTform::~GTform()
 }
 
 // Construct from a pair of matrices
+RT::GTform::GTform(const Matrix44<double> &fwd, const Matrix44<double> &bck)
+{
+    SetMatrices(fwd, bck);
+}
+
 RT::GTform::GTform(const Matrix2<double> &fwd, const Matrix2<double> &bck)
 {
     // Verify that the inputs are 4x4
@@ -25,23 +32,101 @@ RT::GTform::GTform(const Matrix2<double> &fwd, const Matrix2<double> &bck)
         throw std::invalid_argument("Cannot construct GTform, inputs are not all 4x4");
     }
 
-    m_fwdtfm = fwd;
-    m_bcktfm = bck;
+    Matrix44<double> fwd44;
+    Matrix44<double> bck44;
+    for (int row = 0; row < 4; ++row)
+    {
+        for (int col = 0; col < 4; ++col)
+        {
+            fwd44.SetElement(row, col, fwd.GetElement(row, col));
+            bck44.SetElement(row, col, bck.GetElement(row, col));
+        }
+    }
+
+    SetMatrices(fwd44, bck44);
+}
+
+RT::GTform::GTform(const RT::AffineMatrix &fwd, const RT::AffineMatrix &bck)
+    : m_fwdtfm(fwd), m_bcktfm(bck)
+{
+
+}
+
+// Function to store the top three rows of a pair of affine matrices
+void RT::GTform::SetMatrices(const Matrix44<double> &fwd, const Matrix44<double> &bck)
+{
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int col = 0; col < 4; ++col)
+        {
+            m_fwdtfm.m[row][col] = fwd.GetElement(row, col);
+            m_bcktfm.m[row][col] = bck.GetElement(row, col);
+        }
+    }
+}
+
+// Function to invert an affine matrix
+bool RT::AffineMatrix::Inverse(RT::AffineMatrix &result) const
+{
+    // The cofactors of the linear part, which are the transpose of its adjugate
+    double c00 = (m[1][1] * m[2][2]) - (m[1][2] * m[2][1]);
+    double c01 = (m[1][2] * m[2][0]) - (m[1][0] * m[2][2]);
+    double c02 = (m[1][0] * m[2][1]) - (m[1][1] * m[2][0]);
+    double determinant = (m[0][0] * c00) + (m[0][1] * c01) + (m[0][2] * c02);
+
+    // Compare the determinant with the volume spanned by rows of the same lengths
+    double rowLengths = 1.0;
+    for (int row = 0; row < 3; ++row)
+        rowLengths *= std::sqrt((m[row][0] * m[row][0]) + (m[row][1] * m[row][1]) + (m[row][2] * m[row][2]));
+    if (!(std::fabs(determinant) > 1e-12 * rowLengths))
+        return false;
+
+    double invDet = 1.0 / determinant;
+    double linear[3][3] =
+    {
+        {c00 * invDet, ((m[0][2] * m[2][1]) - (m[0][1] * m[2][2])) * invDet, ((m[0][1] * m[1][2]) - (m[0][2] * m[1][1])) * invDet},
+        {c01 * invDet, ((m[0][0] * m[2][2]) - (m[0][2] * m[2][0])) * invDet, ((m[0][2] * m[1][0]) - (m[0][0] * m[1][2])) * invDet},
+        {c02 * invDet, ((m[0][1] * m[2][0]) - (m[0][0] * m[2][1])) * invDet, ((m[0][0] * m[1][1]) - (m[0][1] * m[1][0])) * invDet}
+    };
+
+    // The inverse translation is the translation taken back through the inverse linear part
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int col = 0; col < 3; ++col)
+            result.m[row][col] = linear[row][col];
+        result.m[row][3] = -((linear[row][0] * m[0][3]) + (linear[row][1] * m[1][3]) + (linear[row][2] * m[2][3]));
+    }
+
+    return true;
+}
+
+// Function to expand an affine matrix to 4x4
+Matrix44<double> RT::GTform::ToMatrix44(const RT::AffineMatrix &matrix)
+{
+    Matrix44<double> result;
+    result.SetToIdentity();
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int col = 0; col < 4; ++col)
+            result.SetElement(row, col, matrix.m[row][col]);
+    }
+
+    return result;
 }
 
 // Function to set the transform
-void RT::GTform::SetTransform
+bool RT::GTform::SetTransform
 (
-    const Vector<double> &translation,
-	const Vector<double> &rotation,
-	const Vector<double> &scale
+    const Vector3<double> &translation,
+	const Vector3<double> &rotation,
+	const Vector3<double> &scale
 ) {
 	// Define a matrix for each component of the transform
-	Matrix2<double> translationMatrix	{4, 4};
-	Matrix2<double> rotationMatrixX	{4, 4};
-	Matrix2<double>	rotationMatrixY	{4, 4};
-	Matrix2<double> rotationMatrixZ	{4, 4};
-	Matrix2<double>	scaleMatrix	{4, 4};
+	Matrix44<double> translationMatrix;
+	Matrix44<double> rotationMatrixX;
+	Matrix44<double> rotationMatrixY;
+	Matrix44<double> rotationMatrixZ;
+	Matrix44<double> scaleMatrix;
 	
 	// Set these to identity
 	translationMatrix.SetToIdentity();
@@ -78,86 +163,36 @@ void RT::GTform::SetTransform
 	scaleMatrix.SetElement(2, 2, scale.GetElement(2));
 	
 	// Combine to give the final forward transform matrix
-	m_fwdtfm = translationMatrix * 
+	Matrix44<double> fwdMatrix = translationMatrix * 
 		scaleMatrix *
 		rotationMatrixX *
 		rotationMatrixY *
 		rotationMatrixZ;
 							
-	// Compute the backwards transform
-	m_bcktfm = m_fwdtfm;
-	m_bcktfm.Inverse();
-}
+	// Compute the backwards transform, keeping the current transform if there is none
+	RT::AffineMatrix fwdtfm;
+	RT::AffineMatrix bcktfm;
+	for (int row = 0; row < 3; ++row)
+	{
+		for (int col = 0; col < 4; ++col)
+			fwdtfm.m[row][col] = fwdMatrix.GetElement(row, col);
+	}
+	if (!fwdtfm.Inverse(bcktfm))
+		return false;
 
-// Functions to return the transform matrices
-Matrix2<double> RT::GTform::GetForward()
-{
-    return m_fwdtfm;
-}
-Matrix2<double> RT::GTform::GetBackward()
-{
-    return m_bcktfm;
+	m_fwdtfm = fwdtfm;
+	m_bcktfm = bcktfm;
+	return true;
 }
 
-// Function to apply the transform
-RT::Ray RT::GTform::Apply(const RT::Ray &inputRay, bool dirFlag)
+// Functions to return the transform matrices
+Matrix44<double> RT::GTform::GetForward() const
 {
-    // Create an input object
-    RT::Ray outputRay;
-
-    if (dirFlag)
-	{
-		// Apply the forward transform
-		outputRay.m_point1 = this -> Apply(inputRay.m_point1, RT::FWDTFORM);
-		outputRay.m_point2 = this -> Apply(inputRay.m_point2, RT::FWDTFORM);
-		outputRay.m_lab = outputRay.m_point2 - outputRay.m_point1;
-	}
-	else
-	{
-		// Apply the backward transform
-		outputRay.m_point1 = this -> Apply(inputRay.m_point1, RT::BCKTFORM);
-		outputRay.m_point2 = this -> Apply(inputRay.m_point2, RT::BCKTFORM);
-		outputRay.m_lab = outputRay.m_point2 - outputRay.m_point1;
-	}
-	
-	return outputRay;
+    return ToMatrix44(m_fwdtfm);
 }
-
-Vector<double> RT::GTform::Apply(const Vector<double> &inputVector, bool dirFlag)
+Matrix44<double> RT::GTform::GetBackward() const
 {
-	// Convert inputVector to a 4-element vector.
-	std::vector<double> tempData
-    {
-        inputVector.GetElement(0),
-		inputVector.GetElement(1),
-		inputVector.GetElement(2),
-		1.0
-    };
-	Vector<double> tempVector {tempData};
-	
-	// Create a vector for the result
-	Vector<double> resultVector;
-	
-	if (dirFlag)
-	{
-		// Apply the forward transform
-		resultVector = m_fwdtfm * tempVector;
-	}
-	else
-	{
-		// Apply the backward transform
-		resultVector = m_bcktfm * tempVector;
-	}
-	
-	// Reform the output as a 3-element vector
-	Vector<double> outputVector {std::vector<double>
-    {
-        resultVector.GetElement(0),
-		resultVector.GetElement(1),
-		resultVector.GetElement(2)
-    }};
-																					
-	return outputVector;
+    return ToMatrix44(m_bcktfm);
 }
 
 // Overload operators.
@@ -166,32 +201,26 @@ namespace RT
 	RT::GTform operator* (const RT::GTform &lhs, const RT::GTform &rhs)
 	{
 		// Form the product of the two forward transforms.
-		Matrix2<double> fwdResult = lhs.m_fwdtfm * rhs.m_fwdtfm;
+		Matrix44<double> fwdResult = GTform::ToMatrix44(lhs.m_fwdtfm) * GTform::ToMatrix44(rhs.m_fwdtfm);
 		
 		// Compute the backward transform as the inverse of the forward transform.
-		Matrix2<double> bckResult = fwdResult;
-		bckResult.Inverse();
+		RT::AffineMatrix fwdtfm;
+		RT::AffineMatrix bcktfm;
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int col = 0; col < 4; ++col)
+				fwdtfm.m[row][col] = fwdResult.GetElement(row, col);
+		}
+		if (!fwdtfm.Inverse(bcktfm))
+			throw std::invalid_argument("Cannot multiply GTforms, the product cannot be inverted");
 		
 		// Form the final result.
-		RT::GTform finalResult (fwdResult, bckResult);
+		RT::GTform finalResult (fwdtfm, bcktfm);
 		
 		return finalResult;
 	}
 }
 
-// Overload the assignment operator
-RT::GTform RT::GTform::operator= (const RT::GTform &rhs)
-{
-	// Make sure that we're not assigning to ourself
-	if (this != &rhs)
-	{
-		m_fwdtfm = rhs.m_fwdtfm;
-		m_bcktfm = rhs.m_bcktfm;
-	}
-	
-	return *this;
-}
-
 // Function to print the transform matrix to STDOUT
 void RT::GTform::PrintMatrix(bool dirFlag)
 {
@@ -205,22 +234,21 @@ void RT::GTform::PrintMatrix(bool dirFlag)
 	}
 }
 
-void RT::GTform::Print(const Matrix2<double> &matrix)
+void RT::GTform::Print(const RT::AffineMatrix &matrix)
 {
-	int nRows = matrix.GetNumRows();
-	int nCols = matrix.GetNumCols();
-	for (int row = 0; row<nRows; ++row)
+	Matrix44<double> fullMatrix = ToMatrix44(matrix);
+	for (int row = 0; row<4; ++row)
 	{
-		for (int col = 0; col<nCols; ++col)
+		for (int col = 0; col<4; ++col)
 		{
-			std::cout << std::fixed << std::setprecision(3) << matrix.GetElement(row, col) << " ";
+			std::cout << std::fixed << std::setprecision(3) << fullMatrix.GetElement(row, col) << " ";
 		}
 		std::cout << std::endl;
 	}
 }
 
 // Function to print vectors
-void RT::GTform::PrintVector(const Vector<double> &inputVector)
+void RT::GTform::PrintVector(const Vector3<double> &inputVector)
 {
 	int nRows = inputVector.GetNumDims();
 	for (int row = 0; row < nRows; ++row)
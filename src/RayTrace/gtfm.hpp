@@ -1,8 +1,9 @@
 #ifndef GTFM_H
 #define GTFM_H
 
-#include "../LinAlg/Vector.h"
+#include "../LinAlg/Vector3.hpp"
 #include "../LinAlg/Matrix.h"
+#include "../LinAlg/Matrix44.hpp"
 #include "ray.hpp"
 
 namespace RT
@@ -11,6 +12,70 @@ namespace RT
     constexpr bool FWDTFORM = true;
     constexpr bool BCKTFORM = false;
 
+    /*
+        The top three rows of a 4x4 affine transform matrix, stored row-major. The bottom
+        row is always (0, 0, 0, 1), so it is not stored and the transforms below skip it.
+        This is a plain fixed-size array, so transforming a point, direction or ray
+        never allocates
+    */
+    struct AffineMatrix
+    {
+        double m[3][4];
+
+        // Function to transform a point (x, y, z, 1)
+        inline Vector3<double> TransformPoint(const Vector3<double> &p) const
+        {
+            return Vector3<double>
+            {
+                (m[0][0] * p.m_x) + (m[0][1] * p.m_y) + (m[0][2] * p.m_z) + m[0][3],
+                (m[1][0] * p.m_x) + (m[1][1] * p.m_y) + (m[1][2] * p.m_z) + m[1][3],
+                (m[2][0] * p.m_x) + (m[2][1] * p.m_y) + (m[2][2] * p.m_z) + m[2][3]
+            };
+        }
+
+        // Function to transform a direction (x, y, z, 0), ignoring the translation
+        inline Vector3<double> TransformDirection(const Vector3<double> &d) const
+        {
+            return Vector3<double>
+            {
+                (m[0][0] * d.m_x) + (m[0][1] * d.m_y) + (m[0][2] * d.m_z),
+                (m[1][0] * d.m_x) + (m[1][1] * d.m_y) + (m[1][2] * d.m_z),
+                (m[2][0] * d.m_x) + (m[2][1] * d.m_y) + (m[2][2] * d.m_z)
+            };
+        }
+
+        // Function to transform a ray. The ray parameter is unchanged by an affine transform, so the interval carries over
+        inline RT::Ray TransformRay(const RT::Ray &inputRay) const
+        {
+            // Transform the origin as a point and m_lab as a direction, then rebuild the second point
+            RT::Ray outputRay;
+            outputRay.m_point1 = TransformPoint(inputRay.m_point1);
+            outputRay.m_lab = TransformDirection(inputRay.m_lab);
+            outputRay.m_point2 = outputRay.m_point1 + outputRay.m_lab;
+            outputRay.m_tMin = inputRay.m_tMin;
+            outputRay.m_tMax = inputRay.m_tMax;
+            return outputRay;
+        }
+
+        // Function to transform a direction by the transpose of the linear part
+        inline Vector3<double> TransformTransposed(const Vector3<double> &d) const
+        {
+            return Vector3<double>
+            {
+                (m[0][0] * d.m_x) + (m[1][0] * d.m_y) + (m[2][0] * d.m_z),
+                (m[0][1] * d.m_x) + (m[1][1] * d.m_y) + (m[2][1] * d.m_z),
+                (m[0][2] * d.m_x) + (m[1][2] * d.m_y) + (m[2][2] * d.m_z)
+            };
+        }
+
+        /*
+            Function to compute the inverse transform. Returns false, leaving result unchanged, if
+            the linear part is singular, judged relative to the size of its rows so that uniformly
+            small (or large) scales are still inverted
+        */
+        bool Inverse(AffineMatrix &result) const;
+    };
+
     class GTform
     {
         public:
@@ -19,43 +84,87 @@ namespace RT
             ~GTform();
 
             // Construct from a pair of matrices
+            GTform(const Matrix44<double> &fwd, const Matrix44<double> &bck);
             GTform(const Matrix2<double> &fwd, const Matrix2<double> &bck);
 
-            // Function to set translation, rotation and scale components
-            void SetTransform
+            // Construct from a pair of affine matrices, eg. saved ones. bck must be the inverse of fwd
+            GTform(const RT::AffineMatrix &fwd, const RT::AffineMatrix &bck);
+
+            /*
+                Function to set translation, rotation and scale components. Returns false, leaving
+                the transform unchanged, if it cannot be inverted (eg. a scale is zero)
+            */
+            bool SetTransform
             (
-                const Vector<double> &translation,
-                const Vector<double> &rotation,
-                const Vector<double> &scale
+                const Vector3<double> &translation,
+                const Vector3<double> &rotation,
+                const Vector3<double> &scale
             );
 
             // Functions to return the transform matrices
-            Matrix2<double> GetForward();
-            Matrix2<double> GetBackward();
+            Matrix44<double> GetForward() const;
+            Matrix44<double> GetBackward() const;
 
             // Function to apply the transform
-            RT::Ray Apply(const RT::Ray &inputRay, bool dirFlag);
-            Vector<double> Apply(const Vector<double> &inputVector, bool dirFlag);
+            RT::Ray Apply(const RT::Ray &inputRay, bool dirFlag) const;
+            Vector3<double> Apply(const Vector3<double> &inputVector, bool dirFlag) const;
 
-            // Overload operators
-            friend GTform operator* (const RT::GTform &lhs, const RT::GTform &rhs);
+            // Function to apply the transform to a direction, ignoring the translation
+            Vector3<double> ApplyDirection(const Vector3<double> &inputVector, bool dirFlag) const;
+
+            /*
+                Function to transform a normal from local into world coordinates (using the
+                transpose of the backward transform). The result is not normalized
+            */
+            Vector3<double> ApplyNormal(const Vector3<double> &inputNormal) const;
 
-            // Overload the assignment operator
-            GTform operator= (const GTform &rhs);
+            // Function to return the affine matrix for one direction (eg. for the packet kernels)
+            const RT::AffineMatrix &GetAffine(bool dirFlag) const;
+
+            // Overload operators. Throws std::invalid_argument if the product cannot be inverted
+            friend GTform operator* (const RT::GTform &lhs, const RT::GTform &rhs);
 
             // Function to print matrix to STDOUT
             void PrintMatrix(bool dirFlag);
 
             // Function to allow printing of vectors
-            static void PrintVector(const Vector<double> &vector);
+            static void PrintVector(const Vector3<double> &vector);
         
         private:
-            void Print(const Matrix2<double> &matrix);
+            void Print(const RT::AffineMatrix &matrix);
+            void SetMatrices(const Matrix44<double> &fwd, const Matrix44<double> &bck);
+            static Matrix44<double> ToMatrix44(const RT::AffineMatrix &matrix);
         
         private:
-            Matrix2<double> m_fwdtfm {4, 4};
-            Matrix2<double> m_bcktfm {4, 4};
+            RT::AffineMatrix m_fwdtfm;
+            RT::AffineMatrix m_bcktfm;
     };
+
+    // The transforms are on the path of every ray, so they are defined inline
+    inline RT::Ray GTform::Apply(const RT::Ray &inputRay, bool dirFlag) const
+    {
+        return (dirFlag ? m_fwdtfm : m_bcktfm).TransformRay(inputRay);
+    }
+
+    inline Vector3<double> GTform::Apply(const Vector3<double> &inputVector, bool dirFlag) const
+    {
+        return (dirFlag ? m_fwdtfm : m_bcktfm).TransformPoint(inputVector);
+    }
+
+    inline Vector3<double> GTform::ApplyDirection(const Vector3<double> &inputVector, bool dirFlag) const
+    {
+        return (dirFlag ? m_fwdtfm : m_bcktfm).TransformDirection(inputVector);
+    }
+
+    inline const RT::AffineMatrix &GTform::GetAffine(bool dirFlag) const
+    {
+        return dirFlag ? m_fwdtfm : m_bcktfm;
+    }
+
+    inline Vector3<double> GTform::ApplyNormal(const Vector3<double> &inputNormal) const
+    {
+        return m_bcktfm.TransformTransposed(inputNormal);
+    }
 }
 
-#endif
\ No newline at end of file
+#endif
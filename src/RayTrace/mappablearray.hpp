@@ -0,0 +1,182 @@
+#ifndef MAPPABLEARRAY_H
+#define MAPPABLEARRAY_H
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace RT
+{
+    /*
+        An array of trivially copyable elements that either owns them, in a std::vector, or
+        views elements that live elsewhere, such as in a file mapped with MappedFile. A view
+        holds a shared_ptr to whatever keeps the elements alive, so the mapping stays open
+        for as long as any array uses it.
+
+        The array has the parts of the std::vector interface that the ray tracer uses. Reading
+        goes straight through a pointer to the elements, so it costs the same either way.
+        Functions that change the array first copy a view into owned storage (copy on write),
+        so a view is never written to.
+    */
+    template <typename T>
+    class MappableArray
+    {
+        public:
+            // The default constructor, which makes an empty array
+            MappableArray()
+            {
+
+            }
+
+            // Constructor to take ownership of the elements of a vector
+            MappableArray(std::vector<T> values)
+                : m_values(std::move(values))
+            {
+                Point();
+            }
+
+            // Copying copies owned elements and shares viewed ones
+            MappableArray(const MappableArray &other)
+                : m_values(other.m_values), m_pData(other.m_pData), m_size(other.m_size), m_pKeepAlive(other.m_pKeepAlive)
+            {
+                if (!m_pKeepAlive)
+                    Point();
+            }
+
+            MappableArray(MappableArray &&other) noexcept
+                : m_values(std::move(other.m_values)), m_pData(other.m_pData), m_size(other.m_size), m_pKeepAlive(std::move(other.m_pKeepAlive))
+            {
+                if (!m_pKeepAlive)
+                    Point();
+                other.Release();
+            }
+
+            MappableArray &operator= (MappableArray other) noexcept
+            {
+                swap(other);
+                return *this;
+            }
+
+            /*
+                Function to view size elements at pData, replacing the contents of the array.
+                keepAlive, which must not be null, owns whatever keeps the elements valid and is
+                held until the array is changed or destroyed
+            */
+            void Map(const T *pData, size_t size, std::shared_ptr<const void> keepAlive)
+            {
+                Release();
+                m_pData = pData;
+                m_size = size;
+                m_pKeepAlive = std::move(keepAlive);
+            }
+
+            // Function to test whether the array is a view of elements that it does not own
+            bool IsMapped() const
+            {
+                return static_cast<bool>(m_pKeepAlive);
+            }
+
+            // Functions to read the elements
+            size_t size() const { return m_size; }
+            bool empty() const { return m_size == 0; }
+            const T *data() const { return m_pData; }
+            const T *begin() const { return m_pData; }
+            const T *end() const { return m_pData + m_size; }
+            const T &operator[] (size_t index) const { return m_pData[index]; }
+            const T &back() const { return m_pData[m_size - 1]; }
+
+            // Function to return the number of elements allocated, or the number viewed
+            size_t capacity() const { return IsMapped() ? m_size : m_values.capacity(); }
+
+            // Functions to change the elements, which copy a view first. Elements are only written
+            // through Modify, so that reading one never copies a view
+            T &Modify(size_t index)
+            {
+                Own();
+                return m_values[index];
+            }
+
+            void push_back(const T &value)
+            {
+                Own();
+                m_values.push_back(value);
+                Point();
+            }
+
+            void reserve(size_t capacity)
+            {
+                Own();
+                m_values.reserve(capacity);
+                Point();
+            }
+
+            void shrink_to_fit()
+            {
+                Own();
+                m_values.shrink_to_fit();
+                Point();
+            }
+
+            void assign(const T *first, const T *last)
+            {
+                Release();
+                m_values.assign(first, last);
+                Point();
+            }
+
+            void clear()
+            {
+                Release();
+            }
+
+            // Function to exchange the contents with another array
+            void swap(MappableArray &other) noexcept
+            {
+                m_values.swap(other.m_values);
+                std::swap(m_pData, other.m_pData);
+                std::swap(m_size, other.m_size);
+                m_pKeepAlive.swap(other.m_pKeepAlive);
+            }
+
+        private:
+            // Function to copy a view into owned storage
+            void Own()
+            {
+                if (IsMapped())
+                {
+                    m_values.assign(m_pData, m_pData + m_size);
+                    m_pKeepAlive.reset();
+                    Point();
+                }
+            }
+
+            // Function to empty the array, releasing any view
+            void Release()
+            {
+                m_values.clear();
+                m_pKeepAlive.reset();
+                Point();
+            }
+
+            // Function to point at the owned elements after they have changed
+            void Point()
+            {
+                m_pData = m_values.data();
+                m_size = m_values.size();
+            }
+
+        private:
+            // The owned elements, which are empty for a view
+            std::vector<T> m_values;
+
+            // The elements that are read, either those of m_values or those viewed
+            const T *m_pData = nullptr;
+            size_t m_size = 0;
+
+            // What keeps viewed elements alive, which is null when the array owns its elements
+            std::shared_ptr<const void> m_pKeepAlive;
+    };
+}
+
+#endif
@@ -0,0 +1,116 @@
+#include "mappedfile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// The default constructor and destructor
+RT::MappedFile::MappedFile()
+{
+
+}
+
+RT::MappedFile::~MappedFile()
+{
+    Close();
+}
+
+// Function to map a file
+bool RT::MappedFile::Open(const std::string &fileName)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    m_fileHandle = file;
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+    if (m_size == 0)
+        return true;
+
+    // A mapping cannot be made of an empty file, which is why that returns above
+    m_mappingHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_mappingHandle != NULL)
+        m_pData = static_cast<const char *>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+#else
+    int file = open(fileName.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat fileStatus;
+    if (fstat(file, &fileStatus) != 0)
+    {
+        close(file);
+        return false;
+    }
+
+    m_size = static_cast<size_t>(fileStatus.st_size);
+    if (m_size == 0)
+    {
+        close(file);
+        return true;
+    }
+
+    // The mapping stays valid after the file is closed
+    void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data != MAP_FAILED)
+        m_pData = static_cast<const char *>(data);
+#endif
+
+    if (m_pData == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+// Function to release the mapping
+void RT::MappedFile::Close()
+{
+#ifdef _WIN32
+    if (m_pData != nullptr)
+        UnmapViewOfFile(m_pData);
+    if (m_mappingHandle != nullptr)
+        CloseHandle(m_mappingHandle);
+    if (m_fileHandle != nullptr)
+        CloseHandle(m_fileHandle);
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+#else
+    if (m_pData != nullptr)
+        munmap(const_cast<char *>(m_pData), m_size);
+#endif
+
+    m_pData = nullptr;
+    m_size = 0;
+}
+
+// Functions to return the contents of the file
+const char *RT::MappedFile::GetData() const
+{
+    return m_pData;
+}
+
+size_t RT::MappedFile::GetSize() const
+{
+    return m_size;
+}
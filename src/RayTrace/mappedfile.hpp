@@ -0,0 +1,45 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace RT
+{
+    /*
+        A read-only memory mapping of a whole file, so that a file can be used in place
+        without reading it into a buffer first. The pages are only read from disk when
+        they are first touched. The mapping is released by Close or the destructor.
+    */
+    class MappedFile
+    {
+        public:
+            // The default constructor and destructor
+            MappedFile();
+            ~MappedFile();
+
+            MappedFile(const MappedFile &) = delete;
+            MappedFile &operator= (const MappedFile &) = delete;
+
+            // Function to map a file, replacing any earlier mapping. Returns false if it cannot be mapped
+            bool Open(const std::string &fileName);
+
+            // Function to release the mapping
+            void Close();
+
+            // Functions to return the contents of the file. An empty file has no data
+            const char *GetData() const;
+            size_t GetSize() const;
+
+        private:
+            const char *m_pData = nullptr;
+            size_t m_size = 0;
+
+#ifdef _WIN32
+            void *m_fileHandle = nullptr;
+            void *m_mappingHandle = nullptr;
+#endif
+    };
+}
+
+#endif
@@ -0,0 +1,383 @@
+#include "objectstore.hpp"
+#include "./Primatives/objsphere.hpp"
+#include "./Primatives/objplane.hpp"
+#include "./Primatives/objmesh.hpp"
+#include "packetkernels.hpp"
+#include <algorithm>
+#include <limits>
+
+// The default constructor
+RT::ObjectStore::ObjectStore()
+{
+
+}
+
+// Function to add a copy of an object
+bool RT::ObjectStore::Add(const RT::ObjectBase &object)
+{
+    Shape shape;
+    shape.m_type = static_cast<uint32_t>(object.GetPrimitiveType());
+    switch (object.GetPrimitiveType())
+    {
+        case RT::PrimitiveType::SPHERE:
+        {
+            // The centre is the translation column of the forward transform
+            const RT::AffineMatrix &fwdtfm = object.m_transformMatrix.GetAffine(RT::FWDTFORM);
+            shape.m_index = static_cast<uint32_t>(m_sphereCentres.size());
+            m_sphereCentres.push_back(Vector3<double>{fwdtfm.m[0][3], fwdtfm.m[1][3], fwdtfm.m[2][3]});
+            break;
+        }
+
+        case RT::PrimitiveType::PLANE:
+            shape.m_index = 0;
+            break;
+
+        case RT::PrimitiveType::MESH:
+        {
+            // Instances of the same geometry share one entry of the table
+            const auto &pGeometry = static_cast<const RT::ObjMesh &>(object).GetGeometry();
+            auto inserted = m_meshLookup.insert({pGeometry.get(), static_cast<uint32_t>(m_meshes.size())});
+            if (inserted.second)
+                m_meshes.push_back(pGeometry);
+            shape.m_index = inserted.first -> second;
+            break;
+        }
+
+        default:
+            return false;
+    }
+
+    // Objects that share a material share one entry of the table
+    uint32_t materialIndex = NO_MATERIAL;
+    if (object.m_hasMaterial && object.m_pMaterial)
+    {
+        auto inserted = m_materialLookup.insert({object.m_pMaterial.get(), static_cast<uint32_t>(m_materials.size())});
+        if (inserted.second)
+            m_materials.push_back(object.m_pMaterial);
+        materialIndex = inserted.first -> second;
+    }
+
+    m_shapes.push_back(shape);
+    m_transforms.push_back(object.m_transformMatrix.GetAffine(RT::BCKTFORM));
+    m_colors.push_back(object.m_baseColor);
+    m_materialIndices.push_back(materialIndex);
+    ++m_version;
+    return true;
+}
+
+// Function to use the arrays of another store
+bool RT::ObjectStore::Restore
+(
+    RT::MappableArray<Shape> shapes, RT::MappableArray<RT::AffineMatrix> transforms,
+    RT::MappableArray<Vector3<double>> colors, RT::MappableArray<uint32_t> materialIndices,
+    RT::MappableArray<Vector3<double>> sphereCentres,
+    std::vector<std::shared_ptr<RT::MaterialBase>> materials,
+    std::vector<std::shared_ptr<const RT::MeshGeometry>> meshes
+) {
+    // Check everything that the queries index, reading the arrays without changing them
+    size_t numObjects = shapes.size();
+    bool valid = (numObjects < NO_MATERIAL) && (transforms.size() == numObjects) && (colors.size() == numObjects);
+    valid = valid && (materialIndices.size() == numObjects) && (materials.size() < NO_MATERIAL);
+    for (size_t i = 0; valid && (i < materials.size()); ++i)
+        valid = (materials[i] != nullptr);
+    for (size_t i = 0; valid && (i < meshes.size()); ++i)
+        valid = (meshes[i] != nullptr);
+
+    for (size_t i = 0; valid && (i < numObjects); ++i)
+    {
+        const Shape &shape = shapes[i];
+        switch (static_cast<RT::PrimitiveType>(shape.m_type))
+        {
+            case RT::PrimitiveType::SPHERE: valid = (shape.m_index < sphereCentres.size()); break;
+            case RT::PrimitiveType::PLANE:  valid = true; break;
+            case RT::PrimitiveType::MESH:   valid = (shape.m_index < meshes.size()); break;
+            default: valid = false; break;
+        }
+
+        valid = valid && ((materialIndices[i] == NO_MATERIAL) || (materialIndices[i] < materials.size()));
+    }
+
+    if (!valid)
+        return false;
+
+    m_shapes = std::move(shapes);
+    m_transforms = std::move(transforms);
+    m_colors = std::move(colors);
+    m_materialIndices = std::move(materialIndices);
+    m_sphereCentres = std::move(sphereCentres);
+    m_materials = std::move(materials);
+    m_meshes = std::move(meshes);
+
+    // Objects added later share the table entries of these ones
+    m_materialLookup.clear();
+    m_meshLookup.clear();
+    for (size_t i = 0; i < m_materials.size(); ++i)
+        m_materialLookup.insert({m_materials[i].get(), static_cast<uint32_t>(i)});
+    for (size_t i = 0; i < m_meshes.size(); ++i)
+        m_meshLookup.insert({m_meshes[i].get(), static_cast<uint32_t>(i)});
+
+    ++m_version;
+    return true;
+}
+
+// Function to remove every object
+void RT::ObjectStore::Clear()
+{
+    m_shapes.clear();
+    m_transforms.clear();
+    m_colors.clear();
+    m_materialIndices.clear();
+    m_sphereCentres.clear();
+    m_materials.clear();
+    m_meshes.clear();
+    m_materialLookup.clear();
+    m_meshLookup.clear();
+    ++m_version;
+}
+
+// Function to return the number of objects
+RT::ObjectStore::Handle RT::ObjectStore::GetSize() const
+{
+    return static_cast<Handle>(m_shapes.size());
+}
+
+// Function to return the version counter
+uint32_t RT::ObjectStore::GetVersion() const
+{
+    return m_version;
+}
+
+// Functions to return the data of an object
+RT::PrimitiveType RT::ObjectStore::GetPrimitiveType(Handle handle) const
+{
+    return static_cast<RT::PrimitiveType>(m_shapes[handle].m_type);
+}
+
+const RT::AffineMatrix &RT::ObjectStore::GetTransform(Handle handle) const
+{
+    return m_transforms[handle];
+}
+
+const Vector3<double> &RT::ObjectStore::GetBaseColor(Handle handle) const
+{
+    return m_colors[handle];
+}
+
+RT::MaterialBase *RT::ObjectStore::GetMaterial(Handle handle) const
+{
+    uint32_t materialIndex = m_materialIndices[handle];
+    return (materialIndex == NO_MATERIAL) ? nullptr : m_materials[materialIndex].get();
+}
+
+const RT::MeshGeometry *RT::ObjectStore::GetMesh(Handle handle) const
+{
+    const Shape &shape = m_shapes[handle];
+    return (GetPrimitiveType(handle) == RT::PrimitiveType::MESH) ? m_meshes[shape.m_index].get() : nullptr;
+}
+
+// Function to return whether a ray leaving an object can hit it again. Only meshes need not be convex
+bool RT::ObjectStore::CanHitItself(Handle handle) const
+{
+    return GetPrimitiveType(handle) == RT::PrimitiveType::MESH;
+}
+
+// Function to compute the bounds of an object in world coordinates
+RT::AABB RT::ObjectStore::GetWorldBounds(Handle handle) const
+{
+    RT::AABB localBounds;
+    switch (GetPrimitiveType(handle))
+    {
+        case RT::PrimitiveType::SPHERE:
+            localBounds = RT::ObjSphere::UnitBounds();
+            break;
+
+        case RT::PrimitiveType::PLANE:
+            localBounds = RT::ObjPlane::UnitBounds();
+            break;
+
+        default:
+            localBounds = GetMesh(handle) -> GetBounds();
+            break;
+    }
+
+    RT::AffineMatrix fwdtfm;
+    if (!localBounds.IsBounded() || localBounds.IsEmpty() || !m_transforms[handle].Inverse(fwdtfm))
+        return localBounds;
+
+    // Transform the eight corners of the local box and bound the result
+    RT::AABB worldBounds;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        Vector3<double> localCorner
+        {
+            (corner & 1) ? localBounds.m_max.m_x : localBounds.m_min.m_x,
+            (corner & 2) ? localBounds.m_max.m_y : localBounds.m_min.m_y,
+            (corner & 4) ? localBounds.m_max.m_z : localBounds.m_min.m_z
+        };
+        worldBounds.Grow(fwdtfm.TransformPoint(localCorner));
+    }
+
+    // Pad the box slightly so that flat objects (such as planes) still have some thickness
+    Vector3<double> extent = worldBounds.m_max - worldBounds.m_min;
+    double pad = 1e-9 + 1e-9 * std::max(extent.m_x, std::max(extent.m_y, extent.m_z));
+    worldBounds.m_min = worldBounds.m_min - Vector3<double>{pad, pad, pad};
+    worldBounds.m_max = worldBounds.m_max + Vector3<double>{pad, pad, pad};
+
+    return worldBounds;
+}
+
+// Functions to return the arrays
+const RT::MappableArray<RT::ObjectStore::Shape> &RT::ObjectStore::GetShapes() const
+{
+    return m_shapes;
+}
+
+const RT::MappableArray<RT::AffineMatrix> &RT::ObjectStore::GetTransforms() const
+{
+    return m_transforms;
+}
+
+const RT::MappableArray<Vector3<double>> &RT::ObjectStore::GetColors() const
+{
+    return m_colors;
+}
+
+const RT::MappableArray<uint32_t> &RT::ObjectStore::GetMaterialIndices() const
+{
+    return m_materialIndices;
+}
+
+const RT::MappableArray<Vector3<double>> &RT::ObjectStore::GetSphereCentres() const
+{
+    return m_sphereCentres;
+}
+
+// Functions to return the shared tables
+const std::vector<std::shared_ptr<RT::MaterialBase>> &RT::ObjectStore::GetMaterials() const
+{
+    return m_materials;
+}
+
+const std::vector<std::shared_ptr<const RT::MeshGeometry>> &RT::ObjectStore::GetMeshes() const
+{
+    return m_meshes;
+}
+
+// Function to test an object for intersections
+bool RT::ObjectStore::TestIntersection
+(
+    Handle handle, const RT::Ray &castRay, Vector3<double> &intPoint,
+    Vector3<double> &localNormal, Vector3<double> &localColor
+) const {
+    const Shape &shape = m_shapes[handle];
+    const RT::AffineMatrix &bckTfm = m_transforms[handle];
+    bool hit = false;
+    switch (static_cast<RT::PrimitiveType>(shape.m_type))
+    {
+        case RT::PrimitiveType::SPHERE:
+            hit = RT::ObjSphere::Intersect(bckTfm, m_sphereCentres[shape.m_index], castRay, intPoint, localNormal);
+            break;
+
+        case RT::PrimitiveType::PLANE:
+            hit = RT::ObjPlane::Intersect(bckTfm, castRay, intPoint, localNormal);
+            break;
+
+        default:
+            hit = RT::ObjMesh::Intersect(bckTfm, *m_meshes[shape.m_index], castRay, intPoint, localNormal);
+            break;
+    }
+
+    if (hit)
+        localColor = m_colors[handle];
+
+    return hit;
+}
+
+// Function to test whether an object blocks a ray
+bool RT::ObjectStore::Occluded(Handle handle, const RT::Ray &castRay, double tMax) const
+{
+    const Shape &shape = m_shapes[handle];
+    const RT::AffineMatrix &bckTfm = m_transforms[handle];
+    switch (static_cast<RT::PrimitiveType>(shape.m_type))
+    {
+        case RT::PrimitiveType::SPHERE:
+            return RT::ObjSphere::Occludes(bckTfm, castRay, tMax);
+
+        case RT::PrimitiveType::PLANE:
+            return RT::ObjPlane::Occludes(bckTfm, castRay, tMax);
+
+        default:
+            return RT::ObjMesh::Occludes(bckTfm, *m_meshes[shape.m_index], castRay, tMax);
+    }
+}
+
+// Function to test a packet of rays against an object
+void RT::ObjectStore::TestIntersectionPacket(Handle handle, const RT::RayPacket &packet, double *tHit) const
+{
+    const Shape &shape = m_shapes[handle];
+    const RT::AffineMatrix &bckTfm = m_transforms[handle];
+    switch (static_cast<RT::PrimitiveType>(shape.m_type))
+    {
+        case RT::PrimitiveType::SPHERE:
+            RT::PacketKernels::IntersectSphere(bckTfm, packet, tHit);
+            break;
+
+        case RT::PrimitiveType::PLANE:
+            RT::PacketKernels::IntersectPlane(bckTfm, packet, tHit);
+            break;
+
+        default:
+            RT::ObjMesh::IntersectPacket(bckTfm, *m_meshes[shape.m_index], packet, tHit);
+            break;
+    }
+}
+
+// Function to reorder the objects. The sphere centres are reordered with them, so that they stay in the same order as the spheres
+void RT::ObjectStore::Reorder(const std::vector<Handle> &order)
+{
+    std::vector<Shape> shapes;
+    std::vector<RT::AffineMatrix> transforms;
+    std::vector<Vector3<double>> colors;
+    std::vector<uint32_t> materialIndices;
+    std::vector<Vector3<double>> sphereCentres;
+    shapes.reserve(order.size());
+    transforms.reserve(order.size());
+    colors.reserve(order.size());
+    materialIndices.reserve(order.size());
+    sphereCentres.reserve(m_sphereCentres.size());
+
+    // Read the current arrays through a const reference, so that mapped ones are not copied first
+    const ObjectStore &current = *this;
+    for (Handle handle : order)
+    {
+        Shape shape = current.m_shapes[handle];
+        if (static_cast<RT::PrimitiveType>(shape.m_type) == RT::PrimitiveType::SPHERE)
+        {
+            sphereCentres.push_back(current.m_sphereCentres[shape.m_index]);
+            shape.m_index = static_cast<uint32_t>(sphereCentres.size() - 1);
+        }
+
+        shapes.push_back(shape);
+        transforms.push_back(current.m_transforms[handle]);
+        colors.push_back(current.m_colors[handle]);
+        materialIndices.push_back(current.m_materialIndices[handle]);
+    }
+
+    m_shapes = std::move(shapes);
+    m_transforms = std::move(transforms);
+    m_colors = std::move(colors);
+    m_materialIndices = std::move(materialIndices);
+    m_sphereCentres = std::move(sphereCentres);
+}
+
+// Function to return the memory used, counting mapped arrays at their size
+size_t RT::ObjectStore::GetMemorySize() const
+{
+    return (m_shapes.capacity() * sizeof(Shape)) +
+           (m_transforms.capacity() * sizeof(RT::AffineMatrix)) +
+           (m_colors.capacity() * sizeof(Vector3<double>)) +
+           (m_materialIndices.capacity() * sizeof(uint32_t)) +
+           (m_sphereCentres.capacity() * sizeof(Vector3<double>)) +
+           (m_materials.capacity() * sizeof(std::shared_ptr<RT::MaterialBase>)) +
+           (m_meshes.capacity() * sizeof(std::shared_ptr<const RT::MeshGeometry>));
+}
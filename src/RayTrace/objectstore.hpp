@@ -0,0 +1,145 @@
+#ifndef OBJECTSTORE_H
+#define OBJECTSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "../LinAlg/Vector3.hpp"
+#include "aabb.hpp"
+#include "gtfm.hpp"
+#include "mappablearray.hpp"
+#include "ray.hpp"
+#include "raypacket.hpp"
+#include "./Primatives/objectbase.hpp"
+#include "./Primatives/meshgeometry.hpp"
+
+namespace RT
+{
+    /*
+        The objects of a scene, stored as flat arrays with one entry per object (structure of
+        arrays) and addressed by a 32-bit handle, the index of the object in the arrays.
+
+        An object is its primitive type, its backward transform, its color and the index of its
+        material, which together take 132 bytes and no allocation of their own. Data that only
+        some primitives need is kept in per-type arrays: the centre of each sphere, and a table
+        of the distinct mesh geometries. Materials are kept in a table too, so that objects that
+        share a material share its entry. Nothing here is reference counted per object, and the
+        intersection tests are plain functions of the arrays, so the hot loops neither call a
+        virtual function nor touch a shared_ptr to reach an object.
+
+        The arrays hold plain records, so they can be saved as they are and used in place from
+        a mapped file (see Restore and CompiledScene).
+    */
+    class ObjectStore
+    {
+        public:
+            using Handle = uint32_t;
+
+            // The index of the material of an object that has none
+            static constexpr uint32_t NO_MATERIAL = 0xffffffff;
+
+            // The primitive type of an object, and its index in the array for its type
+            struct Shape
+            {
+                uint32_t m_type;
+                uint32_t m_index;
+            };
+
+            // The default constructor
+            ObjectStore();
+
+            /*
+                Function to add a copy of an object, which is given the next handle. Returns false,
+                adding nothing, if the object is not a sphere, plane or mesh. Later changes to the
+                object have no effect on the store
+            */
+            bool Add(const RT::ObjectBase &object);
+
+            /*
+                Function to replace the objects with the arrays of another store, as returned by the
+                functions below, which may be views of a mapped file. materials and meshes are the
+                tables that the arrays index. Nothing is copied. Returns false, leaving the store
+                unchanged, if the arrays are inconsistent
+            */
+            bool Restore
+            (
+                RT::MappableArray<Shape> shapes, RT::MappableArray<RT::AffineMatrix> transforms,
+                RT::MappableArray<Vector3<double>> colors, RT::MappableArray<uint32_t> materialIndices,
+                RT::MappableArray<Vector3<double>> sphereCentres,
+                std::vector<std::shared_ptr<RT::MaterialBase>> materials,
+                std::vector<std::shared_ptr<const RT::MeshGeometry>> meshes
+            );
+
+            // Function to remove every object
+            void Clear();
+
+            // Function to return the number of objects
+            Handle GetSize() const;
+
+            // Function to return a counter that changes every time the objects change
+            uint32_t GetVersion() const;
+
+            // Functions to return the data of an object
+            RT::PrimitiveType GetPrimitiveType(Handle handle) const;
+            const RT::AffineMatrix &GetTransform(Handle handle) const;
+            const Vector3<double> &GetBaseColor(Handle handle) const;
+            RT::MaterialBase *GetMaterial(Handle handle) const;
+            const RT::MeshGeometry *GetMesh(Handle handle) const;
+
+            // Function to return whether a ray leaving the surface of an object can hit it again (see ObjectBase::CanHitItself)
+            bool CanHitItself(Handle handle) const;
+
+            // Function to return the bounds of an object in world coordinates
+            RT::AABB GetWorldBounds(Handle handle) const;
+
+            // Functions to return the arrays, indexed by handle except for the sphere centres (see Shape)
+            const RT::MappableArray<Shape> &GetShapes() const;
+            const RT::MappableArray<RT::AffineMatrix> &GetTransforms() const;
+            const RT::MappableArray<Vector3<double>> &GetColors() const;
+            const RT::MappableArray<uint32_t> &GetMaterialIndices() const;
+            const RT::MappableArray<Vector3<double>> &GetSphereCentres() const;
+
+            // Functions to return the tables shared between objects
+            const std::vector<std::shared_ptr<RT::MaterialBase>> &GetMaterials() const;
+            const std::vector<std::shared_ptr<const RT::MeshGeometry>> &GetMeshes() const;
+
+            // The intersection tests, as for ObjectBase::TestIntersection, Occluded and TestIntersectionPacket
+            bool TestIntersection
+            (
+                Handle handle, const RT::Ray &castRay, Vector3<double> &intPoint,
+                Vector3<double> &localNormal, Vector3<double> &localColor
+            ) const;
+            bool Occluded(Handle handle, const RT::Ray &castRay, double tMax) const;
+            void TestIntersectionPacket(Handle handle, const RT::RayPacket &packet, double *tHit) const;
+
+            // Function to reorder the objects so that the object with handle order[i] gets handle i
+            void Reorder(const std::vector<Handle> &order);
+
+            // Function to return the number of bytes used by the arrays and the tables, not counting the materials and meshes themselves
+            size_t GetMemorySize() const;
+
+        private:
+            // One entry per object
+            RT::MappableArray<Shape> m_shapes;
+            RT::MappableArray<RT::AffineMatrix> m_transforms;
+            RT::MappableArray<Vector3<double>> m_colors;
+            RT::MappableArray<uint32_t> m_materialIndices;
+
+            // The world-space centre of each sphere, indexed by Shape::m_index
+            RT::MappableArray<Vector3<double>> m_sphereCentres;
+
+            // The distinct materials and mesh geometries, indexed by m_materialIndices and Shape::m_index
+            std::vector<std::shared_ptr<RT::MaterialBase>> m_materials;
+            std::vector<std::shared_ptr<const RT::MeshGeometry>> m_meshes;
+
+            // The index of each material and mesh in its table, used to find shared ones as objects are added
+            std::unordered_map<const RT::MaterialBase*, uint32_t> m_materialLookup;
+            std::unordered_map<const RT::MeshGeometry*, uint32_t> m_meshLookup;
+
+            uint32_t m_version = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,671 @@
+#include "objloader.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+#include "mappedfile.hpp"
+#include "threadpool.hpp"
+
+// The layout of the cache file, and the helpers for parsing
+namespace
+{
+    const char CACHE_MAGIC[8] = {'R', 'T', 'M', 'E', 'S', 'H', '\0', '\0'};
+
+    struct CacheSection
+    {
+        uint64_t m_offset;
+        uint64_t m_count;
+    };
+
+    struct CacheHeader
+    {
+        char m_magic[8];
+        uint32_t m_version;
+        uint32_t m_headerSize;
+        uint64_t m_fileSize;
+
+        // The OBJ file that the cache was made from, with its modification time in nanoseconds
+        uint64_t m_sourceSize;
+        int64_t m_sourceTime;
+
+        // The floats of the positions and normals, the vertex indices and the BVH nodes
+        CacheSection m_positions;
+        CacheSection m_normals;
+        CacheSection m_indices;
+        CacheSection m_nodes;
+    };
+
+    static_assert(sizeof(CacheHeader) == 104, "The mesh cache header must not change size");
+    static_assert(sizeof(RT::MeshGeometry::Node) == 32, "The mesh cache records must not change size");
+
+    // The cache is read and written directly, which relies on the host being little-endian
+    bool IsLittleEndian()
+    {
+        const uint16_t value = 1;
+        unsigned char firstByte;
+        std::memcpy(&firstByte, &value, 1);
+        return firstByte == 1;
+    }
+
+    /*
+        Function to return the size and modification time of a file. The time is kept to the
+        full resolution of the file system (rather than whole seconds), so that an OBJ file
+        rewritten within a second of its cache being made is still seen to have changed
+    */
+    bool GetFileInfo(const std::string &fileName, uint64_t &size, int64_t &time)
+    {
+        std::error_code error;
+        std::filesystem::path path (fileName);
+        uintmax_t fileSize = std::filesystem::file_size(path, error);
+        if (error)
+            return false;
+
+        std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(path, error);
+        if (error)
+            return false;
+
+        size = static_cast<uint64_t>(fileSize);
+        time = static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(writeTime.time_since_epoch()).count());
+        return true;
+    }
+
+    // Function to return a section of the cache as an array, or null if it does not fit in the file
+    template <typename T>
+    const T *GetSection(const RT::MappedFile &file, const CacheSection &section)
+    {
+        if ((section.m_offset % alignof(T) != 0) || (section.m_offset > file.GetSize()))
+            return nullptr;
+        if (section.m_count > (file.GetSize() - section.m_offset) / sizeof(T))
+            return nullptr;
+
+        return reinterpret_cast<const T *>(file.GetData() + section.m_offset);
+    }
+
+    bool IsSpace(char c)
+    {
+        return (c == ' ') || (c == '\t') || (c == '\r');
+    }
+
+    bool IsDigit(char c)
+    {
+        return (c >= '0') && (c <= '9');
+    }
+
+    const char *SkipSpace(const char *pos, const char *end)
+    {
+        while ((pos < end) && IsSpace(*pos))
+            ++pos;
+        return pos;
+    }
+
+    // Function to return the next word of a line and move pos past it
+    std::string_view NextWord(const char *&pos, const char *end)
+    {
+        pos = SkipSpace(pos, end);
+        const char *wordStart = pos;
+        while ((pos < end) && !IsSpace(*pos))
+            ++pos;
+
+        return std::string_view(wordStart, pos - wordStart);
+    }
+
+    // The powers of ten that are exact as doubles
+    const double POWERS_OF_TEN[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    /*
+        Function to parse a word as a number. The digits are gathered into an integer,
+        which for the numbers found in OBJ files is almost always exact as a double and
+        is then scaled by an exact power of ten, giving the correctly rounded result with
+        one multiply or divide. Anything else goes to from_chars
+    */
+    bool ParseFloat(std::string_view word, float &value)
+    {
+        const char *pos = word.data();
+        const char *end = pos + word.size();
+        bool negative = (pos < end) && (*pos == '-');
+        if ((pos < end) && ((*pos == '-') || (*pos == '+')))
+            ++pos;
+
+        uint64_t mantissa = 0;
+        int numDigits = 0;
+        int exponent = 0;
+        bool hasDigits = false;
+        for (; (pos < end) && IsDigit(*pos); ++pos)
+        {
+            hasDigits = true;
+            if (numDigits < 19)
+            {
+                mantissa = (mantissa * 10) + (*pos - '0');
+                numDigits += (mantissa != 0) ? 1 : 0;
+            }
+            else
+            {
+                ++exponent;
+            }
+        }
+
+        if ((pos < end) && (*pos == '.'))
+        {
+            for (++pos; (pos < end) && IsDigit(*pos); ++pos)
+            {
+                hasDigits = true;
+                if (numDigits < 19)
+                {
+                    mantissa = (mantissa * 10) + (*pos - '0');
+                    numDigits += (mantissa != 0) ? 1 : 0;
+                    --exponent;
+                }
+            }
+        }
+
+        if (!hasDigits)
+            return false;
+
+        if ((pos < end) && ((*pos == 'e') || (*pos == 'E')))
+        {
+            ++pos;
+            bool negativeExponent = (pos < end) && (*pos == '-');
+            if ((pos < end) && ((*pos == '-') || (*pos == '+')))
+                ++pos;
+            if ((pos == end) || !IsDigit(*pos))
+                return false;
+
+            int exponentValue = 0;
+            for (; (pos < end) && IsDigit(*pos); ++pos)
+                exponentValue = std::min((exponentValue * 10) + (*pos - '0'), 100000);
+            exponent += negativeExponent ? -exponentValue : exponentValue;
+        }
+
+        if (pos != end)
+            return false;
+
+        double result;
+        if ((mantissa <= (uint64_t(1) << 53)) && (exponent >= -22) && (exponent <= 22))
+        {
+            result = static_cast<double>(mantissa);
+            result = (exponent < 0) ? result / POWERS_OF_TEN[-exponent] : result * POWERS_OF_TEN[exponent];
+            result = negative ? -result : result;
+        }
+        else
+        {
+            // from_chars does not accept a leading '+'
+            const char *start = word.data() + ((word[0] == '+') ? 1 : 0);
+            auto parsed = std::from_chars(start, end, result);
+            if ((parsed.ec != std::errc()) || (parsed.ptr != end))
+                return false;
+        }
+
+        value = static_cast<float>(result);
+        return true;
+    }
+
+    // Function to parse a vertex index, which is 1-based or, if negative, relative to the end
+    bool ParseIndex(const char *&pos, const char *end, int64_t numDefined, int64_t numTotal, int64_t &index)
+    {
+        bool negative = (pos < end) && (*pos == '-');
+        if ((pos < end) && ((*pos == '-') || (*pos == '+')))
+            ++pos;
+        if ((pos == end) || !IsDigit(*pos))
+            return false;
+
+        int64_t value = 0;
+        for (; (pos < end) && IsDigit(*pos); ++pos)
+            value = std::min((value * 10) + (*pos - '0'), numTotal + 1);
+
+        index = negative ? numDefined - value : value - 1;
+        return (value > 0) && (index >= 0) && (index < numTotal);
+    }
+}
+
+// A part of the file parsed by one task
+struct RT::ObjLoader::Chunk
+{
+    const char *m_begin = nullptr;
+    const char *m_end = nullptr;
+
+    // The counts from the first pass
+    size_t m_numVertices = 0;
+    size_t m_numNormals = 0;
+    size_t m_numTriangles = 0;
+
+    // Where the chunk's vertices, normals and triangles go in the arrays
+    size_t m_firstVertex = 0;
+    size_t m_firstNormal = 0;
+    size_t m_firstTriangle = 0;
+
+    // Whether a face corner in the chunk has no normal
+    bool m_missingNormals = false;
+
+    // The first error in the chunk
+    const char *m_pError = nullptr;
+    std::string m_error;
+};
+
+// The arrays that the chunks are parsed into
+struct RT::ObjLoader::Arrays
+{
+    size_t m_numVertices = 0;
+    size_t m_numNormals = 0;
+    std::vector<float> m_positions;
+    std::vector<float> m_normals;
+    std::vector<uint32_t> m_indices;
+
+    // The normal index of each corner, if the file has normals
+    std::vector<uint32_t> m_normalIndices;
+};
+
+// The default constructor
+RT::ObjLoader::ObjLoader()
+{
+
+}
+
+// Function to load an OBJ file
+bool RT::ObjLoader::Load(const std::string &fileName, RT::MeshGeometry &geometry)
+{
+    m_fileName = fileName;
+    m_error.clear();
+    m_wasCached = false;
+
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if (!GetFileInfo(fileName, sourceSize, sourceTime))
+        return Fail("could not open the file");
+
+    bool useCache = m_useCache && IsLittleEndian();
+    std::string cacheFileName = GetCacheFileName(fileName);
+    if (useCache && LoadCache(cacheFileName, sourceSize, sourceTime, geometry))
+    {
+        m_wasCached = true;
+        return true;
+    }
+
+    RT::MappedFile file;
+    if (!file.Open(fileName))
+        return Fail("could not open the file");
+
+    if (!Parse(file.GetData(), file.GetSize(), geometry))
+        return false;
+
+    // The mesh has loaded either way, so a cache that cannot be written is not an error
+    if (useCache)
+        SaveCache(cacheFileName, sourceSize, sourceTime, geometry);
+
+    return true;
+}
+
+// Function to set whether the cache is used
+void RT::ObjLoader::SetUseCache(bool useCache)
+{
+    m_useCache = useCache;
+}
+
+// Function to set the number of threads
+void RT::ObjLoader::SetThreadCount(int numThreads)
+{
+    m_numThreads = numThreads;
+}
+
+// Function to return whether the last load came from the cache
+bool RT::ObjLoader::WasCached() const
+{
+    return m_wasCached;
+}
+
+// Function to return the last error
+const std::string &RT::ObjLoader::GetError() const
+{
+    return m_error;
+}
+
+// Function to return the name of the cache file
+std::string RT::ObjLoader::GetCacheFileName(const std::string &fileName)
+{
+    return fileName + ".rtmesh";
+}
+
+// Function to parse the contents of an OBJ file
+bool RT::ObjLoader::Parse(const char *data, size_t size, RT::MeshGeometry &geometry)
+{
+    RT::ThreadPool threadPool ((m_numThreads > 0) ? m_numThreads : RT::ThreadPool::DefaultThreadCount());
+
+    // Cut the file into chunks that each end at the end of a line
+    size_t numChunks = std::max<size_t>(1, std::min<size_t>(size / MIN_CHUNK_SIZE, static_cast<size_t>(threadPool.GetNumThreads()) * CHUNKS_PER_THREAD));
+    std::vector<Chunk> chunks (numChunks);
+    const char *end = data + size;
+    const char *chunkStart = data;
+    for (size_t c = 0; c < numChunks; ++c)
+    {
+        const char *chunkEnd = end;
+        if (c + 1 < numChunks)
+        {
+            chunkEnd = std::max(chunkStart, data + (size / numChunks) * (c + 1));
+            const char *newline = static_cast<const char *>(std::memchr(chunkEnd, '\n', end - chunkEnd));
+            chunkEnd = (newline != nullptr) ? newline + 1 : end;
+        }
+
+        chunks[c].m_begin = chunkStart;
+        chunks[c].m_end = chunkEnd;
+        chunkStart = chunkEnd;
+    }
+
+    // Count what is in each chunk, and work out where each chunk's share goes
+    threadPool.Run(static_cast<int>(numChunks), [&chunks](int taskIndex, int)
+    {
+        CountChunk(chunks[taskIndex]);
+    });
+
+    Arrays arrays;
+    size_t numTriangles = 0;
+    for (Chunk &chunk : chunks)
+    {
+        chunk.m_firstVertex = arrays.m_numVertices;
+        chunk.m_firstNormal = arrays.m_numNormals;
+        chunk.m_firstTriangle = numTriangles;
+        arrays.m_numVertices += chunk.m_numVertices;
+        arrays.m_numNormals += chunk.m_numNormals;
+        numTriangles += chunk.m_numTriangles;
+    }
+
+    if (arrays.m_numVertices > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+        return Fail("too many vertices");
+    if (numTriangles > static_cast<size_t>(std::numeric_limits<int32_t>::max() / 2))
+        return Fail("too many triangles");
+
+    arrays.m_positions.resize(3 * arrays.m_numVertices);
+    arrays.m_normals.resize(3 * arrays.m_numNormals);
+    arrays.m_indices.resize(3 * numTriangles);
+    if (arrays.m_numNormals > 0)
+        arrays.m_normalIndices.resize(3 * numTriangles);
+
+    threadPool.Run(static_cast<int>(numChunks), [&chunks, &arrays](int taskIndex, int)
+    {
+        ParseChunk(chunks[taskIndex], arrays);
+    });
+
+    // Report the first error in the file, counting the lines up to it only now
+    bool missingNormals = false;
+    for (const Chunk &chunk : chunks)
+    {
+        if (chunk.m_pError != nullptr)
+            return Fail(chunk.m_error, 1 + std::count(data, chunk.m_pError, '\n'));
+
+        missingNormals = missingNormals || chunk.m_missingNormals;
+    }
+
+    if (numTriangles == 0)
+        return Fail("the file has no faces");
+
+    /*
+        A mesh has one normal per vertex, so each distinct (position, normal) pair used by the
+        faces becomes a vertex of its own. A position keeps its index for the first normal it is
+        used with, and only the corners that use it with another normal (eg. along the hard edges
+        of a cube with one normal per face) look up or add a copy of it, keyed by the pair
+    */
+    std::vector<float> normals;
+    if ((arrays.m_numNormals > 0) && !missingNormals)
+    {
+        constexpr uint32_t NO_NORMAL = std::numeric_limits<uint32_t>::max();
+        normals.resize(arrays.m_positions.size(), 0.0f);
+        std::vector<uint32_t> firstNormal (arrays.m_numVertices, NO_NORMAL);
+        std::unordered_map<uint64_t, uint32_t> splitVertices;
+        for (size_t corner = 0; corner < arrays.m_indices.size(); ++corner)
+        {
+            uint32_t vertex = arrays.m_indices[corner];
+            uint32_t normal = arrays.m_normalIndices[corner];
+            if (firstNormal[vertex] == NO_NORMAL)
+            {
+                firstNormal[vertex] = normal;
+                std::copy_n(&arrays.m_normals[3 * static_cast<size_t>(normal)], 3, &normals[3 * static_cast<size_t>(vertex)]);
+            }
+            else if (firstNormal[vertex] != normal)
+            {
+                uint64_t key = (static_cast<uint64_t>(vertex) << 32) | normal;
+                auto found = splitVertices.find(key);
+                if (found == splitVertices.end())
+                {
+                    size_t newVertex = arrays.m_positions.size() / 3;
+                    if (newVertex > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+                        return Fail("too many vertices");
+
+                    // Copy the position out first, as adding to the array may move it
+                    float position[3];
+                    std::copy_n(&arrays.m_positions[3 * static_cast<size_t>(vertex)], 3, position);
+                    arrays.m_positions.insert(arrays.m_positions.end(), position, position + 3);
+                    normals.insert(normals.end(), &arrays.m_normals[3 * static_cast<size_t>(normal)], &arrays.m_normals[3 * static_cast<size_t>(normal)] + 3);
+                    found = splitVertices.emplace(key, static_cast<uint32_t>(newVertex)).first;
+                }
+
+                arrays.m_indices[corner] = found -> second;
+            }
+        }
+    }
+
+    if (!geometry.SetTriangles(std::move(arrays.m_positions), std::move(arrays.m_indices), std::move(normals)))
+        return Fail("the faces do not form a valid mesh");
+
+    return true;
+}
+
+// Function to count the vertices, normals and triangles in a chunk
+void RT::ObjLoader::CountChunk(Chunk &chunk)
+{
+    for (const char *line = chunk.m_begin; line < chunk.m_end; )
+    {
+        const char *lineEnd = static_cast<const char *>(std::memchr(line, '\n', chunk.m_end - line));
+        lineEnd = (lineEnd != nullptr) ? lineEnd : chunk.m_end;
+
+        const char *pos = line;
+        std::string_view keyword = NextWord(pos, lineEnd);
+        if (keyword == "v")
+        {
+            ++chunk.m_numVertices;
+        }
+        else if (keyword == "vn")
+        {
+            ++chunk.m_numNormals;
+        }
+        else if (keyword == "f")
+        {
+            size_t numCorners = 0;
+            while (!NextWord(pos, lineEnd).empty())
+                ++numCorners;
+            chunk.m_numTriangles += (numCorners > 2) ? numCorners - 2 : 0;
+        }
+
+        line = lineEnd + 1;
+    }
+}
+
+// Function to parse the vertices, normals and faces of a chunk into the arrays
+void RT::ObjLoader::ParseChunk(Chunk &chunk, Arrays &arrays)
+{
+    size_t vertex = chunk.m_firstVertex;
+    size_t normal = chunk.m_firstNormal;
+    size_t triangle = chunk.m_firstTriangle;
+    auto fail = [&chunk](const char *line, const char *message)
+    {
+        chunk.m_pError = line;
+        chunk.m_error = message;
+    };
+
+    for (const char *line = chunk.m_begin; line < chunk.m_end; )
+    {
+        const char *lineEnd = static_cast<const char *>(std::memchr(line, '\n', chunk.m_end - line));
+        lineEnd = (lineEnd != nullptr) ? lineEnd : chunk.m_end;
+
+        const char *pos = line;
+        std::string_view keyword = NextWord(pos, lineEnd);
+        if ((keyword == "v") || (keyword == "vn"))
+        {
+            // Anything after the three coordinates (a w, or a vertex color) is ignored
+            float *values = (keyword == "v") ? &arrays.m_positions[3 * vertex++] : &arrays.m_normals[3 * normal++];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (!ParseFloat(NextWord(pos, lineEnd), values[axis]))
+                    return fail(line, "expected three numbers");
+            }
+        }
+        else if (keyword == "f")
+        {
+            // Split the face into a fan of triangles around its first corner
+            int64_t firstVertex = 0, firstNormal = 0, lastVertex = 0, lastNormal = 0;
+            int numCorners = 0;
+            for (std::string_view word = NextWord(pos, lineEnd); !word.empty(); word = NextWord(pos, lineEnd), ++numCorners)
+            {
+                // A corner is v, v/vt, v//vn or v/vt/vn, and the texture coordinate is not used
+                const char *wordPos = word.data();
+                const char *wordEnd = wordPos + word.size();
+                int64_t vertexIndex = 0, normalIndex = 0;
+                if (!ParseIndex(wordPos, wordEnd, static_cast<int64_t>(vertex), static_cast<int64_t>(arrays.m_numVertices), vertexIndex))
+                    return fail(line, "invalid vertex index");
+
+                bool hasNormal = false;
+                if ((wordPos < wordEnd) && (*wordPos == '/'))
+                {
+                    ++wordPos;
+                    while ((wordPos < wordEnd) && (*wordPos != '/'))
+                        ++wordPos;
+
+                    if (wordPos < wordEnd)
+                    {
+                        ++wordPos;
+                        if (!ParseIndex(wordPos, wordEnd, static_cast<int64_t>(normal), static_cast<int64_t>(arrays.m_numNormals), normalIndex))
+                            return fail(line, "invalid normal index");
+                        hasNormal = true;
+                    }
+                }
+
+                if (wordPos != wordEnd)
+                    return fail(line, "invalid face corner");
+
+                chunk.m_missingNormals = chunk.m_missingNormals || !hasNormal;
+                if (numCorners == 0)
+                {
+                    firstVertex = vertexIndex;
+                    firstNormal = normalIndex;
+                }
+                else if (numCorners >= 2)
+                {
+                    uint32_t *corners = &arrays.m_indices[3 * triangle];
+                    corners[0] = static_cast<uint32_t>(firstVertex);
+                    corners[1] = static_cast<uint32_t>(lastVertex);
+                    corners[2] = static_cast<uint32_t>(vertexIndex);
+                    if (!arrays.m_normalIndices.empty())
+                    {
+                        uint32_t *normals = &arrays.m_normalIndices[3 * triangle];
+                        normals[0] = static_cast<uint32_t>(firstNormal);
+                        normals[1] = static_cast<uint32_t>(lastNormal);
+                        normals[2] = static_cast<uint32_t>(normalIndex);
+                    }
+                    ++triangle;
+                }
+
+                lastVertex = vertexIndex;
+                lastNormal = normalIndex;
+            }
+
+            if (numCorners < 3)
+                return fail(line, "a face needs at least three corners");
+        }
+
+        line = lineEnd + 1;
+    }
+}
+
+// Function to load the cache
+bool RT::ObjLoader::LoadCache(const std::string &cacheFileName, uint64_t sourceSize, int64_t sourceTime, RT::MeshGeometry &geometry)
+{
+    RT::MappedFile file;
+    if (!file.Open(cacheFileName))
+        return false;
+
+    if (file.GetSize() < sizeof(CacheHeader) || (std::memcmp(file.GetData(), CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0))
+        return false;
+
+    const CacheHeader &header = *reinterpret_cast<const CacheHeader *>(file.GetData());
+    if ((header.m_version != CACHE_VERSION) || (header.m_headerSize != sizeof(CacheHeader)) || (header.m_fileSize != file.GetSize()))
+        return false;
+    if ((header.m_sourceSize != sourceSize) || (header.m_sourceTime != sourceTime))
+        return false;
+
+    const float *positions = GetSection<float>(file, header.m_positions);
+    const float *normals = GetSection<float>(file, header.m_normals);
+    const uint32_t *indices = GetSection<uint32_t>(file, header.m_indices);
+    const RT::MeshGeometry::Node *nodes = GetSection<RT::MeshGeometry::Node>(file, header.m_nodes);
+    if (!positions || !normals || !indices || !nodes)
+        return false;
+
+    // The geometry checks that the arrays and the tree are consistent, and is left unchanged if they are not
+    return geometry.Restore
+    (
+        std::vector<float>(positions, positions + header.m_positions.m_count),
+        std::vector<uint32_t>(indices, indices + header.m_indices.m_count),
+        std::vector<float>(normals, normals + header.m_normals.m_count),
+        std::vector<RT::MeshGeometry::Node>(nodes, nodes + header.m_nodes.m_count)
+    );
+}
+
+// Function to write the cache
+bool RT::ObjLoader::SaveCache(const std::string &cacheFileName, uint64_t sourceSize, int64_t sourceTime, const RT::MeshGeometry &geometry)
+{
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.m_magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.m_version = CACHE_VERSION;
+    header.m_headerSize = sizeof(CacheHeader);
+    header.m_sourceSize = sourceSize;
+    header.m_sourceTime = sourceTime;
+
+    uint64_t offset = sizeof(CacheHeader);
+    auto placeSection = [&offset](CacheSection &section, size_t count, size_t recordSize)
+    {
+        section.m_offset = offset;
+        section.m_count = count;
+        offset += count * recordSize;
+    };
+    placeSection(header.m_positions, geometry.GetPositions().size(), sizeof(float));
+    placeSection(header.m_normals, geometry.GetNormals().size(), sizeof(float));
+    placeSection(header.m_indices, geometry.GetIndices().size(), sizeof(uint32_t));
+    placeSection(header.m_nodes, geometry.GetNodes().size(), sizeof(RT::MeshGeometry::Node));
+    header.m_fileSize = offset;
+
+    // Write to a temporary file and rename it, so that a partly written cache is never read
+    std::string tempFileName = cacheFileName + ".tmp";
+    FILE *file = std::fopen(tempFileName.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    bool written = (std::fwrite(&header, sizeof(header), 1, file) == 1);
+    written = written && (std::fwrite(geometry.GetPositions().data(), sizeof(float), geometry.GetPositions().size(), file) == geometry.GetPositions().size());
+    written = written && (std::fwrite(geometry.GetNormals().data(), sizeof(float), geometry.GetNormals().size(), file) == geometry.GetNormals().size());
+    written = written && (std::fwrite(geometry.GetIndices().data(), sizeof(uint32_t), geometry.GetIndices().size(), file) == geometry.GetIndices().size());
+    written = written && (std::fwrite(geometry.GetNodes().data(), sizeof(RT::MeshGeometry::Node), geometry.GetNodes().size(), file) == geometry.GetNodes().size());
+    written = (std::fclose(file) == 0) && written;
+
+    // rename does not replace an existing file on every platform
+    std::remove(cacheFileName.c_str());
+    if (!written || (std::rename(tempFileName.c_str(), cacheFileName.c_str()) != 0))
+    {
+        std::remove(tempFileName.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Function to record an error
+bool RT::ObjLoader::Fail(const std::string &message, size_t lineNumber)
+{
+    m_error = m_fileName + ":" + ((lineNumber > 0) ? std::to_string(lineNumber) + ":" : std::string()) + " " + message;
+    return false;
+}
@@ -0,0 +1,101 @@
+#ifndef OBJLOADER_H
+#define OBJLOADER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "./Primatives/meshgeometry.hpp"
+
+namespace RT
+{
+    /*
+        Loads a Wavefront OBJ file into a MeshGeometry. Only the geometry is read: the
+        vertex positions ("v"), the vertex normals ("vn") and the faces ("f"), with
+        negative (relative) indices and any number of vertices per face. Faces are
+        split into fans of triangles, and every other kind of line is ignored.
+
+        The file is mapped into memory and cut into chunks at line boundaries, which
+        are parsed in parallel in two passes. The first pass only counts the vertices,
+        normals and triangles in each chunk, so that the second pass can write each
+        chunk's share straight into the final arrays with no merging afterwards.
+
+        OBJ gives each corner of a face its own normal index, but a mesh has one normal
+        per vertex, so a position that is used with several normals (eg. along a hard
+        edge) becomes one vertex for each of them. If any corner has no normal the mesh
+        is flat shaded.
+
+        After parsing, the mesh, including its BVH, is written to a binary cache next to
+        the OBJ file (GetCacheFileName). Later loads of the same file map the cache and
+        restore the mesh from it, which skips both the parsing and the BVH build. The
+        arrays are copied out of the mapping into the mesh, which walks the restored tree
+        once to check it, and the mapping is then closed. The cache records the size and
+        modification time (to the file system's full resolution) of the OBJ file, and is
+        ignored and rewritten when either changes, or when it is from another version of
+        the format.
+    */
+    class ObjLoader
+    {
+        public:
+            // The version of the cache format, which changes whenever the layout does
+            static constexpr uint32_t CACHE_VERSION = 3;
+
+            // The default constructor
+            ObjLoader();
+
+            /*
+                Function to load an OBJ file into mesh geometry, replacing its triangles. Returns false,
+                leaving the geometry unchanged, if the file cannot be read or has an error, and
+                GetError then describes it
+            */
+            bool Load(const std::string &fileName, RT::MeshGeometry &geometry);
+
+            // Function to set whether the binary cache is read and written (on by default)
+            void SetUseCache(bool useCache);
+
+            // Function to set the number of threads that parse the file (by default one per core)
+            void SetThreadCount(int numThreads);
+
+            // Function to return whether the last load came from the cache
+            bool WasCached() const;
+
+            // Function to return the description of the last error
+            const std::string &GetError() const;
+
+            // Function to return the name of the cache file for an OBJ file
+            static std::string GetCacheFileName(const std::string &fileName);
+
+        private:
+            // Chunks are at least this size, and there are up to this many per thread
+            static constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+            static constexpr int CHUNKS_PER_THREAD = 4;
+
+            // A part of the file parsed by one task
+            struct Chunk;
+
+            // The arrays that the chunks are parsed into
+            struct Arrays;
+
+            // Function to parse the contents of an OBJ file into mesh geometry
+            bool Parse(const char *data, size_t size, RT::MeshGeometry &geometry);
+
+            // Functions for the two passes over a chunk
+            static void CountChunk(Chunk &chunk);
+            static void ParseChunk(Chunk &chunk, Arrays &arrays);
+
+            // Functions to read and write the cache. Loading returns false if the cache is missing, stale or corrupt
+            bool LoadCache(const std::string &cacheFileName, uint64_t sourceSize, int64_t sourceTime, RT::MeshGeometry &geometry);
+            bool SaveCache(const std::string &cacheFileName, uint64_t sourceSize, int64_t sourceTime, const RT::MeshGeometry &geometry);
+
+            // Function to record an error, on a line of the file if lineNumber is not 0. Always returns false
+            bool Fail(const std::string &message, size_t lineNumber = 0);
+
+        private:
+            std::string m_fileName;
+            std::string m_error;
+            bool m_useCache = true;
+            bool m_wasCached = false;
+            int m_numThreads = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,275 @@
+#include "packetkernels.hpp"
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+/*
+    SSE2 is part of x86-64, so it is always available there. The AVX2 and AVX-512 kernels
+    are compiled with GCC's target pragmas and only run if the CPU supports them. They are
+    left out on Windows, where GCC does not align the stack for 32 and 64 byte registers
+*/
+#if defined(__SSE2__) || defined(_M_X64)
+    #define RT_PACKET_SSE2
+    #include <immintrin.h>
+#endif
+
+#if defined(RT_PACKET_SSE2) && defined(__GNUC__) && !defined(__clang__) && !defined(_WIN32)
+    #define RT_PACKET_AVX
+#endif
+
+namespace
+{
+    // The same threshold as ObjectBase::CloseEnough, which is a float literal
+    constexpr double PARALLEL_EPSILON = 1e-21f;
+
+    // One lane at a time, for CPUs without any of the instruction sets below
+    namespace PacketScalar
+    {
+        struct Lanes
+        {
+            using Vec = double;
+            using Mask = bool;
+            static constexpr int WIDTH = 1;
+
+            static inline Vec Load(const double *p) { return *p; }
+            static inline void Store(double *p, Vec a) { *p = a; }
+            static inline Vec Set(double a) { return a; }
+            static inline Vec Add(Vec a, Vec b) { return a + b; }
+            static inline Vec Sub(Vec a, Vec b) { return a - b; }
+            static inline Vec Mul(Vec a, Vec b) { return a * b; }
+            static inline Vec Div(Vec a, Vec b) { return a / b; }
+            static inline Vec Neg(Vec a) { return -a; }
+            static inline Vec Abs(Vec a) { return std::fabs(a); }
+            static inline Vec Min(Vec a, Vec b) { return (a < b) ? a : b; }
+            static inline Vec Sqrt(Vec a) { return std::sqrt(a); }
+            static inline Vec SqrtFloat(Vec a) { return sqrtf(static_cast<float>(a)); }
+            static inline Mask Less(Vec a, Vec b) { return a < b; }
+            static inline Mask Greater(Vec a, Vec b) { return a > b; }
+            static inline Mask NotLess(Vec a, Vec b) { return !(a < b); }
+            static inline Mask NotGreater(Vec a, Vec b) { return !(a > b); }
+            static inline Mask And(Mask a, Mask b) { return a && b; }
+            static inline Mask AndNot(Mask a, Mask b) { return !a && b; }
+            static inline Vec Select(Mask m, Vec a, Vec b) { return m ? a : b; }
+        };
+
+        #include "packetkernels.inl"
+    }
+
+#ifdef RT_PACKET_SSE2
+    // Two lanes of double in an SSE register
+    namespace PacketSSE2
+    {
+        struct Lanes
+        {
+            using Vec = __m128d;
+            using Mask = __m128d;
+            static constexpr int WIDTH = 2;
+
+            static inline Vec Load(const double *p) { return _mm_loadu_pd(p); }
+            static inline void Store(double *p, Vec a) { _mm_storeu_pd(p, a); }
+            static inline Vec Set(double a) { return _mm_set1_pd(a); }
+            static inline Vec Add(Vec a, Vec b) { return _mm_add_pd(a, b); }
+            static inline Vec Sub(Vec a, Vec b) { return _mm_sub_pd(a, b); }
+            static inline Vec Mul(Vec a, Vec b) { return _mm_mul_pd(a, b); }
+            static inline Vec Div(Vec a, Vec b) { return _mm_div_pd(a, b); }
+            static inline Vec Neg(Vec a) { return _mm_xor_pd(a, _mm_set1_pd(-0.0)); }
+            static inline Vec Abs(Vec a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+            static inline Vec Min(Vec a, Vec b) { return _mm_min_pd(a, b); }
+            static inline Vec Sqrt(Vec a) { return _mm_sqrt_pd(a); }
+            static inline Vec SqrtFloat(Vec a) { return _mm_cvtps_pd(_mm_sqrt_ps(_mm_cvtpd_ps(a))); }
+            static inline Mask Less(Vec a, Vec b) { return _mm_cmplt_pd(a, b); }
+            static inline Mask Greater(Vec a, Vec b) { return _mm_cmpgt_pd(a, b); }
+            static inline Mask NotLess(Vec a, Vec b) { return _mm_cmpnlt_pd(a, b); }
+            static inline Mask NotGreater(Vec a, Vec b) { return _mm_cmpngt_pd(a, b); }
+            static inline Mask And(Mask a, Mask b) { return _mm_and_pd(a, b); }
+            static inline Mask AndNot(Mask a, Mask b) { return _mm_andnot_pd(a, b); }
+            static inline Vec Select(Mask m, Vec a, Vec b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+        };
+
+        #include "packetkernels.inl"
+    }
+#endif
+
+#ifdef RT_PACKET_AVX
+    // Four lanes of double in an AVX register
+    #pragma GCC push_options
+    #pragma GCC target("avx2")
+    namespace PacketAVX2
+    {
+        struct Lanes
+        {
+            using Vec = __m256d;
+            using Mask = __m256d;
+            static constexpr int WIDTH = 4;
+
+            static inline Vec Load(const double *p) { return _mm256_loadu_pd(p); }
+            static inline void Store(double *p, Vec a) { _mm256_storeu_pd(p, a); }
+            static inline Vec Set(double a) { return _mm256_set1_pd(a); }
+            static inline Vec Add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+            static inline Vec Sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+            static inline Vec Mul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+            static inline Vec Div(Vec a, Vec b) { return _mm256_div_pd(a, b); }
+            static inline Vec Neg(Vec a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+            static inline Vec Abs(Vec a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+            static inline Vec Min(Vec a, Vec b) { return _mm256_min_pd(a, b); }
+            static inline Vec Sqrt(Vec a) { return _mm256_sqrt_pd(a); }
+            static inline Vec SqrtFloat(Vec a) { return _mm256_cvtps_pd(_mm_sqrt_ps(_mm256_cvtpd_ps(a))); }
+            static inline Mask Less(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+            static inline Mask Greater(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+            static inline Mask NotLess(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_NLT_UQ); }
+            static inline Mask NotGreater(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_NGT_UQ); }
+            static inline Mask And(Mask a, Mask b) { return _mm256_and_pd(a, b); }
+            static inline Mask AndNot(Mask a, Mask b) { return _mm256_andnot_pd(a, b); }
+            static inline Vec Select(Mask m, Vec a, Vec b) { return _mm256_blendv_pd(b, a, m); }
+        };
+
+        #include "packetkernels.inl"
+    }
+    #pragma GCC pop_options
+
+    /*
+        Eight lanes of double in an AVX-512 register. AVX-512 includes fused multiply-add,
+        which GCC would otherwise use to contract the separate multiplies and adds, and
+        that would change the results. GCC 12's AVX-512 headers also trigger false
+        -Wmaybe-uninitialized warnings
+    */
+    #pragma GCC push_options
+    #pragma GCC target("avx512f")
+    #pragma GCC optimize("fp-contract=off")
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+    namespace PacketAVX512
+    {
+        struct Lanes
+        {
+            using Vec = __m512d;
+            using Mask = __mmask8;
+            static constexpr int WIDTH = 8;
+
+            static inline Vec Load(const double *p) { return _mm512_loadu_pd(p); }
+            static inline void Store(double *p, Vec a) { _mm512_storeu_pd(p, a); }
+            static inline Vec Set(double a) { return _mm512_set1_pd(a); }
+            static inline Vec Add(Vec a, Vec b) { return _mm512_add_pd(a, b); }
+            static inline Vec Sub(Vec a, Vec b) { return _mm512_sub_pd(a, b); }
+            static inline Vec Mul(Vec a, Vec b) { return _mm512_mul_pd(a, b); }
+            static inline Vec Div(Vec a, Vec b) { return _mm512_div_pd(a, b); }
+            static inline Vec Neg(Vec a) { return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a), _mm512_set1_epi64(static_cast<long long>(0x8000000000000000ULL)))); }
+            static inline Vec Abs(Vec a) { return _mm512_abs_pd(a); }
+            static inline Vec Min(Vec a, Vec b) { return _mm512_min_pd(a, b); }
+            static inline Vec Sqrt(Vec a) { return _mm512_sqrt_pd(a); }
+            static inline Vec SqrtFloat(Vec a) { return _mm512_cvtps_pd(_mm256_sqrt_ps(_mm512_cvtpd_ps(a))); }
+            static inline Mask Less(Vec a, Vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+            static inline Mask Greater(Vec a, Vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+            static inline Mask NotLess(Vec a, Vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_NLT_UQ); }
+            static inline Mask NotGreater(Vec a, Vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_NGT_UQ); }
+            static inline Mask And(Mask a, Mask b) { return static_cast<Mask>(a & b); }
+            static inline Mask AndNot(Mask a, Mask b) { return static_cast<Mask>(~a & b); }
+            static inline Vec Select(Mask m, Vec a, Vec b) { return _mm512_mask_blend_pd(m, b, a); }
+        };
+
+        #include "packetkernels.inl"
+    }
+    #pragma GCC diagnostic pop
+    #pragma GCC pop_options
+#endif
+
+    // The level in use, which starts as the widest the CPU supports
+    std::atomic<RT::SimdLevel> &CurrentLevel()
+    {
+        static std::atomic<RT::SimdLevel> level {RT::PacketKernels::GetSupportedLevel()};
+        return level;
+    }
+}
+
+// Function to intersect a packet with a sphere
+void RT::PacketKernels::IntersectSphere(const RT::AffineMatrix &bckMatrix, const RT::RayPacket &packet, double *tHit)
+{
+    switch (CurrentLevel().load(std::memory_order_relaxed))
+    {
+#ifdef RT_PACKET_AVX
+        case RT::SimdLevel::AVX512:
+            PacketAVX512::IntersectSphere(bckMatrix, packet, tHit);
+            return;
+        case RT::SimdLevel::AVX2:
+            PacketAVX2::IntersectSphere(bckMatrix, packet, tHit);
+            return;
+#endif
+#ifdef RT_PACKET_SSE2
+        case RT::SimdLevel::SSE2:
+            PacketSSE2::IntersectSphere(bckMatrix, packet, tHit);
+            return;
+#endif
+        default:
+            PacketScalar::IntersectSphere(bckMatrix, packet, tHit);
+            return;
+    }
+}
+
+// Function to intersect a packet with a plane
+void RT::PacketKernels::IntersectPlane(const RT::AffineMatrix &bckMatrix, const RT::RayPacket &packet, double *tHit)
+{
+    switch (CurrentLevel().load(std::memory_order_relaxed))
+    {
+#ifdef RT_PACKET_AVX
+        case RT::SimdLevel::AVX512:
+            PacketAVX512::IntersectPlane(bckMatrix, packet, tHit);
+            return;
+        case RT::SimdLevel::AVX2:
+            PacketAVX2::IntersectPlane(bckMatrix, packet, tHit);
+            return;
+#endif
+#ifdef RT_PACKET_SSE2
+        case RT::SimdLevel::SSE2:
+            PacketSSE2::IntersectPlane(bckMatrix, packet, tHit);
+            return;
+#endif
+        default:
+            PacketScalar::IntersectPlane(bckMatrix, packet, tHit);
+            return;
+    }
+}
+
+// Function to return the widest level that this CPU and this build support
+RT::SimdLevel RT::PacketKernels::GetSupportedLevel()
+{
+#ifdef RT_PACKET_AVX
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return RT::SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return RT::SimdLevel::AVX2;
+#endif
+#ifdef RT_PACKET_SSE2
+    return RT::SimdLevel::SSE2;
+#else
+    return RT::SimdLevel::SCALAR;
+#endif
+}
+
+// Functions to return and select the level in use
+RT::SimdLevel RT::PacketKernels::GetLevel()
+{
+    return CurrentLevel().load(std::memory_order_relaxed);
+}
+
+void RT::PacketKernels::SetLevel(RT::SimdLevel level)
+{
+    RT::SimdLevel supported = GetSupportedLevel();
+    CurrentLevel().store((level > supported) ? supported : level, std::memory_order_relaxed);
+}
+
+// Function to return the name of a level
+const char *RT::PacketKernels::GetLevelName(RT::SimdLevel level)
+{
+    switch (level)
+    {
+        case RT::SimdLevel::AVX512:
+            return "AVX-512";
+        case RT::SimdLevel::AVX2:
+            return "AVX2";
+        case RT::SimdLevel::SSE2:
+            return "SSE2";
+        default:
+            return "scalar";
+    }
+}
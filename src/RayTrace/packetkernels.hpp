@@ -0,0 +1,50 @@
+#ifndef PACKETKERNELS_H
+#define PACKETKERNELS_H
+
+#include "gtfm.hpp"
+#include "raypacket.hpp"
+
+namespace RT
+{
+    // The SIMD instruction sets the packet kernels can use, from narrowest to widest
+    enum class SimdLevel
+    {
+        SCALAR = 0,
+        SSE2 = 1,
+        AVX2 = 2,
+        AVX512 = 3
+    };
+
+    /*
+        Intersection tests for whole ray packets against the primitives in their local
+        coordinates, each written once and compiled for several instruction sets (2 lanes
+        of double with SSE2, 4 with AVX2 and 8 with AVX-512). The widest level supported
+        by the CPU is selected at run time.
+        The kernels do exactly the same floating-point operations, in the same order, as
+        the scalar TestIntersection functions, so a packet and a single ray always agree
+        on which objects are hit.
+        Each kernel writes the ray parameter of the hit for every lane of the packet, or
+        infinity where the ray misses (or the hit is outside the ray's interval)
+    */
+    class PacketKernels
+    {
+        public:
+            // The unit sphere at the origin, given the object's backward transform
+            static void IntersectSphere(const RT::AffineMatrix &bckMatrix, const RT::RayPacket &packet, double *tHit);
+
+            // The unit square in the local x-y plane, given the object's backward transform
+            static void IntersectPlane(const RT::AffineMatrix &bckMatrix, const RT::RayPacket &packet, double *tHit);
+
+            // Functions to return the widest level supported by this CPU and this build, and the level in use
+            static RT::SimdLevel GetSupportedLevel();
+            static RT::SimdLevel GetLevel();
+
+            // Function to select a level (eg. for testing). Levels the CPU cannot run are lowered to the supported level
+            static void SetLevel(RT::SimdLevel level);
+
+            // Function to return a printable name for a level
+            static const char *GetLevelName(RT::SimdLevel level);
+    };
+}
+
+#endif
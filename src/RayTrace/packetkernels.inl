@@ -0,0 +1,128 @@
+/*
+    The body of the packet kernels. packetkernels.cpp includes this file once for each
+    instruction set, inside a namespace that defines Lanes, the operations on one register
+    of doubles for that instruction set:
+
+        Vec, Mask, WIDTH
+        Load, Store, Set, Add, Sub, Mul, Div, Neg, Abs, Min, Sqrt, SqrtFloat
+        Less, Greater, NotLess, NotGreater, And, AndNot, Select
+
+    The comparisons follow the scalar code, so NotLess(a, b) is !(a < b), which is true for NaN,
+    and AndNot(a, b) is (!a && b).
+    Every expression mirrors the scalar code operation for operation, so the results are identical
+*/
+
+// Function to transform the rays in one register into local coordinates, as GTform::Apply does
+static inline void TransformRays
+(
+    const RT::AffineMatrix &m, const RT::RayPacket &packet, int first,
+    Lanes::Vec &px, Lanes::Vec &py, Lanes::Vec &pz,
+    Lanes::Vec &lx, Lanes::Vec &ly, Lanes::Vec &lz
+) {
+    Lanes::Vec ox = Lanes::Load(packet.m_originX + first);
+    Lanes::Vec oy = Lanes::Load(packet.m_originY + first);
+    Lanes::Vec oz = Lanes::Load(packet.m_originZ + first);
+    Lanes::Vec dx = Lanes::Load(packet.m_labX + first);
+    Lanes::Vec dy = Lanes::Load(packet.m_labY + first);
+    Lanes::Vec dz = Lanes::Load(packet.m_labZ + first);
+
+    px = Lanes::Add(Lanes::Add(Lanes::Add(Lanes::Mul(Lanes::Set(m.m[0][0]), ox), Lanes::Mul(Lanes::Set(m.m[0][1]), oy)), Lanes::Mul(Lanes::Set(m.m[0][2]), oz)), Lanes::Set(m.m[0][3]));
+    py = Lanes::Add(Lanes::Add(Lanes::Add(Lanes::Mul(Lanes::Set(m.m[1][0]), ox), Lanes::Mul(Lanes::Set(m.m[1][1]), oy)), Lanes::Mul(Lanes::Set(m.m[1][2]), oz)), Lanes::Set(m.m[1][3]));
+    pz = Lanes::Add(Lanes::Add(Lanes::Add(Lanes::Mul(Lanes::Set(m.m[2][0]), ox), Lanes::Mul(Lanes::Set(m.m[2][1]), oy)), Lanes::Mul(Lanes::Set(m.m[2][2]), oz)), Lanes::Set(m.m[2][3]));
+
+    lx = Lanes::Add(Lanes::Add(Lanes::Mul(Lanes::Set(m.m[0][0]), dx), Lanes::Mul(Lanes::Set(m.m[0][1]), dy)), Lanes::Mul(Lanes::Set(m.m[0][2]), dz));
+    ly = Lanes::Add(Lanes::Add(Lanes::Mul(Lanes::Set(m.m[1][0]), dx), Lanes::Mul(Lanes::Set(m.m[1][1]), dy)), Lanes::Mul(Lanes::Set(m.m[1][2]), dz));
+    lz = Lanes::Add(Lanes::Add(Lanes::Mul(Lanes::Set(m.m[2][0]), dx), Lanes::Mul(Lanes::Set(m.m[2][1]), dy)), Lanes::Mul(Lanes::Set(m.m[2][2]), dz));
+}
+
+// Function to compute the dot product of two vectors held in registers
+static inline Lanes::Vec Dot(Lanes::Vec ax, Lanes::Vec ay, Lanes::Vec az, Lanes::Vec bx, Lanes::Vec by, Lanes::Vec bz)
+{
+    return Lanes::Add(Lanes::Add(Lanes::Mul(ax, bx), Lanes::Mul(ay, by)), Lanes::Mul(az, bz));
+}
+
+// Function to intersect the packet with the unit sphere (see ObjSphere::TestIntersection)
+static void IntersectSphere(const RT::AffineMatrix &bckMatrix, const RT::RayPacket &packet, double *tHit)
+{
+    const Lanes::Vec zero = Lanes::Set(0.0);
+    const Lanes::Vec one = Lanes::Set(1.0);
+    const Lanes::Vec two = Lanes::Set(2.0);
+    const Lanes::Vec four = Lanes::Set(4.0);
+    const Lanes::Vec inf = Lanes::Set(std::numeric_limits<double>::infinity());
+
+    for (int first = 0; first < packet.m_size; first += Lanes::WIDTH)
+    {
+        Lanes::Vec px, py, pz, lx, ly, lz;
+        TransformRays(bckMatrix, packet, first, px, py, pz, lx, ly, lz);
+
+        // Normalize the direction
+        Lanes::Vec labLength = Lanes::Sqrt(Dot(lx, ly, lz, lx, ly, lz));
+        Lanes::Vec invNorm = Lanes::Div(one, labLength);
+        Lanes::Vec vx = Lanes::Mul(lx, invNorm);
+        Lanes::Vec vy = Lanes::Mul(ly, invNorm);
+        Lanes::Vec vz = Lanes::Mul(lz, invNorm);
+
+        // Solve the quadratic (with a = 1)
+        Lanes::Vec b = Lanes::Mul(two, Dot(px, py, pz, vx, vy, vz));
+        Lanes::Vec c = Lanes::Sub(Dot(px, py, pz, px, py, pz), one);
+        Lanes::Vec intTest = Lanes::Sub(Lanes::Mul(b, b), Lanes::Mul(four, c));
+
+        Lanes::Vec numSQRT = Lanes::SqrtFloat(intTest);
+        Lanes::Vec t1 = Lanes::Div(Lanes::Add(Lanes::Neg(b), numSQRT), two);
+        Lanes::Vec t2 = Lanes::Div(Lanes::Sub(Lanes::Neg(b), numSQRT), two);
+
+        /*
+            Convert the roots (t2 <= t1) to the ray parameter and take the nearer one if it is in
+            the ray's interval, otherwise the further one, as ObjSphere::SelectRoot does
+        */
+        Lanes::Vec tMin = Lanes::Load(packet.m_tMin + first);
+        Lanes::Vec tNearRay = Lanes::Div(t2, labLength);
+        Lanes::Vec tRay = Lanes::Select(Lanes::NotLess(tNearRay, tMin), tNearRay, Lanes::Div(t1, labLength));
+
+        // Reject lanes that miss, or whose hits are both outside the interval
+        Lanes::Mask valid = Lanes::Greater(intTest, zero);
+        valid = Lanes::And(valid, Lanes::NotLess(tRay, tMin));
+        valid = Lanes::And(valid, Lanes::NotGreater(tRay, Lanes::Load(packet.m_tMax + first)));
+
+        Lanes::Store(tHit + first, Lanes::Select(valid, tRay, inf));
+    }
+}
+
+// Function to intersect the packet with the unit square in the x-y plane (see ObjPlane::TestIntersection)
+static void IntersectPlane(const RT::AffineMatrix &bckMatrix, const RT::RayPacket &packet, double *tHit)
+{
+    const Lanes::Vec zero = Lanes::Set(0.0);
+    const Lanes::Vec one = Lanes::Set(1.0);
+    const Lanes::Vec epsilon = Lanes::Set(PARALLEL_EPSILON);
+    const Lanes::Vec inf = Lanes::Set(std::numeric_limits<double>::infinity());
+
+    for (int first = 0; first < packet.m_size; first += Lanes::WIDTH)
+    {
+        Lanes::Vec px, py, pz, lx, ly, lz;
+        TransformRays(bckMatrix, packet, first, px, py, pz, lx, ly, lz);
+
+        // Normalize the direction
+        Lanes::Vec labLength = Lanes::Sqrt(Dot(lx, ly, lz, lx, ly, lz));
+        Lanes::Vec invNorm = Lanes::Div(one, labLength);
+        Lanes::Vec kx = Lanes::Mul(lx, invNorm);
+        Lanes::Vec ky = Lanes::Mul(ly, invNorm);
+        Lanes::Vec kz = Lanes::Mul(lz, invNorm);
+
+        // Rays parallel to the plane cannot hit it
+        Lanes::Mask parallel = Lanes::Less(Lanes::Abs(kz), epsilon);
+
+        // Find where the ray crosses the plane, and check that it is in front and within the ray's interval
+        Lanes::Vec t = Lanes::Div(pz, Lanes::Neg(kz));
+        Lanes::Vec tRay = Lanes::Div(t, labLength);
+        Lanes::Mask valid = Lanes::AndNot(parallel, Lanes::Greater(t, zero));
+        valid = Lanes::And(valid, Lanes::NotLess(tRay, Lanes::Load(packet.m_tMin + first)));
+        valid = Lanes::And(valid, Lanes::NotGreater(tRay, Lanes::Load(packet.m_tMax + first)));
+
+        // Check that the point lies within the bounds of the plane
+        Lanes::Vec u = Lanes::Add(px, Lanes::Mul(kx, t));
+        Lanes::Vec v = Lanes::Add(py, Lanes::Mul(ky, t));
+        valid = Lanes::And(valid, Lanes::And(Lanes::Less(Lanes::Abs(u), one), Lanes::Less(Lanes::Abs(v), one)));
+
+        Lanes::Store(tHit + first, Lanes::Select(valid, tRay, inf));
+    }
+}
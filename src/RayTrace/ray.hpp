@@ -1,23 +1,35 @@
 #ifndef RAY_H
 #define RAY_H
 
-#include "../LinAlg/Vector.h"
+#include <limits>
+#include <type_traits>
+#include "../LinAlg/Vector3.hpp"
 
 namespace RT
 {
+    // Rays are created for every pixel and every bounce, so they must not own any heap memory
+    static_assert(std::is_trivially_copyable<Vector3<double>>::value, "Vector3 must be trivially copyable");
+
     class Ray
     {
         public:
             Ray();
-            Ray(const Vector<double> &point1, const Vector<double> &point2);
+            Ray(const Vector3<double> &point1, const Vector3<double> &point2);
 
-            Vector<double> GetPoint1() const;
-            Vector<double> GetPoint2() const;
+            Vector3<double> GetPoint1() const;
+            Vector3<double> GetPoint2() const;
 
         public:
-            Vector<double> m_point1 {3};
-            Vector<double> m_point2 {3};
-            Vector<double> m_lab    {3};
+            Vector3<double> m_point1;
+            Vector3<double> m_point2;
+            Vector3<double> m_lab;
+
+            /*
+                The interval of the ray parameter t, where points on the ray are
+                m_point1 + t * m_lab. Intersections outside [m_tMin, m_tMax] are ignored
+            */
+            double m_tMin = 0.0;
+            double m_tMax = std::numeric_limits<double>::infinity();
     };
 }
 
@@ -0,0 +1,75 @@
+#ifndef RAYPACKET_H
+#define RAYPACKET_H
+
+#include <limits>
+#include "ray.hpp"
+
+namespace RT
+{
+    /*
+        A small group of rays stored as a structure of arrays, so that the packet
+        intersection kernels can load the same component of several rays into one
+        SIMD register. Lanes at and above m_size are padding. Finalize fills them
+        with an empty interval, so that the kernels can process whole registers
+        without producing hits for them
+    */
+    struct RayPacket
+    {
+        static constexpr int MAX_SIZE = 8;
+
+        alignas(64) double m_originX[MAX_SIZE];
+        alignas(64) double m_originY[MAX_SIZE];
+        alignas(64) double m_originZ[MAX_SIZE];
+        alignas(64) double m_labX[MAX_SIZE];
+        alignas(64) double m_labY[MAX_SIZE];
+        alignas(64) double m_labZ[MAX_SIZE];
+        alignas(64) double m_tMin[MAX_SIZE];
+        alignas(64) double m_tMax[MAX_SIZE];
+
+        // The number of rays in the packet
+        int m_size = 0;
+
+        // Function to store a ray in a lane
+        void SetRay(int lane, const RT::Ray &ray)
+        {
+            m_originX[lane] = ray.m_point1.m_x;
+            m_originY[lane] = ray.m_point1.m_y;
+            m_originZ[lane] = ray.m_point1.m_z;
+            m_labX[lane] = ray.m_lab.m_x;
+            m_labY[lane] = ray.m_lab.m_y;
+            m_labZ[lane] = ray.m_lab.m_z;
+            m_tMin[lane] = ray.m_tMin;
+            m_tMax[lane] = ray.m_tMax;
+        }
+
+        // Function to return the ray in a lane
+        RT::Ray GetRay(int lane) const
+        {
+            RT::Ray ray;
+            ray.m_point1 = Vector3<double>{m_originX[lane], m_originY[lane], m_originZ[lane]};
+            ray.m_lab = Vector3<double>{m_labX[lane], m_labY[lane], m_labZ[lane]};
+            ray.m_point2 = ray.m_point1 + ray.m_lab;
+            ray.m_tMin = m_tMin[lane];
+            ray.m_tMax = m_tMax[lane];
+            return ray;
+        }
+
+        // Function to fill the unused lanes with copies of the first ray that can never hit anything
+        void Finalize()
+        {
+            for (int lane = m_size; lane < MAX_SIZE; ++lane)
+            {
+                m_originX[lane] = m_originX[0];
+                m_originY[lane] = m_originY[0];
+                m_originZ[lane] = m_originZ[0];
+                m_labX[lane] = m_labX[0];
+                m_labY[lane] = m_labY[0];
+                m_labZ[lane] = m_labZ[0];
+                m_tMin[lane] = std::numeric_limits<double>::infinity();
+                m_tMax[lane] = -std::numeric_limits<double>::infinity();
+            }
+        }
+    };
+}
+
+#endif
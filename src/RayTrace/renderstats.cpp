@@ -0,0 +1,111 @@
+#include "renderstats.hpp"
+#include <cinttypes>
+
+// Function to add another set of counters
+void RT::RenderCounters::Add(const RT::RenderCounters &other)
+{
+    m_primaryRays += other.m_primaryRays;
+    for (int depth = 0; depth < MAX_COUNTED_DEPTH; ++depth)
+        m_reflectionRays[depth] += other.m_reflectionRays[depth];
+
+    m_hits += other.m_hits;
+    m_misses += other.m_misses;
+    m_shadowRays += other.m_shadowRays;
+    m_shadowRaysOccluded += other.m_shadowRaysOccluded;
+    for (int type = 0; type < RT::NUM_PRIMITIVE_TYPES; ++type)
+        m_intersectionTests[type] += other.m_intersectionTests[type];
+
+    m_intersectionNs += other.m_intersectionNs;
+    m_shadingNs += other.m_shadingNs;
+}
+
+// Function to return the total number of reflection rays
+uint64_t RT::RenderCounters::GetReflectionRays() const
+{
+    uint64_t numRays = 0;
+    for (int depth = 0; depth < MAX_COUNTED_DEPTH; ++depth)
+        numRays += m_reflectionRays[depth];
+
+    return numRays;
+}
+
+// Function to return the total number of rays
+uint64_t RT::RenderStats::GetTotalRays() const
+{
+    return m_totals.m_primaryRays + m_totals.GetReflectionRays() + m_totals.m_shadowRays;
+}
+
+// Function to return the name of a kind of primitive
+const char *RT::RenderStats::GetPrimitiveTypeName(RT::PrimitiveType type)
+{
+    switch (type)
+    {
+        case RT::PrimitiveType::SPHERE: return "sphere";
+        case RT::PrimitiveType::PLANE:  return "plane";
+        case RT::PrimitiveType::MESH:   return "mesh";
+        default:                        return "other";
+    }
+}
+
+// Function to write the statistics as text
+void RT::RenderStats::Print(FILE *file) const
+{
+    const RT::RenderCounters &totals = m_totals;
+    double frameSeconds = m_frameMs / 1000.0;
+    std::fprintf(file, "frame:             %.2f ms (display %.2f ms)\n", m_frameMs, m_displayMs);
+    std::fprintf(file, "primary rays:      %" PRIu64 "\n", totals.m_primaryRays);
+    std::fprintf(file, "reflection rays:   %" PRIu64, totals.GetReflectionRays());
+    for (int depth = 0; depth < RT::RenderCounters::MAX_COUNTED_DEPTH; ++depth)
+    {
+        if (totals.m_reflectionRays[depth] > 0)
+            std::fprintf(file, "  [depth %d: %" PRIu64 "]", depth + 1, totals.m_reflectionRays[depth]);
+    }
+    std::fprintf(file, "\n");
+    std::fprintf(file, "shadow rays:       %" PRIu64 " (%" PRIu64 " occluded)\n", totals.m_shadowRays, totals.m_shadowRaysOccluded);
+    std::fprintf(file, "hits / misses:     %" PRIu64 " / %" PRIu64 "\n", totals.m_hits, totals.m_misses);
+    std::fprintf(file, "intersection tests:");
+    for (int type = 0; type < RT::NUM_PRIMITIVE_TYPES; ++type)
+        std::fprintf(file, " %s %" PRIu64, GetPrimitiveTypeName(static_cast<RT::PrimitiveType>(type)), totals.m_intersectionTests[type]);
+    std::fprintf(file, "\n");
+    std::fprintf(file, "rays / s:          %.0f\n", (frameSeconds > 0.0) ? GetTotalRays() / frameSeconds : 0.0);
+
+    // The times are summed over the threads
+    std::fprintf(file, "thread time:       intersection %.2f ms, shading %.2f ms\n", totals.m_intersectionNs / 1e6, totals.m_shadingNs / 1e6);
+    for (size_t thread = 0; thread < m_perThread.size(); ++thread)
+    {
+        const RT::RenderCounters &counters = m_perThread[thread];
+        std::fprintf
+        (
+            file, "  thread %zu:        %" PRIu64 " primary rays, intersection %.2f ms, shading %.2f ms\n",
+            thread, counters.m_primaryRays, counters.m_intersectionNs / 1e6, counters.m_shadingNs / 1e6
+        );
+    }
+}
+
+// Function to write the counters of one thread, or the totals, as a JSON object
+static void WriteCountersJson(FILE *file, const RT::RenderCounters &counters)
+{
+    std::fprintf(file, "{\"primary_rays\": %" PRIu64 ", \"reflection_rays\": [", counters.m_primaryRays);
+    for (int depth = 0; depth < RT::RenderCounters::MAX_COUNTED_DEPTH; ++depth)
+        std::fprintf(file, "%s%" PRIu64, (depth > 0) ? ", " : "", counters.m_reflectionRays[depth]);
+    std::fprintf(file, "], \"shadow_rays\": %" PRIu64 ", \"shadow_rays_occluded\": %" PRIu64, counters.m_shadowRays, counters.m_shadowRaysOccluded);
+    std::fprintf(file, ", \"hits\": %" PRIu64 ", \"misses\": %" PRIu64 ", \"intersection_tests\": {", counters.m_hits, counters.m_misses);
+    for (int type = 0; type < RT::NUM_PRIMITIVE_TYPES; ++type)
+        std::fprintf(file, "%s\"%s\": %" PRIu64, (type > 0) ? ", " : "", RT::RenderStats::GetPrimitiveTypeName(static_cast<RT::PrimitiveType>(type)), counters.m_intersectionTests[type]);
+    std::fprintf(file, "}, \"intersection_ms\": %.3f, \"shading_ms\": %.3f}", counters.m_intersectionNs / 1e6, counters.m_shadingNs / 1e6);
+}
+
+// Function to write the statistics as JSON
+void RT::RenderStats::WriteJson(FILE *file) const
+{
+    std::fprintf(file, "{\"frame_ms\": %.3f, \"display_ms\": %.3f, \"total_rays\": %" PRIu64 ", \"totals\": ", m_frameMs, m_displayMs, GetTotalRays());
+    WriteCountersJson(file, m_totals);
+    std::fprintf(file, ", \"threads\": [");
+    for (size_t thread = 0; thread < m_perThread.size(); ++thread)
+    {
+        if (thread > 0)
+            std::fprintf(file, ", ");
+        WriteCountersJson(file, m_perThread[thread]);
+    }
+    std::fprintf(file, "]}");
+}
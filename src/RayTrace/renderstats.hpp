@@ -0,0 +1,111 @@
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "./Primatives/objectbase.hpp"
+
+namespace RT
+{
+    /*
+        Counts of the work done by one render thread. While a thread renders with counting
+        enabled, its counters are reachable through GetCurrent, so the code that does the
+        work (eg. the BVH queries) can count it without the counters being passed down.
+        When counting is disabled GetCurrent returns null, and the only cost is that test.
+        Each thread's counters fill whole cache lines, so threads never share one.
+    */
+    struct alignas(64) RenderCounters
+    {
+        // Reflection rays are counted by depth, those deeper than this are counted with the deepest
+        static constexpr int MAX_COUNTED_DEPTH = 15;
+
+        // Rays leaving the camera
+        uint64_t m_primaryRays = 0;
+
+        // Rays reflected off a surface, where m_reflectionRays[i] counts the rays that are the
+        // (i + 1)th reflection along their path
+        uint64_t m_reflectionRays[MAX_COUNTED_DEPTH] = {};
+
+        // Closest-hit queries (camera and reflection rays) that hit something, and that did not
+        uint64_t m_hits = 0;
+        uint64_t m_misses = 0;
+
+        // Shadow rays, and how many of them were blocked
+        uint64_t m_shadowRays = 0;
+        uint64_t m_shadowRaysOccluded = 0;
+
+        // Ray-object tests by kind of primitive (a packet of rays counts one test per ray)
+        uint64_t m_intersectionTests[RT::NUM_PRIMITIVE_TYPES] = {};
+
+        // Time spent finding the objects hit by camera rays, and shading the hits (including
+        // the shadow and reflection rays that this needs), in nanoseconds
+        int64_t m_intersectionNs = 0;
+        int64_t m_shadingNs = 0;
+
+        // Function to add another set of counters to this one
+        void Add(const RT::RenderCounters &other);
+
+        // Functions to count common events
+        // depth is the number of reflections along the path, including this one
+        void CountReflectionRays(int depth, uint64_t numRays)
+        {
+            m_reflectionRays[(depth < MAX_COUNTED_DEPTH) ? depth - 1 : MAX_COUNTED_DEPTH - 1] += numRays;
+        }
+
+        void CountIntersectionTests(RT::PrimitiveType type, uint64_t numTests)
+        {
+            m_intersectionTests[static_cast<int>(type)] += numTests;
+        }
+
+        // Function to return the total number of reflection rays
+        uint64_t GetReflectionRays() const;
+
+        // Functions to set and return the counters of the calling thread, or null if it is not counting
+        static void SetCurrent(RT::RenderCounters *pCounters)
+        {
+            s_pCurrent = pCounters;
+        }
+
+        static RT::RenderCounters *GetCurrent()
+        {
+            return s_pCurrent;
+        }
+
+        // Function to return a timestamp for the timing counters, in nanoseconds
+        static int64_t Now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // The counters of the calling thread
+        static inline thread_local RT::RenderCounters *s_pCurrent = nullptr;
+    };
+
+    /*
+        The statistics of a frame: the counters of each render thread and their sum, the wall
+        clock time of the frame and the time the application spent displaying it (which the
+        renderer cannot see, so it is filled in by the application)
+    */
+    struct RenderStats
+    {
+        RT::RenderCounters m_totals;
+        std::vector<RT::RenderCounters> m_perThread;
+
+        double m_frameMs = 0.0;
+        double m_displayMs = 0.0;
+
+        // Function to return the total number of rays of every kind
+        uint64_t GetTotalRays() const;
+
+        // Functions to write the statistics as readable text, or as a single JSON object
+        void Print(FILE *file) const;
+        void WriteJson(FILE *file) const;
+
+        // Function to return the name of a kind of primitive
+        static const char *GetPrimitiveTypeName(RT::PrimitiveType type);
+    };
+}
+
+#endif
@@ -1,4 +1,8 @@
 #include "scene.hpp"
+#include "tracer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 
 // The constructor
 RT::Scene::Scene()
@@ -10,203 +14,696 @@ RT::Scene::Scene()
     auto floorMaterial = std::make_shared<RT::SimpleMaterial> (RT::SimpleMaterial());
 
     // Setup the materials
-    testMaterial1 -> m_baseColor = Vector<double> {std::vector<double>{0.25, 0.5, 0.8}};
+    testMaterial1 -> m_baseColor = Vector3<double>{0.25, 0.5, 0.8};
     testMaterial1 -> m_reflectivity = 0.5;
     testMaterial1 -> m_shininess = 10.0;
     
-    testMaterial2 -> m_baseColor = Vector<double> {std::vector<double>{1.0, 0.5, 0.0}};
+    testMaterial2 -> m_baseColor = Vector3<double>{1.0, 0.5, 0.0};
     testMaterial2 -> m_reflectivity = 0.75;
     testMaterial2 -> m_shininess = 10.0;
 
-    testMaterial3 -> m_baseColor = Vector<double> {std::vector<double>{1.0, 0.8, 0.0}};
+    testMaterial3 -> m_baseColor = Vector3<double>{1.0, 0.8, 0.0};
     testMaterial3 -> m_reflectivity = 0.25;
     testMaterial3 -> m_shininess = 10.0;
 
-    floorMaterial -> m_baseColor = Vector<double> {std::vector<double>{1.0, 1.0, 1.0}};
+    floorMaterial -> m_baseColor = Vector3<double>{1.0, 1.0, 1.0};
     floorMaterial -> m_reflectivity = 0.5;
     floorMaterial -> m_shininess = 0.0;
 
     // Configure the camera
-    m_camera.SetPosition( Vector<double>{std::vector<double>{0.0, -10.0, -1.0}} );
-    m_camera.SetLookAt  ( Vector<double>{std::vector<double>{0.0, 0.0, 0.0}} );
-    m_camera.SetUp      ( Vector<double>{std::vector<double>{0.0, 0.0, 1.0}} );
+    m_camera.SetPosition( Vector3<double>{0.0, -10.0, -1.0} );
+    m_camera.SetLookAt  ( Vector3<double>{0.0, 0.0, 0.0} );
+    m_camera.SetUp      ( Vector3<double>{0.0, 0.0, 1.0} );
     m_camera.SetHorzSize(0.25);
     m_camera.SetAspect(16.0 / 9.0);
     m_camera.UpdateCameraGeometry();
     
     // Construct test spheres
-    m_objectList.push_back(std::make_shared<RT::ObjSphere> (RT::ObjSphere()));
-    m_objectList.push_back(std::make_shared<RT::ObjSphere> (RT::ObjSphere()));
-    m_objectList.push_back(std::make_shared<RT::ObjSphere> (RT::ObjSphere()));
+    std::vector<std::shared_ptr<RT::ObjectBase>> objectList;
+    objectList.push_back(std::make_shared<RT::ObjSphere> (RT::ObjSphere()));
+    objectList.push_back(std::make_shared<RT::ObjSphere> (RT::ObjSphere()));
+    objectList.push_back(std::make_shared<RT::ObjSphere> (RT::ObjSphere()));
 
     // Construct a test plane
-    m_objectList.push_back(std::make_shared<RT::ObjPlane> (RT::ObjPlane()));
-    m_objectList.at(3) -> m_baseColor = Vector<double>{std::vector<double> {0.5, 0.5, 0.5}};
+    objectList.push_back(std::make_shared<RT::ObjPlane> (RT::ObjPlane()));
+    objectList.at(3) -> m_baseColor = Vector3<double>{0.5, 0.5, 0.5};
 
     // Define a transform for the plane
     RT::GTform planeMatrix;
     planeMatrix.SetTransform
     (
-        Vector<double>{std::vector<double>{0.0, 0.0, 0.75}},
-        Vector<double>{std::vector<double>{0.0, 0.0, 0.0}},
-        Vector<double>{std::vector<double>{4.0, 4.0, 1.0}}
+        Vector3<double>{0.0, 0.0, 0.75},
+        Vector3<double>{0.0, 0.0, 0.0},
+        Vector3<double>{4.0, 4.0, 1.0}
     );
-    m_objectList.at(3) -> SetTransformMatrix(planeMatrix);
+    objectList.at(3) -> SetTransformMatrix(planeMatrix);
 
     // Modify the spheres
     RT::GTform testMatrix1, testMatrix2, testMatrix3;
     testMatrix1.SetTransform
     (
-        Vector<double>{std::vector<double>{-1.5, 0.0, 0.0}},
-        Vector<double>{std::vector<double>{0.0, 0.0, 0.0}},
-        Vector<double>{std::vector<double>{0.5, 0.5, 0.75}}
+        Vector3<double>{-1.5, 0.0, 0.0},
+        Vector3<double>{0.0, 0.0, 0.0},
+        Vector3<double>{0.5, 0.5, 0.75}
     );
     testMatrix2.SetTransform
     (
-        Vector<double>{std::vector<double>{0.0, 0.0, 0.0}},
-        Vector<double>{std::vector<double>{0.0, 0.0, 0.0}},
-        Vector<double>{std::vector<double>{0.75, 0.5, 0.5}}
+        Vector3<double>{0.0, 0.0, 0.0},
+        Vector3<double>{0.0, 0.0, 0.0},
+        Vector3<double>{0.75, 0.5, 0.5}
     );
     testMatrix3.SetTransform
     (
-        Vector<double>{std::vector<double>{1.5, 0.0, 0.0}},
-        Vector<double>{std::vector<double>{0.0, 0.0, 0.0}},
-        Vector<double>{std::vector<double>{0.75, 0.75, 0.75}}
+        Vector3<double>{1.5, 0.0, 0.0},
+        Vector3<double>{0.0, 0.0, 0.0},
+        Vector3<double>{0.75, 0.75, 0.75}
     );
 
-    m_objectList.at(0) -> SetTransformMatrix(testMatrix1);
-    m_objectList.at(1) -> SetTransformMatrix(testMatrix2);
-    m_objectList.at(2) -> SetTransformMatrix(testMatrix3);
+    objectList.at(0) -> SetTransformMatrix(testMatrix1);
+    objectList.at(1) -> SetTransformMatrix(testMatrix2);
+    objectList.at(2) -> SetTransformMatrix(testMatrix3);
 
-    m_objectList.at(0) -> m_baseColor = Vector<double>{std::vector<double>{0.25, 0.5, 0.8}};
-    m_objectList.at(1) -> m_baseColor = Vector<double>{std::vector<double>{1.0, 0.5, 0.0}};
-    m_objectList.at(2) -> m_baseColor = Vector<double>{std::vector<double>{1.0, 0.8, 0.0}};
+    objectList.at(0) -> m_baseColor = Vector3<double>{0.25, 0.5, 0.8};
+    objectList.at(1) -> m_baseColor = Vector3<double>{1.0, 0.5, 0.0};
+    objectList.at(2) -> m_baseColor = Vector3<double>{1.0, 0.8, 0.0};
 
     // Assign materials to objects
-    m_objectList.at(0) -> AssignMaterial(testMaterial1);
-    m_objectList.at(1) -> AssignMaterial(testMaterial2);
-    m_objectList.at(2) -> AssignMaterial(testMaterial3);
-    m_objectList.at(3) -> AssignMaterial(floorMaterial);
+    objectList.at(0) -> AssignMaterial(testMaterial1);
+    objectList.at(1) -> AssignMaterial(testMaterial2);
+    objectList.at(2) -> AssignMaterial(testMaterial3);
+    objectList.at(3) -> AssignMaterial(floorMaterial);
+
+    // Add the objects to the scene, now that they are set up
+    for (const auto &object : objectList)
+        AddObject(*object);
 
     // Construct a test light
     m_lightList.push_back(std::make_shared<RT::PointLight> (RT::PointLight()));
-    m_lightList.at(0) -> m_location = Vector<double> {std::vector<double> {5.0, -10.0, -5.0}};
-    m_lightList.at(0) -> m_color = Vector<double> {std::vector<double> {0.0, 0.0, 1.0}};
+    m_lightList.at(0) -> m_location = Vector3<double>{5.0, -10.0, -5.0};
+    m_lightList.at(0) -> m_color = Vector3<double>{0.0, 0.0, 1.0};
     
     m_lightList.push_back(std::make_shared<RT::PointLight> (RT::PointLight()));
-    m_lightList.at(1) -> m_location = Vector<double> {std::vector<double> {-5.0, -10.0, -5.0}};
-    m_lightList.at(1) -> m_color = Vector<double> {std::vector<double> {1.0, 0.0, 0.0}};
+    m_lightList.at(1) -> m_location = Vector3<double>{-5.0, -10.0, -5.0};
+    m_lightList.at(1) -> m_color = Vector3<double>{1.0, 0.0, 0.0};
 	
 	m_lightList.push_back(std::make_shared<RT::PointLight> (RT::PointLight()));
-	m_lightList.at(2) -> m_location = Vector<double> {std::vector<double> {0.0, -10.0, -5.0}};
-	m_lightList.at(2) -> m_color = Vector<double> {std::vector<double> {0.0, 1.0, 0.0}};
+	m_lightList.at(2) -> m_location = Vector3<double>{0.0, -10.0, -5.0};
+	m_lightList.at(2) -> m_color = Vector3<double>{0.0, 1.0, 0.0};
 
 }
 
 // Function to perform the rendering
 bool RT::Scene::Render(Image &outputImage)
 {
+    RT::TraceScope frameScope("frame");
+
     // Get the dimensions of the output image
     int xSize = outputImage.GetXSize();
     int ySize = outputImage.GetYSize();
 
-    RT::Ray cameraRay;
-    Vector<double> intPoint     {3};
-    Vector<double> localNormal  {3};
-    Vector<double> localColor   {3};
-    double xFact = 1.0 / (static_cast<double>(xSize) / 2.0);
-    double yFact = 1.0 / (static_cast<double>(ySize) / 2.0);
-    double minDist = 1e6;
-    double maxDist = 0.0;
-
-    for (int x = 0; x < xSize; ++x)
+    // Make sure the BVH matches the current objects before any rays are cast
+    UpdateBVH();
+
+    // Split the image into tiles
+    int numTilesX = (xSize + m_tileSize - 1) / m_tileSize;
+    int numTilesY = (ySize + m_tileSize - 1) / m_tileSize;
+
+    // Get the worker threads and their tile buffers ready
+    auto startTime = std::chrono::steady_clock::now();
+    PrepareWorkers(m_tileSize);
+    m_threadCounters.clear();
+    PrepareStats();
+
+    // Render the tiles in parallel. Each pixel only depends on the scene, so the result
+    // is identical to rendering the pixels one after another
+    m_pThreadPool -> Run(numTilesX * numTilesY, [&](int tileIndex, int threadIndex)
+    {
+        RT::TraceScope tileScope("tile", "tile", tileIndex);
+        RT::RenderCounters::SetCurrent(GetThreadCounters(threadIndex));
+        int x0 = (tileIndex % numTilesX) * m_tileSize;
+        int y0 = (tileIndex / numTilesX) * m_tileSize;
+        int x1 = std::min(x0 + m_tileSize, xSize);
+        int y1 = std::min(y0 + m_tileSize, ySize);
+        if (m_wavefront)
+            RenderTileWavefront(outputImage, *m_wavefrontRenderers[threadIndex], m_tileBuffers[threadIndex].data(), x0, y0, x1, y1);
+        else
+            RenderTile(outputImage, m_tileBuffers[threadIndex].data(), x0, y0, x1, y1);
+        RT::RenderCounters::SetCurrent(nullptr);
+    });
+
+    CollectStats(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+    return true;
+}
+
+// Function to start a new progressive render
+void RT::Scene::StartProgressive(const Image &outputImage)
+{
+    m_progressiveStep = PROGRESSIVE_INITIAL_STEP;
+    m_progressiveNextTile = 0;
+    m_progressiveXSize = outputImage.GetXSize();
+    m_progressiveYSize = outputImage.GetYSize();
+    m_progressiveMs = 0.0;
+    m_threadCounters.clear();
+}
+
+// Function to continue a progressive render for up to timeBudgetMs
+bool RT::Scene::RenderProgressive(Image &outputImage, double timeBudgetMs)
+{
+    return RenderProgressive(outputImage, timeBudgetMs, nullptr, TileCallback());
+}
+
+bool RT::Scene::RenderProgressive
+(
+    Image &outputImage, double timeBudgetMs,
+    const RT::CancelToken *pCancel, const TileCallback &onTileDone
+) {
+    if (IsProgressiveComplete())
+        return true;
+
+    RT::TraceScope frameScope("progressive frame");
+
+    // Start again if the image has changed size since StartProgressive
+    if ((outputImage.GetXSize() != m_progressiveXSize) || (outputImage.GetYSize() != m_progressiveYSize))
+        StartProgressive(outputImage);
+
+    auto startTime = std::chrono::steady_clock::now();
+    UpdateBVH();
+    PrepareWorkers(PROGRESSIVE_TILE_SIZE);
+    PrepareStats();
+
+    int numTilesX = (m_progressiveXSize + PROGRESSIVE_TILE_SIZE - 1) / PROGRESSIVE_TILE_SIZE;
+    int numTilesY = (m_progressiveYSize + PROGRESSIVE_TILE_SIZE - 1) / PROGRESSIVE_TILE_SIZE;
+    int numTiles = numTilesX * numTilesY;
+
+    // Without a time limit each batch is the rest of the pass
+    int batchSize = std::isinf(timeBudgetMs) ? numTiles : m_pThreadPool -> GetNumThreads();
+
+    /*
+        Render batches of one tile per thread until the next batch would probably not
+        finish within the budget. At least one batch is always rendered, so the render
+        completes however small the budget. A batch never spans two passes, because each
+        pass reads the samples written by the previous one
+    */
+    double lastBatchMs = 0.0;
+    while (!IsProgressiveComplete())
     {
-        for (int y = 0; y < ySize; ++y)
+        if ((pCancel != nullptr) && pCancel -> IsCancelled())
+            return false;
+
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        if ((lastBatchMs > 0.0) && (elapsedMs + lastBatchMs > timeBudgetMs))
+            break;
+
+        auto batchStart = std::chrono::steady_clock::now();
+        int firstTile = m_progressiveNextTile;
+        int batchTiles = std::min(batchSize, numTiles - firstTile);
+        int step = m_progressiveStep;
+        RT::TraceScope batchScope("pass batch", "step", step);
+        m_pThreadPool -> Run(batchTiles, [&](int taskIndex, int threadIndex)
+        {
+            int tileIndex = firstTile + taskIndex;
+            RT::TraceScope tileScope("tile", "tile", tileIndex);
+            RT::RenderCounters::SetCurrent(GetThreadCounters(threadIndex));
+            int x0 = (tileIndex % numTilesX) * PROGRESSIVE_TILE_SIZE;
+            int y0 = (tileIndex / numTilesX) * PROGRESSIVE_TILE_SIZE;
+            int x1 = std::min(x0 + PROGRESSIVE_TILE_SIZE, m_progressiveXSize);
+            int y1 = std::min(y0 + PROGRESSIVE_TILE_SIZE, m_progressiveYSize);
+            if (RenderProgressiveTile(outputImage, m_tileBuffers[threadIndex].data(), step, x0, y0, x1, y1, pCancel) && onTileDone)
+            {
+                RT::TileRect tile;
+                tile.m_x0 = x0;
+                tile.m_y0 = y0;
+                tile.m_x1 = x1;
+                tile.m_y1 = y1;
+                onTileDone(tile);
+            }
+            RT::RenderCounters::SetCurrent(nullptr);
+        });
+        lastBatchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - batchStart).count();
+
+        // Move on to the next tiles, or to the next, finer, pass
+        m_progressiveNextTile += batchTiles;
+        if (m_progressiveNextTile >= numTiles)
         {
-            // Normalize the x and y coordinates
-            double normX = (static_cast<double>(x) * xFact) - 1.0;
-            double normY = (static_cast<double>(y) * yFact) - 1.0;
-
-            // Generate the ray for this pixel
-            m_camera.GenerateRay(normX, normY, cameraRay);
-
-            // Test for intersections for all objects on the scene
-            std::shared_ptr<RT::ObjectBase> closestObject;
-            Vector<double> closestIntPoint      {3};
-            Vector<double> closestLocalNormal   {3};
-            Vector<double> closestLocalColor    {3};
-            bool intersectionFound = CastRay(cameraRay, closestObject, closestIntPoint, closestLocalNormal, closestLocalColor);
-            
-            // Compute the illumination for the closest object, assuming that there was a valid intersection
-			if (intersectionFound)
-			{
-				// Check if the object has a material
-				if (closestObject -> m_hasMaterial)
-				{
-					// Use the material to compute the color
-					RT::MaterialBase::m_reflectionRayCount = 0;
-					Vector<double> color = closestObject -> m_pMaterial -> ComputeColor
-                    (
-                        m_objectList, m_lightList,
-						closestObject, closestIntPoint,
-						closestLocalNormal, cameraRay
-                    );
-					outputImage.SetPixel(x, y, color.GetElement(0), color.GetElement(1), color.GetElement(2));
-				}
-				else
-				{
-					// Use the basic method to compute the color.
-					Vector<double> matColor = RT::MaterialBase::ComputeDiffuseColor
-                    (
-                        m_objectList, m_lightList,
-						closestObject, closestIntPoint,
-						closestLocalNormal, closestObject->m_baseColor
-                    );
-					outputImage.SetPixel(x, y, matColor.GetElement(0), matColor.GetElement(1), matColor.GetElement(2));
-				}
-			}
+            m_progressiveNextTile = 0;
+            m_progressiveStep /= 2;
         }
     }
 
-    return true;
+    // The statistics cover every pass since StartProgressive
+    m_progressiveMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    CollectStats(m_progressiveMs);
+    return IsProgressiveComplete();
 }
 
-// Function to cast a ray into the scene
-bool RT::Scene::CastRay
+// Function to test whether the progressive render has finished
+bool RT::Scene::IsProgressiveComplete() const
+{
+    return m_progressiveStep < 1;
+}
+
+// Function to make sure that the worker threads and their tile buffers are ready
+void RT::Scene::PrepareWorkers(int tileSize)
+{
+    // (Re)create the worker threads if the configuration has changed
+    if ((!m_pThreadPool) || (m_pThreadPool -> GetNumThreads() != m_numThreads))
+        m_pThreadPool = std::make_unique<RT::ThreadPool> (m_numThreads);
+
+    // Each thread renders into its own tile buffer, which is reused from frame to frame
+    size_t tileValues = static_cast<size_t>(tileSize) * static_cast<size_t>(tileSize) * Image::NUM_CHANNELS;
+    m_tileBuffers.resize(m_pThreadPool -> GetNumThreads());
+    for (auto &tileBuffer : m_tileBuffers)
+    {
+        if (tileBuffer.size() < tileValues)
+            tileBuffer.resize(tileValues);
+    }
+
+    if (m_wavefront)
+    {
+        while (m_wavefrontRenderers.size() < m_tileBuffers.size())
+            m_wavefrontRenderers.push_back(std::make_unique<RT::WavefrontRenderer> ());
+    }
+}
+
+// Function to give each worker thread its counters, if statistics are being collected.
+// Counters that already exist are kept, so they can add up over several calls
+void RT::Scene::PrepareStats()
+{
+    if (m_statsEnabled)
+        m_threadCounters.resize(m_pThreadPool -> GetNumThreads());
+}
+
+// Function to return the counters of a worker thread, or null if statistics are not being collected
+RT::RenderCounters *RT::Scene::GetThreadCounters(int threadIndex)
+{
+    return m_statsEnabled ? &m_threadCounters[threadIndex] : nullptr;
+}
+
+// Function to add up the counters of the worker threads
+void RT::Scene::CollectStats(double frameMs)
+{
+    if (!m_statsEnabled)
+        return;
+
+    m_stats = RT::RenderStats();
+    m_stats.m_perThread = m_threadCounters;
+    for (const auto &counters : m_threadCounters)
+        m_stats.m_totals.Add(counters);
+    m_stats.m_frameMs = frameMs;
+}
+
+// Functions to control the collection of statistics
+void RT::Scene::SetStatsEnabled(bool enabled)
+{
+    m_statsEnabled = enabled;
+}
+
+bool RT::Scene::GetStatsEnabled() const
+{
+    return m_statsEnabled;
+}
+
+const RT::RenderStats &RT::Scene::GetStats() const
+{
+    return m_stats;
+}
+
+// Function to move the camera
+void RT::Scene::MoveCamera(const Vector3<double> &offset)
+{
+    m_camera.SetPosition(m_camera.GetPosition() + offset);
+    m_camera.UpdateCameraGeometry();
+}
+
+// Functions to build a scene from code
+void RT::Scene::ClearScene()
+{
+    m_bvh.GetObjects().Clear();
+    m_lightList.clear();
+}
+
+bool RT::Scene::AddObject(const RT::ObjectBase &object)
+{
+    return m_bvh.GetObjects().Add(object);
+}
+
+void RT::Scene::AddLight(const std::shared_ptr<RT::LightBase> &light)
+{
+    m_lightList.push_back(light);
+}
+
+RT::Camera &RT::Scene::GetCamera()
+{
+    return m_camera;
+}
+
+// Functions to return the contents of the scene
+const RT::ObjectStore &RT::Scene::GetObjects() const
+{
+    return m_bvh.GetObjects();
+}
+
+const std::vector<std::shared_ptr<RT::LightBase>> &RT::Scene::GetLightList() const
+{
+    return m_lightList;
+}
+
+const RT::BVH &RT::Scene::GetBVH()
+{
+    UpdateBVH();
+    return m_bvh;
+}
+
+void RT::Scene::SetBVH(RT::BVH &&bvh)
+{
+    m_bvh = std::move(bvh);
+}
+
+// Function to return the memory used by the objects
+size_t RT::Scene::GetObjectMemorySize()
+{
+    UpdateBVH();
+    return m_bvh.GetMemorySize();
+}
+
+// Function to rebuild the BVH when needed
+void RT::Scene::UpdateBVH()
+{
+    if (m_bvh.NeedsRebuild())
+        m_bvh.Build();
+}
+
+// Functions to configure the parallel renderer
+void RT::Scene::SetThreadCount(int numThreads)
+{
+    m_numThreads = (numThreads < 1) ? RT::ThreadPool::DefaultThreadCount() : numThreads;
+}
+
+void RT::Scene::SetTileSize(int tileSize)
+{
+    if (tileSize < 1)
+        throw std::invalid_argument("Tile size must be at least one pixel.");
+
+    m_tileSize = tileSize;
+}
+
+int RT::Scene::GetThreadCount() const
+{
+    return m_numThreads;
+}
+
+int RT::Scene::GetTileSize() const
+{
+    return m_tileSize;
+}
+
+// Functions to set and return the reflection depth limit
+void RT::Scene::SetMaxReflectionDepth(int maxDepth)
+{
+    if (maxDepth < 0)
+        throw std::invalid_argument("Maximum reflection depth cannot be negative.");
+
+    m_maxReflectionDepth = maxDepth;
+}
+
+int RT::Scene::GetMaxReflectionDepth() const
+{
+    return m_maxReflectionDepth;
+}
+
+// Functions to choose the wavefront renderer
+void RT::Scene::SetWavefront(bool wavefront)
+{
+    m_wavefront = wavefront;
+}
+
+bool RT::Scene::GetWavefront() const
+{
+    return m_wavefront;
+}
+
+// Function to render one tile of the image
+void RT::Scene::RenderTile(Image &outputImage, float *tileBuffer, int x0, int y0, int x1, int y1)
+{
+    double xFact = 1.0 / (static_cast<double>(outputImage.GetXSize()) / 2.0);
+    double yFact = 1.0 / (static_cast<double>(outputImage.GetYSize()) / 2.0);
+
+    // Render the tile row by row into the tile buffer, a packet of pixels at a time
+    float *pixel = tileBuffer;
+    int xs[RT::RayPacket::MAX_SIZE];
+    Vector3<double> colors[RT::RayPacket::MAX_SIZE];
+    for (int y = y0; y < y1; ++y)
+    {
+        for (int x = x0; x < x1; x += RT::RayPacket::MAX_SIZE)
+        {
+            int numPixels = std::min(RT::RayPacket::MAX_SIZE, x1 - x);
+            for (int i = 0; i < numPixels; ++i)
+                xs[i] = x + i;
+
+            RenderPixels(xs, numPixels, y, xFact, yFact, colors);
+            for (int i = 0; i < numPixels; ++i)
+            {
+                pixel[0] = static_cast<float>(colors[i].m_x);
+                pixel[1] = static_cast<float>(colors[i].m_y);
+                pixel[2] = static_cast<float>(colors[i].m_z);
+                pixel += Image::NUM_CHANNELS;
+            }
+        }
+    }
+
+    // Then copy it into the image in one go. The tile is always inside the image
+    outputImage.WriteTile(x0, y0, x1 - x0, y1 - y0, tileBuffer);
+}
+
+// Function to render one tile of the image with a wavefront renderer
+void RT::Scene::RenderTileWavefront(Image &outputImage, RT::WavefrontRenderer &renderer, float *tileBuffer, int x0, int y0, int x1, int y1)
+{
+    double xFact = 1.0 / (static_cast<double>(outputImage.GetXSize()) / 2.0);
+    double yFact = 1.0 / (static_cast<double>(outputImage.GetYSize()) / 2.0);
+
+    renderer.RenderTile(m_camera, m_bvh, m_lightList, m_maxReflectionDepth, x0, y0, x1, y1, xFact, yFact, tileBuffer);
+    outputImage.WriteTile(x0, y0, x1 - x0, y1 - y0, tileBuffer);
+}
+
+/*
+    Function to render one tile of a progressive pass. Pixels on a grid of spacing step are
+    sampled and each sample fills the step x step block below and to the right of it. Grid
+    points that were already sampled by the previous, coarser, pass are copied from the image
+    rather than rendered again, so every pixel is rendered exactly once over all of the passes
+*/
+bool RT::Scene::RenderProgressiveTile
 (
-    RT::Ray &castRay, std::shared_ptr<RT::ObjectBase> &closestObject,
-    Vector<double> &closestIntPoint, Vector<double> &closestLocalNormal,
-    Vector<double> &closestLocalColor
+    Image &outputImage, float *tileBuffer, int step, int x0, int y0, int x1, int y1,
+    const RT::CancelToken *pCancel
 ) {
-    Vector<double> intPoint      {3};
-    Vector<double> localNormal   {3};
-    Vector<double> localColor    {3};
-    double minDist = 1e6;
-    bool intersectionFound = false;
-    for (auto currentObject : m_objectList)
+    double xFact = 1.0 / (static_cast<double>(outputImage.GetXSize()) / 2.0);
+    double yFact = 1.0 / (static_cast<double>(outputImage.GetYSize()) / 2.0);
+    int width = x1 - x0;
+
+    for (int y = y0; y < y1; y += step)
     {
-        bool validInt = currentObject -> TestIntersection(castRay, intPoint, localNormal, localColor);
+        if ((pCancel != nullptr) && pCancel -> IsCancelled())
+            return false;
 
-        // If we have a valid intersection, change the pixel color to red
-        if (validInt)
+        // Work along the row in chunks of one packet's worth of grid points
+        for (int chunkX = x0; chunkX < x1; chunkX += step * RT::RayPacket::MAX_SIZE)
         {
-            // Set the flag to indicate that we found an intersection
-            intersectionFound = true;
+            int chunkEnd = std::min(x1, chunkX + (step * RT::RayPacket::MAX_SIZE));
+
+            // Gather the grid points that the previous pass has not sampled, and render them together
+            int xs[RT::RayPacket::MAX_SIZE];
+            int numPixels = 0;
+            for (int x = chunkX; x < chunkEnd; x += step)
+            {
+                bool sampled = (step < PROGRESSIVE_INITIAL_STEP) && ((x % (2 * step)) == 0) && ((y % (2 * step)) == 0);
+                if (!sampled)
+                    xs[numPixels++] = x;
+            }
 
-            // Compute the distance between the camera and the point of intersection
-            double dist = (intPoint - castRay.m_point1).norm();
+            Vector3<double> colors[RT::RayPacket::MAX_SIZE];
+            RenderPixels(xs, numPixels, y, xFact, yFact, colors);
 
-            // If this object is closer to the camera than any one that we have seen before, then store a reference to it
-            if (dist < minDist)
+            int nextPixel = 0;
+            for (int x = chunkX; x < chunkEnd; x += step)
             {
-                minDist = dist;
-                closestObject = currentObject;
-                closestIntPoint = intPoint;
-                closestLocalNormal = localNormal;
-                closestLocalColor = localColor;
+                float color[Image::NUM_CHANNELS];
+                if ((nextPixel < numPixels) && (xs[nextPixel] == x))
+                {
+                    color[0] = static_cast<float>(colors[nextPixel].m_x);
+                    color[1] = static_cast<float>(colors[nextPixel].m_y);
+                    color[2] = static_cast<float>(colors[nextPixel].m_z);
+                    ++nextPixel;
+                }
+                else
+                {
+                    outputImage.GetPixelUnchecked(x, y, color[0], color[1], color[2]);
+                }
+
+                // Fill the block
+                for (int blockY = y; blockY < std::min(y + step, y1); ++blockY)
+                {
+                    float *pixel = tileBuffer + (static_cast<size_t>(blockY - y0) * width + (x - x0)) * Image::NUM_CHANNELS;
+                    for (int blockX = x; blockX < std::min(x + step, x1); ++blockX, pixel += Image::NUM_CHANNELS)
+                    {
+                        pixel[0] = color[0];
+                        pixel[1] = color[1];
+                        pixel[2] = color[2];
+                    }
+                }
             }
         }
     }
 
-    return intersectionFound;
+    outputImage.WriteTile(x0, y0, width, y1 - y0, tileBuffer);
+    return true;
+}
+
+// Function to compute the color of a single pixel
+Vector3<double> RT::Scene::RenderPixel(int x, int y, double xFact, double yFact)
+{
+    // Normalize the x and y coordinates
+    double normX = (static_cast<double>(x) * xFact) - 1.0;
+    double normY = (static_cast<double>(y) * yFact) - 1.0;
+
+    // Generate the ray for this pixel
+    RT::Ray cameraRay;
+    m_camera.GenerateRay(normX, normY, cameraRay);
+
+    // Test for intersections for all objects on the scene
+    RT::BVH::ObjectHandle closestObject;
+    Vector3<double> closestIntPoint;
+    Vector3<double> closestLocalNormal;
+    Vector3<double> closestLocalColor;
+    bool intersectionFound = m_bvh.CastRay(cameraRay, RT::BVH::NO_OBJECT, closestObject, closestIntPoint, closestLocalNormal, closestLocalColor);
+
+    // Compute the illumination for the closest object, assuming that there was a valid intersection
+    if (intersectionFound)
+        return ShadeHit(closestObject, closestIntPoint, closestLocalNormal, cameraRay, nullptr);
+
+    // Nothing was hit, so the pixel is black
+    return Vector3<double>();
+}
+
+// Function to compute the colors of a packet of pixels
+void RT::Scene::RenderPixels(const int *xs, int numPixels, int y, double xFact, double yFact, Vector3<double> *colors)
+{
+    constexpr int MAX_SIZE = RT::RayPacket::MAX_SIZE;
+    if (numPixels <= 0)
+        return;
+
+    // Generate the camera rays, exactly as RenderPixel does
+    double normY = (static_cast<double>(y) * yFact) - 1.0;
+    RT::Ray cameraRays[MAX_SIZE];
+    RT::RayPacket packet;
+    packet.m_size = numPixels;
+    for (int lane = 0; lane < numPixels; ++lane)
+    {
+        double normX = (static_cast<double>(xs[lane]) * xFact) - 1.0;
+        m_camera.GenerateRay(normX, normY, cameraRays[lane]);
+        packet.SetRay(lane, cameraRays[lane]);
+    }
+    packet.Finalize();
+
+    RT::RenderCounters *pCounters = RT::RenderCounters::GetCurrent();
+    int64_t startTime = 0;
+    if (pCounters != nullptr)
+    {
+        pCounters -> m_primaryRays += numPixels;
+        startTime = RT::RenderCounters::Now();
+    }
+
+    // Find the closest object for every ray at once
+    RT::BVH::ObjectHandle closestObjects[MAX_SIZE];
+    double closestT[MAX_SIZE];
+    m_bvh.CastPacket(packet, closestObjects, closestT);
+
+    // Compute the point, normal and color of each hit from the object that was found
+    Vector3<double> intPoints[MAX_SIZE];
+    Vector3<double> localNormals[MAX_SIZE];
+    int hitLanes[MAX_SIZE];
+    int numHits = 0;
+    for (int lane = 0; lane < numPixels; ++lane)
+    {
+        colors[lane] = Vector3<double>();
+        if (closestObjects[lane] == RT::BVH::NO_OBJECT)
+            continue;
+
+        // The packet kernels agree with TestIntersection, but fall back to a single ray if they ever do not
+        Vector3<double> localColor;
+        if (m_bvh.GetObjects().TestIntersection(closestObjects[lane], cameraRays[lane], intPoints[numHits], localNormals[numHits], localColor))
+            hitLanes[numHits++] = lane;
+        else
+            colors[lane] = RenderPixel(xs[lane], y, xFact, yFact);
+    }
+
+    int64_t intersectedTime = 0;
+    if (pCounters != nullptr)
+    {
+        intersectedTime = RT::RenderCounters::Now();
+        pCounters -> m_intersectionNs += intersectedTime - startTime;
+    }
+
+    // Trace the shadow rays from all of the hits to each light as packets, writing the samples
+    // into scratch storage belonging to the thread, with one sample per light for each hit
+    static thread_local std::vector<RT::LightSample> lightSamples;
+    int numLights = static_cast<int>(m_lightList.size());
+    lightSamples.resize(static_cast<size_t>(numHits) * numLights);
+    for (int i = 0; (i < numLights) && (numHits > 0); ++i)
+        m_lightList[i] -> ComputeSamples(intPoints, numHits, m_bvh, &lightSamples[i], numLights);
+
+    for (int hit = 0; hit < numHits; ++hit)
+    {
+        int lane = hitLanes[hit];
+        const RT::LightSample *pSamples = lightSamples.data() + static_cast<size_t>(hit) * numLights;
+        colors[lane] = ShadeHit(closestObjects[lane], intPoints[hit], localNormals[hit], cameraRays[lane], pSamples);
+    }
+
+    if (pCounters != nullptr)
+        pCounters -> m_shadingNs += RT::RenderCounters::Now() - intersectedTime;
+}
+
+// Function to compute the color at the closest hit of a camera ray
+Vector3<double> RT::Scene::ShadeHit
+(
+    RT::BVH::ObjectHandle closestObject,
+    const Vector3<double> &intPoint, const Vector3<double> &localNormal,
+    const RT::Ray &cameraRay, const RT::LightSample *pLightSamples
+) {
+    // Check if the object has a material
+    RT::MaterialBase *pMaterial = m_bvh.GetObjects().GetMaterial(closestObject);
+    if (pMaterial != nullptr)
+    {
+        // Use the material to compute the color, starting a new ray path at the camera
+        RT::ShadingContext cameraContext;
+        cameraContext.m_maxDepth = m_maxReflectionDepth;
+        cameraContext.m_pLightSamples = pLightSamples;
+        return pMaterial -> ComputeColor
+        (
+            m_bvh, m_lightList,
+            closestObject, intPoint,
+            localNormal, cameraRay, cameraContext
+        );
+    }
+
+    // Use the basic method to compute the color.
+    RT::LightSampleCache lightSamples (m_bvh, m_lightList, intPoint, pLightSamples);
+    return RT::MaterialBase::ComputeDiffuseColor(lightSamples, localNormal, m_bvh.GetObjects().GetBaseColor(closestObject));
+}
+
+// Function to cast a ray into the scene
+bool RT::Scene::CastRay
+(
+    RT::Ray &castRay, RT::BVH::ObjectHandle &closestObject,
+    Vector3<double> &closestIntPoint, Vector3<double> &closestLocalNormal,
+    Vector3<double> &closestLocalColor
+) {
+    UpdateBVH();
+    return m_bvh.CastRay(castRay, RT::BVH::NO_OBJECT, closestObject, closestIntPoint, closestLocalNormal, closestLocalColor);
+}
+
+// Function to test whether anything blocks a ray
+bool RT::Scene::Occluded(const RT::Ray &castRay, double tMax)
+{
+    UpdateBVH();
+    return m_bvh.Occluded(castRay, RT::BVH::NO_OBJECT, tMax);
 }
\ No newline at end of file
@@ -1,13 +1,21 @@
 #ifndef SCENE_H
 #define SCENE_H
 
+#include <functional>
 #include <memory>
 #include <vector>
 #include <SDL2/SDL.h>
 #include "Image.hpp"
 #include "camera.hpp"
+#include "threadpool.hpp"
+#include "canceltoken.hpp"
+#include "tilequeue.hpp"
+#include "bvh.hpp"
+#include "wavefrontrenderer.hpp"
+#include "renderstats.hpp"
 #include "./Primatives/objsphere.hpp"
 #include "./Primatives/objplane.hpp"
+#include "./Primatives/objmesh.hpp"
 #include "./Lights/pointlight.hpp"
 #include "./Materials/simplematerial.hpp"
 
@@ -19,32 +27,198 @@ namespace RT
             // The defauls constructor
             Scene();
 
-            // Function to perform 
+            // Function to perform the rendering
             bool Render(Image &outputImage);
 
-            // Function to cast a ray into the scene
+            /*
+                Functions for progressive rendering. StartProgressive begins a new render of
+                the scene. Each call to RenderProgressive then refines the image for roughly
+                timeBudgetMs, starting from a coarse image with one sample per 16 x 16 block
+                and halving the block size with each pass, until every pixel has been rendered.
+                The finished image is identical to the one produced by Render. Returns true
+                once the image is complete
+            */
+            void StartProgressive(const Image &outputImage);
+            bool RenderProgressive(Image &outputImage, double timeBudgetMs);
+            bool IsProgressiveComplete() const;
+
+            /*
+                As above, but stops early if pCancel is cancelled and calls onTileDone from the
+                render thread that finished each tile of each pass. After a cancellation the
+                image is incomplete and StartProgressive must be called again
+            */
+            using TileCallback = std::function<void(const RT::TileRect &tile)>;
+            bool RenderProgressive
+            (
+                Image &outputImage, double timeBudgetMs,
+                const RT::CancelToken *pCancel, const TileCallback &onTileDone
+            );
+
+            // Function to move the camera by an offset, keeping it pointed at the same place
+            void MoveCamera(const Vector3<double> &offset);
+
+            /*
+                Functions to build a scene from code, in place of the one made by the constructor.
+                AddObject copies the object into the scene's ObjectStore, so later changes to the
+                object have no effect on the scene, and returns false if the store cannot hold it
+                (see ObjectStore::Add). The acceleration structure is rebuilt on the next render.
+                UpdateCameraGeometry must be called on the camera after changing it
+            */
+            void ClearScene();
+            bool AddObject(const RT::ObjectBase &object);
+            void AddLight(const std::shared_ptr<RT::LightBase> &light);
+            RT::Camera &GetCamera();
+
+            // Functions to return the contents of the scene. The handles of the objects change whenever the BVH is rebuilt
+            const RT::ObjectStore &GetObjects() const;
+            const std::vector<std::shared_ptr<RT::LightBase>> &GetLightList() const;
+
+            // Function to return the acceleration structure, rebuilt first if the objects have changed
+            const RT::BVH &GetBVH();
+
+            /*
+                Function to return the number of bytes used by the objects and the acceleration
+                structure, rebuilt first if the objects have changed. Materials and mesh geometry,
+                which objects can share, are not included, and nor is the overhead of the heap
+                allocations themselves
+            */
+            size_t GetObjectMemorySize();
+
+            // Function to replace the objects with those of a tree built elsewhere (see BVH::Restore).
+            // If the tree does not match its objects it is rebuilt on the next render
+            void SetBVH(RT::BVH &&bvh);
+
+            // The block size of the first progressive pass, and the size of the progressive tiles.
+            // The tile size must be a multiple of the initial step, so that the blocks of every
+            // pass lie inside a single tile
+            static constexpr int PROGRESSIVE_INITIAL_STEP = 16;
+            static constexpr int PROGRESSIVE_TILE_SIZE = 32;
+
+            // Functions to configure the parallel renderer
+            void SetThreadCount (int numThreads);
+            void SetTileSize    (int tileSize);
+            int  GetThreadCount () const;
+            int  GetTileSize    () const;
+
+            // Functions to set and return the maximum number of reflections along each ray path
+            void SetMaxReflectionDepth(int maxDepth);
+            int  GetMaxReflectionDepth() const;
+
+            // Functions to choose whether Render traces the rays of each tile in waves (see
+            // WavefrontRenderer) rather than following each ray path recursively. The image
+            // is the same either way. Progressive rendering always follows the paths recursively
+            void SetWavefront(bool wavefront);
+            bool GetWavefront() const;
+
+            /*
+                Functions to collect statistics. When enabled, each render thread counts the rays it
+                traces and the time it spends, and the counts are added up at the end of every call to
+                Render (for that frame) or RenderProgressive (for the frame since StartProgressive).
+                GetStats must not be called while a render is in progress
+            */
+            void SetStatsEnabled(bool enabled);
+            bool GetStatsEnabled() const;
+            const RT::RenderStats &GetStats() const;
+
+            // Function to cast a ray into the scene, returning the handle of the closest object in
+            // GetObjects. Like Render, this rebuilds the BVH first if objects have been added or removed
             bool CastRay
             (
-                RT::Ray &castRay, std::shared_ptr<RT::ObjectBase> &closestObject,
-                Vector<double> &closestIntPoint, Vector<double> &closestLocalNormal,
-                Vector<double> &closestLocalColor
+                RT::Ray &castRay, RT::BVH::ObjectHandle &closestObject,
+                Vector3<double> &closestIntPoint, Vector3<double> &closestLocalNormal,
+                Vector3<double> &closestLocalColor
             );
+
+            // Function to test whether anything in the scene blocks a ray before the ray parameter tMax,
+            // rebuilding the BVH first if it is out of date
+            bool Occluded(const RT::Ray &castRay, double tMax);
         
         // Private functions
         private:
-            
+            // Function to rebuild the BVH if objects have been added or removed
+            void UpdateBVH();
+
+            // Function to create the worker threads and give each a buffer for tiles of up to tileSize
+            void PrepareWorkers(int tileSize);
+
+            // Functions to manage the per-thread counters
+            void PrepareStats();
+            RT::RenderCounters *GetThreadCounters(int threadIndex);
+            void CollectStats(double frameMs);
+
+            // Function to render one rectangular tile of the image, using tileBuffer as scratch space
+            void RenderTile(Image &outputImage, float *tileBuffer, int x0, int y0, int x1, int y1);
+
+            // As above, tracing the rays of the tile in waves
+            void RenderTileWavefront(Image &outputImage, RT::WavefrontRenderer &renderer, float *tileBuffer, int x0, int y0, int x1, int y1);
+
+            // Function to render one tile of a progressive pass with the given block size.
+            // Returns false, without writing the tile, if the render is cancelled
+            bool RenderProgressiveTile
+            (
+                Image &outputImage, float *tileBuffer, int step, int x0, int y0, int x1, int y1,
+                const RT::CancelToken *pCancel
+            );
+
+            // Function to compute the color of a single pixel
+            Vector3<double> RenderPixel(int x, int y, double xFact, double yFact);
+
+            /*
+                Function to compute the colors of up to RayPacket::MAX_SIZE pixels in row y. The
+                camera rays, and the shadow rays from where they hit, are traced as packets. The
+                colors are identical to those from RenderPixel
+            */
+            void RenderPixels(const int *xs, int numPixels, int y, double xFact, double yFact, Vector3<double> *colors);
+
+            // Function to compute the color at the closest hit of a camera ray. pLightSamples holds
+            // the samples for the point if they have already been computed, or is null
+            Vector3<double> ShadeHit
+            (
+                RT::BVH::ObjectHandle closestObject,
+                const Vector3<double> &intPoint, const Vector3<double> &localNormal,
+                const RT::Ray &cameraRay, const RT::LightSample *pLightSamples
+            );
 
         // Private members
         private:
             // The camera that we will use
             RT::Camera m_camera;
 
-            // List of objects on the scene
-            std::vector<std::shared_ptr<RT::ObjectBase>> m_objectList;
-
             // List of lights on the scene
             std::vector<std::shared_ptr<RT::LightBase>> m_lightList;
-            
+
+            // Acceleration structure, which holds the objects of the scene and is used for all ray queries
+            RT::BVH m_bvh;
+
+            // Parallel rendering configuration
+            int m_numThreads = RT::ThreadPool::DefaultThreadCount();
+            int m_tileSize = 32;
+
+            // The maximum number of reflections followed along each ray path
+            int m_maxReflectionDepth = 3;
+
+            // The worker threads, created on first use
+            std::unique_ptr<RT::ThreadPool> m_pThreadPool;
+
+            // One tile-sized pixel buffer per worker thread
+            std::vector<std::vector<float>> m_tileBuffers;
+
+            // Whether Render uses the wavefront renderers, and one per worker thread
+            bool m_wavefront = false;
+            std::vector<std::unique_ptr<RT::WavefrontRenderer>> m_wavefrontRenderers;
+
+            // Statistics, with one set of counters per worker thread
+            bool m_statsEnabled = false;
+            std::vector<RT::RenderCounters> m_threadCounters;
+            RT::RenderStats m_stats;
+
+            // Progressive rendering state
+            int m_progressiveStep = 0;
+            int m_progressiveNextTile = 0;
+            int m_progressiveXSize = 0;
+            int m_progressiveYSize = 0;
+            double m_progressiveMs = 0.0;
+
     };
 }
 
@@ -0,0 +1,369 @@
+#include "sceneloader.hpp"
+#include "objloader.hpp"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+// The words of one line, read in place
+class RT::SceneLoader::LineReader
+{
+    public:
+        LineReader(const char *begin, const char *end)
+            : m_pos(begin), m_end(end)
+        {
+
+        }
+
+        // Function to return the next word, or an empty word at the end of the line
+        std::string_view NextWord()
+        {
+            while ((m_pos < m_end) && IsSpace(*m_pos))
+                ++m_pos;
+
+            const char *wordStart = m_pos;
+            while ((m_pos < m_end) && !IsSpace(*m_pos))
+                ++m_pos;
+
+            return std::string_view(wordStart, m_pos - wordStart);
+        }
+
+        // Function to read the next word as a number
+        bool NextNumber(double &value)
+        {
+            std::string_view word = NextWord();
+            const char *wordEnd = word.data() + word.size();
+            auto result = std::from_chars(word.data(), wordEnd, value);
+            return !word.empty() && (result.ec == std::errc()) && (result.ptr == wordEnd);
+        }
+
+        // Function to read the next three words as a vector
+        bool NextVector(Vector3<double> &value)
+        {
+            return NextNumber(value.m_x) && NextNumber(value.m_y) && NextNumber(value.m_z);
+        }
+
+    private:
+        static bool IsSpace(char c)
+        {
+            return (c == ' ') || (c == '\t') || (c == '\r');
+        }
+
+    private:
+        const char *m_pos;
+        const char *m_end;
+};
+
+// The default constructor
+RT::SceneLoader::SceneLoader()
+{
+
+}
+
+// Function to load a scene file
+bool RT::SceneLoader::LoadFile(const std::string &fileName, RT::Scene &scene)
+{
+    *this = RT::SceneLoader();
+    m_fileName = fileName;
+
+    FILE *file = std::fopen(fileName.c_str(), "rb");
+    if (file == nullptr)
+    {
+        m_error = fileName + ": could not open the file";
+        return false;
+    }
+
+    /*
+        Read the file a block at a time and parse the complete lines in the block. The
+        partial line at the end of the block is moved to the front before the next read,
+        and the buffer only grows if a single line does not fit in it
+    */
+    std::vector<char> buffer(BLOCK_SIZE);
+    size_t numBuffered = 0;
+    bool ok = true;
+    while (ok)
+    {
+        if (numBuffered == buffer.size())
+            buffer.resize(buffer.size() * 2);
+
+        size_t numRead = std::fread(buffer.data() + numBuffered, 1, buffer.size() - numBuffered, file);
+        numBuffered += numRead;
+        if ((numRead == 0) && std::ferror(file))
+        {
+            m_error = fileName + ": could not read the file";
+            ok = false;
+            break;
+        }
+
+        const char *pos = buffer.data();
+        const char *end = pos + numBuffered;
+        const char *newline;
+        while (ok && ((newline = static_cast<const char *>(std::memchr(pos, '\n', end - pos))) != nullptr))
+        {
+            ++m_lineNumber;
+            ok = ParseLine(pos, newline);
+            pos = newline + 1;
+        }
+
+        // The last line does not need to end with a newline
+        if (numRead == 0)
+        {
+            if (ok && (pos < end))
+            {
+                ++m_lineNumber;
+                ok = ParseLine(pos, end);
+            }
+            break;
+        }
+
+        numBuffered = end - pos;
+        std::memmove(buffer.data(), pos, numBuffered);
+    }
+
+    std::fclose(file);
+    if (!ok)
+        return false;
+
+    // Everything loaded, so replace the contents of the scene
+    RT::Camera &camera = scene.GetCamera();
+    if (m_hasPosition)
+        camera.SetPosition(m_cameraPosition);
+    if (m_hasLookAt)
+        camera.SetLookAt(m_cameraLookAt);
+    if (m_hasUp)
+        camera.SetUp(m_cameraUp);
+    if (m_hasHorzSize)
+        camera.SetHorzSize(m_cameraHorzSize);
+    if (m_hasAspect)
+        camera.SetAspect(m_cameraAspect);
+    if (m_hasLength)
+        camera.SetLength(m_cameraLength);
+    camera.UpdateCameraGeometry();
+
+    scene.ClearScene();
+    for (auto &object : m_objects)
+        scene.AddObject(*object);
+    for (auto &light : m_lights)
+        scene.AddLight(light);
+
+    m_numObjects = static_cast<int>(m_objects.size());
+    m_numLights = static_cast<int>(m_lights.size());
+    m_objects.clear();
+    m_lights.clear();
+    m_materials.clear();
+    m_meshes.clear();
+    return true;
+}
+
+// Function to return the last error
+const std::string &RT::SceneLoader::GetError() const
+{
+    return m_error;
+}
+
+// Functions to return the numbers of objects and lights
+int RT::SceneLoader::GetNumObjects() const
+{
+    return m_numObjects;
+}
+
+int RT::SceneLoader::GetNumLights() const
+{
+    return m_numLights;
+}
+
+// Function to parse one line
+bool RT::SceneLoader::ParseLine(const char *begin, const char *end)
+{
+    // Drop the comment, if there is one
+    const char *comment = static_cast<const char *>(std::memchr(begin, '#', end - begin));
+    if (comment != nullptr)
+        end = comment;
+
+    LineReader reader (begin, end);
+    std::string_view keyword = reader.NextWord();
+    if (keyword.empty())
+        return true;
+
+    if ((keyword == "sphere") || (keyword == "plane") || (keyword == "mesh"))
+        return ParseObject(reader, keyword);
+    if (keyword == "material")
+        return ParseMaterial(reader);
+    if (keyword == "pointlight")
+        return ParsePointLight(reader);
+    if (keyword == "camera")
+        return ParseCamera(reader);
+
+    return Fail("unknown keyword '" + std::string(keyword) + "'");
+}
+
+// Function to parse the camera settings
+bool RT::SceneLoader::ParseCamera(LineReader &reader)
+{
+    for (std::string_view property = reader.NextWord(); !property.empty(); property = reader.NextWord())
+    {
+        bool valid;
+        if (property == "position")
+            valid = m_hasPosition = reader.NextVector(m_cameraPosition);
+        else if (property == "lookat")
+            valid = m_hasLookAt = reader.NextVector(m_cameraLookAt);
+        else if (property == "up")
+            valid = m_hasUp = reader.NextVector(m_cameraUp);
+        else if (property == "horzsize")
+            valid = m_hasHorzSize = reader.NextNumber(m_cameraHorzSize);
+        else if (property == "aspect")
+            valid = m_hasAspect = reader.NextNumber(m_cameraAspect);
+        else if (property == "length")
+            valid = m_hasLength = reader.NextNumber(m_cameraLength);
+        else
+            return Fail("unknown camera property '" + std::string(property) + "'");
+
+        if (!valid)
+            return Fail("invalid value for camera property '" + std::string(property) + "'");
+    }
+
+    return true;
+}
+
+// Function to parse a material
+bool RT::SceneLoader::ParseMaterial(LineReader &reader)
+{
+    std::string_view name = reader.NextWord();
+    if (name.empty())
+        return Fail("missing material name");
+
+    auto material = std::make_shared<RT::SimpleMaterial> ();
+    for (std::string_view property = reader.NextWord(); !property.empty(); property = reader.NextWord())
+    {
+        bool valid;
+        if (property == "color")
+            valid = reader.NextVector(material -> m_baseColor);
+        else if (property == "reflectivity")
+            valid = reader.NextNumber(material -> m_reflectivity);
+        else if (property == "shininess")
+            valid = reader.NextNumber(material -> m_shininess);
+        else
+            return Fail("unknown material property '" + std::string(property) + "'");
+
+        if (!valid)
+            return Fail("invalid value for material property '" + std::string(property) + "'");
+    }
+
+    if (!m_materials.emplace(std::string(name), material).second)
+        return Fail("material '" + std::string(name) + "' is already defined");
+
+    return true;
+}
+
+// Function to parse a sphere, plane or mesh
+bool RT::SceneLoader::ParseObject(LineReader &reader, std::string_view type)
+{
+    std::shared_ptr<RT::ObjectBase> object;
+    std::shared_ptr<RT::ObjMesh> mesh;
+    if (type == "sphere")
+        object = std::make_shared<RT::ObjSphere> ();
+    else if (type == "plane")
+        object = std::make_shared<RT::ObjPlane> ();
+    else
+        object = mesh = std::make_shared<RT::ObjMesh> ();
+
+    Vector3<double> translation {0.0, 0.0, 0.0};
+    Vector3<double> rotation {0.0, 0.0, 0.0};
+    Vector3<double> scale {1.0, 1.0, 1.0};
+    for (std::string_view property = reader.NextWord(); !property.empty(); property = reader.NextWord())
+    {
+        bool valid;
+        if (property == "translate")
+            valid = reader.NextVector(translation);
+        else if (property == "rotate")
+            valid = reader.NextVector(rotation);
+        else if (property == "scale")
+            valid = reader.NextVector(scale);
+        else if (property == "color")
+            valid = reader.NextVector(object -> m_baseColor);
+        else if (property == "material")
+        {
+            std::string_view name = reader.NextWord();
+            auto material = m_materials.find(std::string(name));
+            if (material == m_materials.end())
+                return Fail("unknown material '" + std::string(name) + "'");
+
+            valid = object -> AssignMaterial(material -> second);
+        }
+        else if ((property == "file") && mesh)
+        {
+            // The OBJ file is relative to the scene file
+            std::string meshFileName (reader.NextWord());
+            size_t separator = m_fileName.find_last_of("/\\");
+            bool isRelative = !meshFileName.empty() && (meshFileName[0] != '/') && (meshFileName[0] != '\\') && (meshFileName.find(':') == std::string::npos);
+            if (isRelative && (separator != std::string::npos))
+                meshFileName = m_fileName.substr(0, separator + 1) + meshFileName;
+
+            valid = !meshFileName.empty();
+            if (valid)
+            {
+                // Every mesh that names the same file is an instance of one shared geometry
+                auto geometry = m_meshes.find(meshFileName);
+                if (geometry == m_meshes.end())
+                {
+                    auto pGeometry = std::make_shared<RT::MeshGeometry> ();
+                    RT::ObjLoader objLoader;
+                    if (!objLoader.Load(meshFileName, *pGeometry))
+                        return Fail("could not load the mesh, " + objLoader.GetError());
+
+                    geometry = m_meshes.emplace(meshFileName, std::move(pGeometry)).first;
+                }
+
+                mesh -> SetGeometry(geometry -> second);
+            }
+        }
+        else
+        {
+            return Fail("unknown " + std::string(type) + " property '" + std::string(property) + "'");
+        }
+
+        if (!valid)
+            return Fail("invalid value for " + std::string(type) + " property '" + std::string(property) + "'");
+    }
+
+    if (mesh && (mesh -> GetNumTriangles() == 0))
+        return Fail("a mesh needs a file");
+
+    RT::GTform transform;
+    if (!transform.SetTransform(translation, rotation, scale))
+        return Fail("the transform cannot be inverted (is a scale zero?)");
+
+    object -> SetTransformMatrix(transform);
+    m_objects.push_back(std::move(object));
+    return true;
+}
+
+// Function to parse a point light
+bool RT::SceneLoader::ParsePointLight(LineReader &reader)
+{
+    auto light = std::make_shared<RT::PointLight> ();
+    for (std::string_view property = reader.NextWord(); !property.empty(); property = reader.NextWord())
+    {
+        bool valid;
+        if (property == "position")
+            valid = reader.NextVector(light -> m_location);
+        else if (property == "color")
+            valid = reader.NextVector(light -> m_color);
+        else if (property == "intensity")
+            valid = reader.NextNumber(light -> m_intensity);
+        else
+            return Fail("unknown pointlight property '" + std::string(property) + "'");
+
+        if (!valid)
+            return Fail("invalid value for pointlight property '" + std::string(property) + "'");
+    }
+
+    m_lights.push_back(std::move(light));
+    return true;
+}
+
+// Function to record an error on the current line
+bool RT::SceneLoader::Fail(const std::string &message)
+{
+    m_error = m_fileName + ":" + std::to_string(m_lineNumber) + ": " + message;
+    return false;
+}
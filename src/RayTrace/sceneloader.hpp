@@ -0,0 +1,104 @@
+#ifndef SCENELOADER_H
+#define SCENELOADER_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "../LinAlg/Vector3.hpp"
+#include "scene.hpp"
+
+namespace RT
+{
+    /*
+        Loads a scene from a text file. Each line describes one thing, as a keyword
+        followed by named properties in any order. Properties that are left out keep
+        their default values, and '#' starts a comment that runs to the end of the line:
+
+            camera position 0 -10 -1 lookat 0 0 0 up 0 0 1 horzsize 0.25 aspect 1.7778 length 1
+            material blue color 0.25 0.5 0.8 reflectivity 0.5 shininess 10
+            sphere material blue color 0.25 0.5 0.8 translate -1.5 0 0 rotate 0 0 0 scale 0.5 0.5 0.75
+            plane color 0.5 0.5 0.5 translate 0 0 0.75 scale 4 4 1
+            mesh file models/teapot.obj material blue translate 0 0 0.5 rotate -1.5708 0 0
+            pointlight position 5 -10 -5 color 0 0 1 intensity 1
+
+        A material is a SimpleMaterial, and has to be defined before the objects that
+        use it. Rotations are in radians, as for GTform::SetTransform. A mesh is loaded
+        from a Wavefront OBJ file by ObjLoader, relative to the scene file. Each file is
+        only loaded once, and every mesh that names it is an instance of the same geometry
+        with its own transform and material.
+
+        The file is read in large blocks and parsed in place, one line at a time, so
+        the memory used does not depend on the size of the file beyond the objects
+        themselves. The scene is only changed if the whole file loads without errors.
+    */
+    class SceneLoader
+    {
+        public:
+            // The default constructor
+            SceneLoader();
+
+            /*
+                Function to load a scene file, replacing the objects and lights of the scene and
+                setting up its camera. Returns false if the file cannot be read or has an error,
+                and GetError then describes it as "file:line: message"
+            */
+            bool LoadFile(const std::string &fileName, RT::Scene &scene);
+
+            // Function to return the description of the last error
+            const std::string &GetError() const;
+
+            // Functions to return the numbers of objects and lights that were last loaded
+            int GetNumObjects() const;
+            int GetNumLights() const;
+
+        private:
+            // The size of the blocks that the file is read in
+            static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+            // The words of one line
+            class LineReader;
+
+            // Function to parse one line. Returns false on an error
+            bool ParseLine(const char *begin, const char *end);
+
+            // Functions to parse each kind of line
+            bool ParseCamera(LineReader &reader);
+            bool ParseMaterial(LineReader &reader);
+            bool ParseObject(LineReader &reader, std::string_view type);
+            bool ParsePointLight(LineReader &reader);
+
+            // Function to record an error on the current line. Always returns false
+            bool Fail(const std::string &message);
+
+        private:
+            std::string m_fileName;
+            int m_lineNumber = 0;
+            std::string m_error;
+
+            // The camera settings given by the file
+            bool m_hasPosition = false;
+            bool m_hasLookAt = false;
+            bool m_hasUp = false;
+            bool m_hasHorzSize = false;
+            bool m_hasAspect = false;
+            bool m_hasLength = false;
+            Vector3<double> m_cameraPosition;
+            Vector3<double> m_cameraLookAt;
+            Vector3<double> m_cameraUp;
+            double m_cameraHorzSize = 0.0;
+            double m_cameraAspect = 0.0;
+            double m_cameraLength = 0.0;
+
+            // The materials and mesh geometry by name, and what has been loaded so far
+            std::unordered_map<std::string, std::shared_ptr<RT::MaterialBase>> m_materials;
+            std::unordered_map<std::string, std::shared_ptr<RT::MeshGeometry>> m_meshes;
+            std::vector<std::shared_ptr<RT::ObjectBase>> m_objects;
+            std::vector<std::shared_ptr<RT::LightBase>> m_lights;
+            int m_numObjects = 0;
+            int m_numLights = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef SHADINGCONTEXT_H
+#define SHADINGCONTEXT_H
+
+namespace RT
+{
+    struct LightSample;
+
+    /*
+        State carried along a single ray path while it is being shaded.
+        A context is passed by value down the recursion, so every path has
+        its own depth and no state is shared between render threads.
+    */
+    struct ShadingContext
+    {
+        // Reflections that would contribute less than this fraction of a pixel's color are not
+        // traced. It is below the precision of an 8-bit display channel
+        static constexpr double MIN_THROUGHPUT = 1.0 / 1024.0;
+
+        // The number of reflections between the camera and the ray being shaded
+        int m_depth = 0;
+
+        // The maximum number of reflections allowed along this path
+        int m_maxDepth = 3;
+
+        // The fraction of the ray's color that reaches the camera (product of reflectivities so far)
+        double m_throughput = 1.0;
+
+        // Light samples already computed for the point being shaded, one per light in the
+        // light list, or null. They do not carry over to reflections
+        const RT::LightSample *m_pLightSamples = nullptr;
+
+        // Function to test whether this ray is still within the reflection limit
+        bool WithinDepthLimit() const
+        {
+            return m_depth <= m_maxDepth;
+        }
+
+        // Function to test whether this ray is within the reflection limit and still contributes
+        // enough to the final color to be worth tracing
+        bool WorthTracing() const
+        {
+            return WithinDepthLimit() && (m_throughput >= MIN_THROUGHPUT);
+        }
+
+        // Function to return the context for a ray reflected off a surface with the given reflectivity
+        ShadingContext Reflected(double reflectivity) const
+        {
+            ShadingContext reflectedContext = *this;
+            reflectedContext.m_depth += 1;
+            reflectedContext.m_throughput *= reflectivity;
+            reflectedContext.m_pLightSamples = nullptr;
+            return reflectedContext;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,161 @@
+#include "threadpool.hpp"
+#include "tracer.hpp"
+
+// The constructor
+RT::ThreadPool::ThreadPool(int numThreads)
+{
+    m_numThreads = (numThreads < 1) ? 1 : numThreads;
+
+    // One work queue per thread, including the calling thread (index 0)
+    for (int i = 0; i < m_numThreads; ++i)
+        m_queues.push_back(std::make_unique<WorkQueue>());
+
+    // Start the helper threads
+    for (int i = 1; i < m_numThreads; ++i)
+        m_workers.emplace_back(&RT::ThreadPool::WorkerLoop, this, i);
+}
+
+// The destructor
+RT::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        m_shutdown = true;
+    }
+    m_startCondition.notify_all();
+
+    for (auto &worker : m_workers)
+        worker.join();
+}
+
+// Function to return the number of threads
+int RT::ThreadPool::GetNumThreads() const
+{
+    return m_numThreads;
+}
+
+// Function to return a sensible default number of threads
+int RT::ThreadPool::DefaultThreadCount()
+{
+    unsigned int numCores = std::thread::hardware_concurrency();
+    return (numCores == 0) ? 1 : static_cast<int>(numCores);
+}
+
+// Function to run a batch of tasks
+void RT::ThreadPool::Run(int numTasks, const Task &task)
+{
+    if (numTasks <= 0)
+        return;
+
+    // With a single thread there is nothing to schedule
+    if (m_numThreads == 1)
+    {
+        for (int i = 0; i < numTasks; ++i)
+            task(i, 0);
+        return;
+    }
+
+    // Deal the tasks out in contiguous blocks so that each thread starts on a coherent region
+    int blockSize = (numTasks + m_numThreads - 1) / m_numThreads;
+    for (int t = 0; t < m_numThreads; ++t)
+    {
+        std::lock_guard<std::mutex> lock(m_queues[t] -> m_mutex);
+        int first = t * blockSize;
+        int last = std::min(numTasks, first + blockSize);
+        for (int i = first; i < last; ++i)
+            m_queues[t] -> m_tasks.push_back(i);
+    }
+
+    // Wake the helper threads
+    {
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        m_pTask = &task;
+        m_tasksRemaining.store(numTasks);
+        m_workersBusy = m_numThreads - 1;
+        ++m_batchId;
+    }
+    m_startCondition.notify_all();
+
+    // The calling thread works as thread 0
+    ProcessTasks(0);
+
+    // Wait for the helpers to finish their last tasks
+    std::unique_lock<std::mutex> lock(m_controlMutex);
+    m_doneCondition.wait(lock, [this] { return m_workersBusy == 0; });
+    m_pTask = nullptr;
+}
+
+// The loop run by each helper thread
+void RT::ThreadPool::WorkerLoop(int threadIndex)
+{
+    RT::Tracer::SetThreadName("render worker " + std::to_string(threadIndex));
+    unsigned long lastBatch = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_controlMutex);
+            m_startCondition.wait(lock, [&] { return m_shutdown || (m_batchId != lastBatch); });
+            if (m_shutdown)
+                return;
+            lastBatch = m_batchId;
+        }
+
+        ProcessTasks(threadIndex);
+
+        {
+            std::lock_guard<std::mutex> lock(m_controlMutex);
+            --m_workersBusy;
+        }
+        m_doneCondition.notify_all();
+    }
+}
+
+// Function to keep taking tasks until the whole batch has been claimed
+void RT::ThreadPool::ProcessTasks(int threadIndex)
+{
+    int taskIndex;
+    while (m_tasksRemaining.load(std::memory_order_acquire) > 0)
+    {
+        if (PopLocal(threadIndex, taskIndex) || Steal(threadIndex, taskIndex))
+        {
+            (*m_pTask)(taskIndex, threadIndex);
+            m_tasksRemaining.fetch_sub(1, std::memory_order_acq_rel);
+        }
+        else
+        {
+            // Everything has been claimed, the remaining tasks are in flight elsewhere
+            break;
+        }
+    }
+}
+
+// Function to take a task from the front of our own deque
+bool RT::ThreadPool::PopLocal(int threadIndex, int &taskIndex)
+{
+    WorkQueue &queue = *m_queues[threadIndex];
+    std::lock_guard<std::mutex> lock(queue.m_mutex);
+    if (queue.m_tasks.empty())
+        return false;
+
+    taskIndex = queue.m_tasks.front();
+    queue.m_tasks.pop_front();
+    return true;
+}
+
+// Function to steal a task from the back of another thread's deque
+bool RT::ThreadPool::Steal(int threadIndex, int &taskIndex)
+{
+    for (int offset = 1; offset < m_numThreads; ++offset)
+    {
+        WorkQueue &victim = *m_queues[(threadIndex + offset) % m_numThreads];
+        std::lock_guard<std::mutex> lock(victim.m_mutex);
+        if (!victim.m_tasks.empty())
+        {
+            taskIndex = victim.m_tasks.back();
+            victim.m_tasks.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,77 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RT
+{
+    /*
+        A pool of persistent worker threads. Work is submitted as a batch of task
+        indices which are dealt out to per-thread deques. Each thread pops work from
+        the front of its own deque and, once that is empty, steals from the back of
+        the other deques, so uneven tasks (e.g. tiles covering a reflective object)
+        do not leave threads idle at the end of a batch.
+    */
+    class ThreadPool
+    {
+        public:
+            // The task callback receives the task index and the index of the thread running it
+            using Task = std::function<void(int taskIndex, int threadIndex)>;
+
+            // The constructor and destructor
+            explicit ThreadPool(int numThreads);
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool &) = delete;
+            ThreadPool &operator= (const ThreadPool &) = delete;
+
+            // Function to return the number of threads (including the calling thread)
+            int GetNumThreads() const;
+
+            // Function to run tasks [0, numTasks) and block until they have all completed
+            void Run(int numTasks, const Task &task);
+
+            // Function to return a sensible default number of threads for this machine
+            static int DefaultThreadCount();
+
+        private:
+            // A deque of task indices owned by one thread
+            struct WorkQueue
+            {
+                std::mutex m_mutex;
+                std::deque<int> m_tasks;
+            };
+
+            void WorkerLoop(int threadIndex);
+            void ProcessTasks(int threadIndex);
+            bool PopLocal(int threadIndex, int &taskIndex);
+            bool Steal(int threadIndex, int &taskIndex);
+
+        private:
+            int m_numThreads;
+            std::vector<std::thread> m_workers;
+            std::vector<std::unique_ptr<WorkQueue>> m_queues;
+
+            // The batch currently being processed
+            const Task *m_pTask = nullptr;
+            std::atomic<int> m_tasksRemaining {0};
+
+            // Synchronisation between the submitting thread and the workers
+            std::mutex m_controlMutex;
+            std::condition_variable m_startCondition;
+            std::condition_variable m_doneCondition;
+            unsigned long m_batchId = 0;
+            int m_workersBusy = 0;
+            bool m_shutdown = false;
+    };
+}
+
+#endif
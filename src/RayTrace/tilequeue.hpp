@@ -0,0 +1,129 @@
+#ifndef TILEQUEUE_H
+#define TILEQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace RT
+{
+    // A rectangle of the image, [m_x0, m_x1) x [m_y0, m_y1)
+    struct TileRect
+    {
+        int m_x0 = 0;
+        int m_y0 = 0;
+        int m_x1 = 0;
+        int m_y1 = 0;
+    };
+
+    /*
+        A bounded lock-free queue that any number of threads can push to and pop from.
+        Each cell carries a sequence number that tells producers and consumers whether
+        the cell is free or full for their current position, so neither side ever takes
+        a lock or allocates once the queue has been created. The capacity is rounded up
+        to a power of two.
+    */
+    template <typename T>
+    class BoundedQueue
+    {
+        public:
+            explicit BoundedQueue(size_t capacity)
+            {
+                size_t size = 2;
+                while (size < capacity)
+                    size *= 2;
+
+                m_cells.reset(new Cell[size]);
+                m_mask = size - 1;
+                for (size_t i = 0; i < size; ++i)
+                    m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+            }
+
+            BoundedQueue(const BoundedQueue &) = delete;
+            BoundedQueue &operator= (const BoundedQueue &) = delete;
+
+            // Function to return the number of items the queue can hold
+            size_t GetCapacity() const
+            {
+                return m_mask + 1;
+            }
+
+            // Function to add an item. Returns false if the queue is full
+            bool TryPush(const T &item)
+            {
+                size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+                while (true)
+                {
+                    Cell &cell = m_cells[pos & m_mask];
+                    size_t sequence = cell.m_sequence.load(std::memory_order_acquire);
+                    std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+                    if (diff == 0)
+                    {
+                        // The cell is free, claim it by moving the enqueue position on
+                        if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            cell.m_data = item;
+                            cell.m_sequence.store(pos + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (diff < 0)
+                    {
+                        // The cell still holds an item from the previous lap
+                        return false;
+                    }
+                    else
+                    {
+                        // Another producer got here first
+                        pos = m_enqueuePos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            // Function to remove the oldest item. Returns false if the queue is empty
+            bool TryPop(T &item)
+            {
+                size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+                while (true)
+                {
+                    Cell &cell = m_cells[pos & m_mask];
+                    size_t sequence = cell.m_sequence.load(std::memory_order_acquire);
+                    std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+                    if (diff == 0)
+                    {
+                        if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            item = cell.m_data;
+                            cell.m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (diff < 0)
+                    {
+                        // Nothing has been pushed to this cell yet
+                        return false;
+                    }
+                    else
+                    {
+                        pos = m_dequeuePos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+        private:
+            struct Cell
+            {
+                std::atomic<size_t> m_sequence;
+                T m_data;
+            };
+
+            std::unique_ptr<Cell[]> m_cells;
+            size_t m_mask = 0;
+
+            // The producer and consumer positions, on separate cache lines
+            alignas(64) std::atomic<size_t> m_enqueuePos {0};
+            alignas(64) std::atomic<size_t> m_dequeuePos {0};
+    };
+}
+
+#endif
@@ -0,0 +1,167 @@
+#include "tracer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char *m_name;
+        const char *m_argName;
+        int64_t m_argValue;
+        int64_t m_startNs;
+        int64_t m_durationNs;
+    };
+
+    // The events of one thread. Only that thread writes to it
+    struct ThreadBuffer
+    {
+        int m_threadId = 0;
+        std::string m_name;
+        std::vector<TraceEvent> m_events;
+
+        // The number of events ever recorded, the latest EVENTS_PER_THREAD of which are kept
+        uint64_t m_numRecorded = 0;
+    };
+
+    // Every thread's buffer. Buffers are never freed, so they can be written out after their thread has ended
+    std::mutex g_buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+
+    // The calling thread's name and buffer, which is created when it records its first event
+    thread_local std::string t_threadName;
+    thread_local ThreadBuffer *t_pBuffer = nullptr;
+
+    ThreadBuffer *GetThreadBuffer()
+    {
+        if (t_pBuffer == nullptr)
+        {
+            auto buffer = std::make_unique<ThreadBuffer>();
+            buffer -> m_name = t_threadName;
+            buffer -> m_events.resize(RT::Tracer::EVENTS_PER_THREAD);
+
+            std::lock_guard<std::mutex> lock(g_buffersMutex);
+            buffer -> m_threadId = static_cast<int>(g_buffers.size()) + 1;
+            if (buffer -> m_name.empty())
+                buffer -> m_name = "thread " + std::to_string(buffer -> m_threadId);
+            t_pBuffer = buffer.get();
+            g_buffers.push_back(std::move(buffer));
+        }
+
+        return t_pBuffer;
+    }
+
+    // Function to write a string to a JSON file, escaping the characters that need it
+    void WriteJsonString(FILE *file, const char *text)
+    {
+        std::fputc('"', file);
+        for (const char *c = text; *c != '\0'; ++c)
+        {
+            if ((*c == '"') || (*c == '\\'))
+                std::fputc('\\', file);
+            if (static_cast<unsigned char>(*c) >= 0x20)
+                std::fputc(*c, file);
+        }
+        std::fputc('"', file);
+    }
+}
+
+// Function to turn tracing on and off
+void RT::Tracer::SetEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+// Function to name the calling thread
+void RT::Tracer::SetThreadName(const std::string &name)
+{
+    t_threadName = name;
+    if (t_pBuffer != nullptr)
+    {
+        std::lock_guard<std::mutex> lock(g_buffersMutex);
+        t_pBuffer -> m_name = name;
+    }
+}
+
+// Function to record an event
+void RT::Tracer::Record(const char *name, int64_t startNs, int64_t endNs, const char *argName, int64_t argValue)
+{
+    ThreadBuffer *pBuffer = GetThreadBuffer();
+    TraceEvent &event = pBuffer -> m_events[pBuffer -> m_numRecorded % EVENTS_PER_THREAD];
+    event.m_name = name;
+    event.m_argName = argName;
+    event.m_argValue = argValue;
+    event.m_startNs = startNs;
+    event.m_durationNs = endNs - startNs;
+    ++pBuffer -> m_numRecorded;
+}
+
+// Function to discard every event
+void RT::Tracer::Clear()
+{
+    std::lock_guard<std::mutex> lock(g_buffersMutex);
+    for (auto &buffer : g_buffers)
+        buffer -> m_numRecorded = 0;
+}
+
+// Function to return the current time
+int64_t RT::Tracer::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Function to write the events as a Chrome trace
+bool RT::Tracer::WriteChromeTrace(const std::string &fileName)
+{
+    FILE *file = std::fopen(fileName.c_str(), "w");
+    if (file == nullptr)
+        return false;
+
+    std::lock_guard<std::mutex> lock(g_buffersMutex);
+
+    // Times are written in microseconds from the earliest event that is kept
+    int64_t originNs = INT64_MAX;
+    for (const auto &buffer : g_buffers)
+    {
+        uint64_t numKept = std::min<uint64_t>(buffer -> m_numRecorded, EVENTS_PER_THREAD);
+        for (uint64_t i = buffer -> m_numRecorded - numKept; i < buffer -> m_numRecorded; ++i)
+            originNs = std::min(originNs, buffer -> m_events[i % EVENTS_PER_THREAD].m_startNs);
+    }
+
+    std::fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    std::fprintf(file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"RayTracer\"}}");
+    for (const auto &buffer : g_buffers)
+    {
+        std::fprintf(file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": ", buffer -> m_threadId);
+        WriteJsonString(file, buffer -> m_name.c_str());
+        std::fprintf(file, "}}");
+
+        uint64_t numKept = std::min<uint64_t>(buffer -> m_numRecorded, EVENTS_PER_THREAD);
+        for (uint64_t i = buffer -> m_numRecorded - numKept; i < buffer -> m_numRecorded; ++i)
+        {
+            const TraceEvent &event = buffer -> m_events[i % EVENTS_PER_THREAD];
+            std::fprintf(file, ",\n{\"name\": ");
+            WriteJsonString(file, event.m_name);
+            std::fprintf
+            (
+                file, ", \"cat\": \"render\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f",
+                buffer -> m_threadId, (event.m_startNs - originNs) / 1000.0, event.m_durationNs / 1000.0
+            );
+            if (event.m_argName != nullptr)
+            {
+                std::fprintf(file, ", \"args\": {");
+                WriteJsonString(file, event.m_argName);
+                std::fprintf(file, ": %" PRId64 "}", event.m_argValue);
+            }
+            std::fprintf(file, "}");
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,80 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace RT
+{
+    /*
+        Opt-in recording of timed events (frames, tiles, passes, display updates) for viewing
+        as a timeline in chrome://tracing or Perfetto. Each thread records into its own ring
+        buffer, so recording never takes a lock once a thread has its buffer, and a long run
+        keeps the most recent Tracer::EVENTS_PER_THREAD events of each thread. While tracing
+        is disabled an event costs one relaxed load.
+
+        Event and argument names must be string literals (or otherwise outlive the tracer),
+        as only the pointers are stored. Clear and WriteChromeTrace read every thread's buffer,
+        so they must only be called while no events are being recorded, eg. between frames.
+    */
+    class Tracer
+    {
+        public:
+            // The number of events kept for each thread
+            static constexpr int EVENTS_PER_THREAD = 1 << 16;
+
+            // Functions to turn tracing on and off
+            static void SetEnabled(bool enabled);
+            static bool IsEnabled()
+            {
+                return s_enabled.load(std::memory_order_relaxed);
+            }
+
+            // Function to name the calling thread in the trace
+            static void SetThreadName(const std::string &name);
+
+            // Function to record an event on the calling thread. argName may be null
+            static void Record(const char *name, int64_t startNs, int64_t endNs, const char *argName, int64_t argValue);
+
+            // Function to discard every recorded event
+            static void Clear();
+
+            // Function to write the recorded events in the Chrome trace event format. Returns false on failure
+            static bool WriteChromeTrace(const std::string &fileName);
+
+            // Function to return the current time, in nanoseconds
+            static int64_t Now();
+
+        private:
+            static inline std::atomic<bool> s_enabled {false};
+    };
+
+    // Records an event covering the lifetime of the object, if tracing is enabled when it is created
+    class TraceScope
+    {
+        public:
+            explicit TraceScope(const char *name, const char *argName = nullptr, int64_t argValue = 0)
+                : m_name(name), m_argName(argName), m_argValue(argValue), m_startNs(RT::Tracer::IsEnabled() ? RT::Tracer::Now() : -1)
+            {
+
+            }
+
+            ~TraceScope()
+            {
+                if (m_startNs >= 0)
+                    RT::Tracer::Record(m_name, m_startNs, RT::Tracer::Now(), m_argName, m_argValue);
+            }
+
+            TraceScope(const TraceScope &) = delete;
+            TraceScope &operator= (const TraceScope &) = delete;
+
+        private:
+            const char *m_name;
+            const char *m_argName;
+            int64_t m_argValue;
+            int64_t m_startNs;
+    };
+}
+
+#endif
@@ -0,0 +1,296 @@
+#include "wavefrontrenderer.hpp"
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include "Image.hpp"
+#include "renderstats.hpp"
+#include "tracer.hpp"
+
+// The constructor
+RT::WavefrontRenderer::WavefrontRenderer()
+{
+
+}
+
+// Functions to manage a queue of rays
+void RT::WavefrontRenderer::RayQueue::Clear()
+{
+    m_originX.clear();
+    m_originY.clear();
+    m_originZ.clear();
+    m_labX.clear();
+    m_labY.clear();
+    m_labZ.clear();
+    m_source.clear();
+    m_excluded.clear();
+    m_throughput.clear();
+}
+
+void RT::WavefrontRenderer::RayQueue::Push(const RT::Ray &ray, int source, RT::BVH::ObjectHandle excluded, double throughput)
+{
+    m_originX.push_back(ray.m_point1.m_x);
+    m_originY.push_back(ray.m_point1.m_y);
+    m_originZ.push_back(ray.m_point1.m_z);
+    m_labX.push_back(ray.m_lab.m_x);
+    m_labY.push_back(ray.m_lab.m_y);
+    m_labZ.push_back(ray.m_lab.m_z);
+    m_source.push_back(source);
+    m_excluded.push_back(excluded);
+    m_throughput.push_back(throughput);
+}
+
+int RT::WavefrontRenderer::RayQueue::GetSize() const
+{
+    return static_cast<int>(m_source.size());
+}
+
+RT::Ray RT::WavefrontRenderer::RayQueue::GetRay(int index) const
+{
+    RT::Ray ray;
+    ray.m_point1 = Vector3<double>{m_originX[index], m_originY[index], m_originZ[index]};
+    ray.m_lab = Vector3<double>{m_labX[index], m_labY[index], m_labZ[index]};
+    ray.m_point2 = ray.m_point1 + ray.m_lab;
+    return ray;
+}
+
+// Function to render a batch of pixels
+void RT::WavefrontRenderer::RenderPixels
+(
+    RT::Camera &camera, const RT::BVH &sceneBVH,
+    const std::vector<std::shared_ptr<RT::LightBase>> &lightList, int maxDepth,
+    const int *xs, const int *ys, int numPixels, double xFact, double yFact,
+    Vector3<double> *colors
+) {
+    m_vertices.clear();
+    m_pixelVertices.assign(numPixels, -1);
+
+    // Generate the camera rays, exactly as Scene::RenderPixel does
+    m_rays.Clear();
+    for (int pixel = 0; pixel < numPixels; ++pixel)
+    {
+        double normX = (static_cast<double>(xs[pixel]) * xFact) - 1.0;
+        double normY = (static_cast<double>(ys[pixel]) * yFact) - 1.0;
+        RT::Ray cameraRay;
+        camera.GenerateRay(normX, normY, cameraRay);
+        m_rays.Push(cameraRay, pixel, RT::BVH::NO_OBJECT, 1.0);
+    }
+
+    // Trace one wave of rays per reflection, until every path has ended. As in the recursive
+    // renderer, the time to intersect the camera rays is intersection and the rest is shading
+    RT::RenderCounters *pCounters = RT::RenderCounters::GetCurrent();
+    int64_t startTime = (pCounters != nullptr) ? RT::RenderCounters::Now() : 0;
+    for (int depth = 0; m_rays.GetSize() > 0; ++depth)
+    {
+        {
+            RT::TraceScope intersectScope("intersect", "depth", depth);
+            Intersect(sceneBVH);
+        }
+
+        if (pCounters != nullptr)
+        {
+            if (depth == 0)
+            {
+                int64_t intersectedTime = RT::RenderCounters::Now();
+                pCounters -> m_primaryRays += m_rays.GetSize();
+                pCounters -> m_intersectionNs += intersectedTime - startTime;
+                startTime = intersectedTime;
+            }
+            else
+            {
+                pCounters -> CountReflectionRays(depth, m_rays.GetSize());
+            }
+        }
+
+        // Trace the shadow rays from all of the hits to each light
+        int numHits = static_cast<int>(m_hitRays.size());
+        {
+            RT::TraceScope shadowScope("shadow", "depth", depth);
+            int numLights = static_cast<int>(lightList.size());
+            m_lightSamples.resize(static_cast<size_t>(numHits) * numLights);
+            for (int i = 0; (i < numLights) && (numHits > 0); ++i)
+                lightList[i] -> ComputeSamples(m_hitPoints.data(), numHits, sceneBVH, &m_lightSamples[i], numLights);
+        }
+
+        m_nextRays.Clear();
+        {
+            RT::TraceScope shadeScope("shade", "depth", depth);
+            Shade(sceneBVH, lightList, depth, maxDepth);
+        }
+        std::swap(m_rays, m_nextRays);
+    }
+
+    // Resolve the colors, deepest vertices first. A reflection is always added after the vertex it leaves from
+    RT::TraceScope resolveScope("resolve");
+    for (int vertexIndex = static_cast<int>(m_vertices.size()) - 1; vertexIndex >= 0; --vertexIndex)
+    {
+        PathVertex &vertex = m_vertices[vertexIndex];
+        if (vertex.m_pMaterial == nullptr)
+            continue;
+
+        Vector3<double> reflectionColor;
+        if (vertex.m_reflection >= 0)
+            reflectionColor = m_vertices[vertex.m_reflection].m_color;
+
+        vertex.m_color = vertex.m_pMaterial -> CombineShading(vertex.m_shading, reflectionColor);
+    }
+
+    for (int pixel = 0; pixel < numPixels; ++pixel)
+    {
+        int vertexIndex = m_pixelVertices[pixel];
+        colors[pixel] = (vertexIndex >= 0) ? m_vertices[vertexIndex].m_color : Vector3<double>();
+    }
+
+    if (pCounters != nullptr)
+        pCounters -> m_shadingNs += RT::RenderCounters::Now() - startTime;
+}
+
+// Function to render a tile
+void RT::WavefrontRenderer::RenderTile
+(
+    RT::Camera &camera, const RT::BVH &sceneBVH,
+    const std::vector<std::shared_ptr<RT::LightBase>> &lightList, int maxDepth,
+    int x0, int y0, int x1, int y1, double xFact, double yFact, float *tileBuffer
+) {
+    m_tileXs.clear();
+    m_tileYs.clear();
+    for (int y = y0; y < y1; ++y)
+    {
+        for (int x = x0; x < x1; ++x)
+        {
+            m_tileXs.push_back(x);
+            m_tileYs.push_back(y);
+        }
+    }
+
+    int numPixels = static_cast<int>(m_tileXs.size());
+    m_tileColors.resize(numPixels);
+    RenderPixels(camera, sceneBVH, lightList, maxDepth, m_tileXs.data(), m_tileYs.data(), numPixels, xFact, yFact, m_tileColors.data());
+
+    float *pixel = tileBuffer;
+    for (const auto &color : m_tileColors)
+    {
+        pixel[0] = static_cast<float>(color.m_x);
+        pixel[1] = static_cast<float>(color.m_y);
+        pixel[2] = static_cast<float>(color.m_z);
+        pixel += Image::NUM_CHANNELS;
+    }
+}
+
+// Function to find the closest hit of every ray in the wave
+void RT::WavefrontRenderer::Intersect(const RT::BVH &sceneBVH)
+{
+    constexpr int MAX_SIZE = RT::RayPacket::MAX_SIZE;
+    m_hitRays.clear();
+    m_hitObjects.clear();
+    m_hitPoints.clear();
+    m_hitNormals.clear();
+
+    int numRays = m_rays.GetSize();
+    for (int first = 0; first < numRays; first += MAX_SIZE)
+    {
+        RT::RayPacket packet;
+        packet.m_size = std::min(MAX_SIZE, numRays - first);
+        for (int lane = 0; lane < packet.m_size; ++lane)
+        {
+            packet.m_originX[lane] = m_rays.m_originX[first + lane];
+            packet.m_originY[lane] = m_rays.m_originY[first + lane];
+            packet.m_originZ[lane] = m_rays.m_originZ[first + lane];
+            packet.m_labX[lane] = m_rays.m_labX[first + lane];
+            packet.m_labY[lane] = m_rays.m_labY[first + lane];
+            packet.m_labZ[lane] = m_rays.m_labZ[first + lane];
+            packet.m_tMin[lane] = 0.0;
+            packet.m_tMax[lane] = std::numeric_limits<double>::infinity();
+        }
+        packet.Finalize();
+
+        RT::BVH::ObjectHandle closestObjects[MAX_SIZE];
+        double closestT[MAX_SIZE];
+        sceneBVH.CastPacket(packet, closestObjects, closestT, &m_rays.m_excluded[first]);
+
+        for (int lane = 0; lane < packet.m_size; ++lane)
+        {
+            if (closestObjects[lane] == RT::BVH::NO_OBJECT)
+                continue;
+
+            // Compute the point and normal of the hit from the object that was found
+            int rayIndex = first + lane;
+            RT::Ray ray = m_rays.GetRay(rayIndex);
+            RT::BVH::ObjectHandle object = closestObjects[lane];
+            Vector3<double> intPoint;
+            Vector3<double> localNormal;
+            Vector3<double> localColor;
+            if (!sceneBVH.GetObjects().TestIntersection(object, ray, intPoint, localNormal, localColor))
+            {
+                // The packet kernels agree with TestIntersection, but fall back to a single ray if they ever do not
+                if (!sceneBVH.CastRay(ray, m_rays.m_excluded[rayIndex], object, intPoint, localNormal, localColor))
+                    continue;
+            }
+
+            m_hitRays.push_back(rayIndex);
+            m_hitObjects.push_back(object);
+            m_hitPoints.push_back(intPoint);
+            m_hitNormals.push_back(localNormal);
+        }
+    }
+}
+
+// Function to shade the hits of the wave and queue their reflections
+void RT::WavefrontRenderer::Shade
+(
+    const RT::BVH &sceneBVH, const std::vector<std::shared_ptr<RT::LightBase>> &lightList,
+    int depth, int maxDepth
+) {
+    int numHits = static_cast<int>(m_hitRays.size());
+    for (int hit = 0; hit < numHits; ++hit)
+    {
+        int rayIndex = m_hitRays[hit];
+        int vertexIndex = static_cast<int>(m_vertices.size());
+        m_vertices.emplace_back();
+
+        // Link the vertex to the pixel or vertex that the ray came from
+        int source = m_rays.m_source[rayIndex];
+        if (depth == 0)
+            m_pixelVertices[source] = vertexIndex;
+        else
+            m_vertices[source].m_reflection = vertexIndex;
+
+        RT::BVH::ObjectHandle object = m_hitObjects[hit];
+        const Vector3<double> &intPoint = m_hitPoints[hit];
+        const Vector3<double> &localNormal = m_hitNormals[hit];
+        const RT::LightSample *pSamples = m_lightSamples.data() + static_cast<size_t>(hit) * lightList.size();
+        RT::LightSampleCache lightSamples (sceneBVH, lightList, intPoint, pSamples);
+        PathVertex &vertex = m_vertices[vertexIndex];
+
+        // Objects without a material only have a diffuse color
+        RT::MaterialBase *pMaterial = sceneBVH.GetObjects().GetMaterial(object);
+        if (pMaterial == nullptr)
+        {
+            vertex.m_color = RT::MaterialBase::ComputeDiffuseColor(lightSamples, localNormal, sceneBVH.GetObjects().GetBaseColor(object));
+            continue;
+        }
+
+        RT::Ray incidentRay = m_rays.GetRay(rayIndex);
+        if (!pMaterial -> ComputeLocalShading(lightSamples, localNormal, incidentRay, vertex.m_shading))
+        {
+            // The material can only be shaded recursively
+            RT::ShadingContext context;
+            context.m_depth = depth;
+            context.m_maxDepth = maxDepth;
+            context.m_throughput = m_rays.m_throughput[rayIndex];
+            context.m_pLightSamples = pSamples;
+            vertex.m_color = pMaterial -> ComputeColor(sceneBVH, lightList, object, intPoint, localNormal, incidentRay, context);
+            continue;
+        }
+
+        vertex.m_pMaterial = pMaterial;
+
+        // Queue the reflection if it is within the depth limit and contributes enough to the pixel
+        double reflectedThroughput = m_rays.m_throughput[rayIndex] * vertex.m_shading.m_reflectivity;
+        if (vertex.m_shading.m_reflects && (depth + 1 <= maxDepth) && (reflectedThroughput >= RT::ShadingContext::MIN_THROUGHPUT))
+        {
+            bool canHitItself = sceneBVH.GetObjects().CanHitItself(object);
+            RT::Ray reflectionRay = RT::MaterialBase::ComputeReflectionRay(incidentRay, intPoint, localNormal, canHitItself);
+            m_nextRays.Push(reflectionRay, vertexIndex, canHitItself ? RT::BVH::NO_OBJECT : object, reflectedThroughput);
+        }
+    }
+}
@@ -0,0 +1,131 @@
+#ifndef WAVEFRONTRENDERER_H
+#define WAVEFRONTRENDERER_H
+
+#include <memory>
+#include <vector>
+#include "../LinAlg/Vector3.hpp"
+#include "camera.hpp"
+#include "bvh.hpp"
+#include "ray.hpp"
+#include "raypacket.hpp"
+#include "./Lights/lightbase.hpp"
+#include "./Lights/lightsample.hpp"
+#include "./Materials/materialbase.hpp"
+
+namespace RT
+{
+    /*
+        Renders a batch of pixels one wave of rays at a time instead of following each
+        ray path recursively. Every ray in a wave has been reflected the same number of
+        times, and each wave goes through separate stages:
+
+            generation   - the camera rays (or the reflections queued by the previous wave)
+            intersection - all rays of the wave are traced as packets
+            shadow       - the shadow rays from all of the hits to each light, as packets
+            shading      - each hit is shaded without its reflection, which is queued for the next wave
+
+        Once no rays are left, the colors are resolved from the deepest hits back towards
+        the camera. The rays are queued as a structure of arrays, so the stages work on
+        long runs of similar work, and the queues are reused from batch to batch. The
+        colors are identical to those of the recursive renderer.
+
+        An instance is not thread safe, so each render thread has its own.
+    */
+    class WavefrontRenderer
+    {
+        public:
+            // The default constructor
+            WavefrontRenderer();
+
+            // Function to compute the colors of the pixels (xs[i], ys[i]), with at most maxDepth reflections
+            // along each path. xFact and yFact map pixel coordinates onto [0, 2], as for Scene::RenderPixel
+            void RenderPixels
+            (
+                RT::Camera &camera, const RT::BVH &sceneBVH,
+                const std::vector<std::shared_ptr<RT::LightBase>> &lightList, int maxDepth,
+                const int *xs, const int *ys, int numPixels, double xFact, double yFact,
+                Vector3<double> *colors
+            );
+
+            // Function to render the pixels [x0, x1) x [y0, y1) into tileBuffer, one row after another
+            void RenderTile
+            (
+                RT::Camera &camera, const RT::BVH &sceneBVH,
+                const std::vector<std::shared_ptr<RT::LightBase>> &lightList, int maxDepth,
+                int x0, int y0, int x1, int y1, double xFact, double yFact, float *tileBuffer
+            );
+
+        private:
+            // The rays of one wave
+            struct RayQueue
+            {
+                std::vector<double> m_originX;
+                std::vector<double> m_originY;
+                std::vector<double> m_originZ;
+                std::vector<double> m_labX;
+                std::vector<double> m_labY;
+                std::vector<double> m_labZ;
+
+                // The pixel a camera ray belongs to, or the path vertex a reflected ray leaves from
+                std::vector<int> m_source;
+
+                // The object each ray must ignore (the one it was reflected off, if that object cannot hit
+                // itself), or BVH::NO_OBJECT
+                std::vector<RT::BVH::ObjectHandle> m_excluded;
+
+                // The fraction of each ray's color that reaches the camera
+                std::vector<double> m_throughput;
+
+                void Clear();
+                void Push(const RT::Ray &ray, int source, RT::BVH::ObjectHandle excluded, double throughput);
+                int GetSize() const;
+                RT::Ray GetRay(int index) const;
+            };
+
+            // A point where a ray path hit an object
+            struct PathVertex
+            {
+                // The material, if the color still has to be combined with the reflection
+                RT::MaterialBase *m_pMaterial = nullptr;
+                RT::LocalShading m_shading;
+
+                // The final color, once it is known
+                Vector3<double> m_color;
+
+                // The vertex hit by the reflected ray, or -1 if it was not traced or hit nothing
+                int m_reflection = -1;
+            };
+
+            void Intersect(const RT::BVH &sceneBVH);
+            void Shade
+            (
+                const RT::BVH &sceneBVH, const std::vector<std::shared_ptr<RT::LightBase>> &lightList,
+                int depth, int maxDepth
+            );
+
+        private:
+            // The wave being traced and the reflections queued for the next one
+            RayQueue m_rays;
+            RayQueue m_nextRays;
+
+            // The hits of the current wave
+            std::vector<int> m_hitRays;
+            std::vector<RT::BVH::ObjectHandle> m_hitObjects;
+            std::vector<Vector3<double>> m_hitPoints;
+            std::vector<Vector3<double>> m_hitNormals;
+
+            // The light samples for each hit, one per light in the scene
+            std::vector<RT::LightSample> m_lightSamples;
+
+            // The path vertices of every wave, and the first vertex of each pixel (or -1)
+            std::vector<PathVertex> m_vertices;
+            std::vector<int> m_pixelVertices;
+
+            // The pixels and colors of the tile being rendered
+            std::vector<int> m_tileXs;
+            std::vector<int> m_tileYs;
+            std::vector<Vector3<double>> m_tileColors;
+    };
+}
+
+#endif
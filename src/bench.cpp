@@ -0,0 +1,671 @@
+/*
+    Benchmark driver for the ray tracer.
+
+    bench [xSize ySize]
+        Renders the built-in scene without opening a window and reports the time
+        per frame and the number of heap allocations made per primary ray.
+
+    bench shadow [numObjects numLights]
+        Casts shadow rays from random points towards a set of lights in a random
+        scene and compares full intersection tests with occlusion-only tests.
+
+    bench suite [options]
+        Renders a set of standard procedural scenes with 1, 2, 4, ... threads and
+        writes the time per frame and rays per second as JSON. The options are
+            --scene default|spheres|planes|mesh|instances   render only this scene (default: all standard cases)
+            --count N       spheres, planes along each side of the grid, mesh triangles or mesh instances
+            --lights N      number of point lights
+            --depth N       maximum reflection depth
+            --width W --height H             image size (default 320 x 180)
+            --frames N      timed frames per thread count, the median is reported (default 3)
+            --max-threads N largest thread count (default: the number of hardware threads)
+            --renderer recursive|wavefront
+            --output file   write the JSON to a file instead of stdout
+        The ray counts, and the rest of the render statistics, come from one more
+        frame rendered with statistics enabled.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "./RayTrace/Image.hpp"
+#include "./RayTrace/scene.hpp"
+#include "./RayTrace/packetkernels.hpp"
+
+// Count every heap allocation made by the program
+static std::atomic<unsigned long long> g_allocationCount {0};
+
+// Function to allocate memory for the operators below, counting the allocation
+static void *CountedAlloc(std::size_t size)
+{
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+/*
+    The replacements pair malloc with free, which is correct, but GCC sees the inlined malloc
+    reach operator delete and reports it as a mismatch, so that warning is turned off here
+*/
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 11)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(std::size_t size)
+{
+    return CountedAlloc(size);
+}
+
+void *operator new[](std::size_t size)
+{
+    return CountedAlloc(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 11)
+    #pragma GCC diagnostic pop
+#endif
+
+// Function to return the time since startTime in milliseconds
+static double ElapsedMs(std::chrono::steady_clock::time_point startTime)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// Shadow ray benchmark
+static int RunShadowBenchmark(int numObjects, int numLights)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> position(-20.0, 20.0);
+    std::uniform_real_distribution<double> size(0.2, 1.0);
+    std::uniform_real_distribution<double> angle(0.0, 3.14159);
+
+    // A random scene of spheres and planes
+    std::vector<std::shared_ptr<RT::ObjectBase>> objectList;
+    for (int i = 0; i < numObjects; ++i)
+    {
+        std::shared_ptr<RT::ObjectBase> object;
+        if (i % 4 == 0)
+            object = std::make_shared<RT::ObjPlane>();
+        else
+            object = std::make_shared<RT::ObjSphere>();
+
+        RT::GTform transform;
+        transform.SetTransform
+        (
+            Vector3<double>{position(rng), position(rng), position(rng)},
+            Vector3<double>{angle(rng), angle(rng), angle(rng)},
+            Vector3<double>{size(rng), size(rng), size(rng)}
+        );
+        object -> SetTransformMatrix(transform);
+        objectList.push_back(object);
+    }
+
+    RT::BVH sceneBVH;
+    for (const auto &object : objectList)
+        sceneBVH.GetObjects().Add(*object);
+    sceneBVH.Build();
+    const RT::ObjectStore &objects = sceneBVH.GetObjects();
+
+    // Shadow rays from random points to each light, with unit length direction, ending at the light
+    std::vector<RT::Ray> shadowRays;
+    std::vector<Vector3<double>> lights;
+    for (int l = 0; l < numLights; ++l)
+        lights.push_back(Vector3<double>{position(rng), position(rng), 30.0});
+
+    for (int p = 0; p < 20000; ++p)
+    {
+        Vector3<double> point {position(rng), position(rng), position(rng)};
+        for (const auto &light : lights)
+        {
+            Vector3<double> toLight = light - point;
+            double distance = toLight.norm();
+            RT::Ray shadowRay (point, point + toLight * (1.0 / distance));
+            shadowRay.m_tMax = distance;
+            shadowRays.push_back(shadowRay);
+        }
+    }
+
+    // Per-primitive cost: full intersection against occlusion test on the same rays and objects
+    int kernelRays = std::min<int>(static_cast<int>(shadowRays.size()), 2000);
+    int kernelHits = 0;
+    Vector3<double> intPoint, localNormal, localColor;
+    auto startTime = std::chrono::steady_clock::now();
+    for (int r = 0; r < kernelRays; ++r)
+        for (RT::ObjectStore::Handle handle = 0; handle < objects.GetSize(); ++handle)
+            kernelHits += objects.TestIntersection(handle, shadowRays[r], intPoint, localNormal, localColor) ? 1 : 0;
+    double fullKernelMs = ElapsedMs(startTime);
+
+    int occludedHits = 0;
+    startTime = std::chrono::steady_clock::now();
+    for (int r = 0; r < kernelRays; ++r)
+        for (RT::ObjectStore::Handle handle = 0; handle < objects.GetSize(); ++handle)
+            occludedHits += objects.Occluded(handle, shadowRays[r], std::numeric_limits<double>::infinity()) ? 1 : 0;
+    double occludedKernelMs = ElapsedMs(startTime);
+
+    // The same tests with the packet kernels, for every SIMD level this CPU supports
+    RT::SimdLevel supportedLevel = RT::PacketKernels::GetSupportedLevel();
+    std::vector<double> packetKernelMs;
+    std::vector<int> packetHits;
+    double tHit[RT::RayPacket::MAX_SIZE];
+    for (int level = 0; level <= static_cast<int>(supportedLevel); ++level)
+    {
+        RT::PacketKernels::SetLevel(static_cast<RT::SimdLevel>(level));
+        int hits = 0;
+        startTime = std::chrono::steady_clock::now();
+        for (int r = 0; r < kernelRays; r += RT::RayPacket::MAX_SIZE)
+        {
+            RT::RayPacket packet;
+            packet.m_size = std::min(RT::RayPacket::MAX_SIZE, kernelRays - r);
+            for (int lane = 0; lane < packet.m_size; ++lane)
+                packet.SetRay(lane, shadowRays[r + lane]);
+            packet.Finalize();
+
+            for (RT::ObjectStore::Handle handle = 0; handle < objects.GetSize(); ++handle)
+            {
+                objects.TestIntersectionPacket(handle, packet, tHit);
+                for (int lane = 0; lane < packet.m_size; ++lane)
+                    hits += (tHit[lane] < std::numeric_limits<double>::infinity()) ? 1 : 0;
+            }
+        }
+        packetKernelMs.push_back(ElapsedMs(startTime));
+        packetHits.push_back(hits);
+    }
+    RT::PacketKernels::SetLevel(supportedLevel);
+
+    // Whole queries: closest hit (full intersection data) against the any-hit occlusion query
+    int blocked = 0;
+    RT::BVH::ObjectHandle closestObject;
+    startTime = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < shadowRays.size(); ++r)
+        blocked += sceneBVH.CastRay(shadowRays[r], RT::BVH::NO_OBJECT, closestObject, intPoint, localNormal, localColor) ? 1 : 0;
+    double closestHitMs = ElapsedMs(startTime);
+
+    int occluded = 0;
+    startTime = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < shadowRays.size(); ++r)
+        occluded += sceneBVH.Occluded(shadowRays[r], RT::BVH::NO_OBJECT, std::numeric_limits<double>::infinity()) ? 1 : 0;
+    double occludedMs = ElapsedMs(startTime);
+
+    double numRays = static_cast<double>(shadowRays.size());
+    double kernelTests = static_cast<double>(kernelRays) * static_cast<double>(numObjects);
+    std::printf("objects: %d, lights: %d, shadow rays: %zu\n", numObjects, numLights, shadowRays.size());
+    std::printf("per-object test, TestIntersection: %.1f ns (%d hits)\n", 1e6 * fullKernelMs / kernelTests, kernelHits);
+    std::printf("per-object test, Occluded:         %.1f ns (%d hits)\n", 1e6 * occludedKernelMs / kernelTests, occludedHits);
+    for (size_t level = 0; level < packetKernelMs.size(); ++level)
+    {
+        const char *levelName = RT::PacketKernels::GetLevelName(static_cast<RT::SimdLevel>(level));
+        std::printf("per-object test, packet %-11s%.1f ns (%d hits)\n", (std::string(levelName) + ":").c_str(), 1e6 * packetKernelMs[level] / kernelTests, packetHits[level]);
+    }
+    std::printf("per shadow ray, BVH closest hit:   %.1f ns (%d blocked)\n", 1e6 * closestHitMs / numRays, blocked);
+    std::printf("per shadow ray, BVH Occluded:      %.1f ns (%d blocked)\n", 1e6 * occludedMs / numRays, occluded);
+    std::printf("speedup: %.2fx per object, %.2fx per ray\n", fullKernelMs / occludedKernelMs, closestHitMs / occludedMs);
+
+    return 0;
+}
+
+// A procedural scene to benchmark
+struct BenchmarkCase
+{
+    std::string m_scene;
+    int m_count = 0;
+    int m_numLights = 3;
+    int m_maxDepth = 3;
+};
+
+// Function to return a palette of materials, from matte to mirror-like
+static std::vector<std::shared_ptr<RT::SimpleMaterial>> MakeMaterials(std::mt19937 &rng)
+{
+    std::uniform_real_distribution<double> channel(0.2, 1.0);
+    std::vector<std::shared_ptr<RT::SimpleMaterial>> materials;
+    for (int i = 0; i < 8; ++i)
+    {
+        auto material = std::make_shared<RT::SimpleMaterial>();
+        material -> m_baseColor = Vector3<double>{channel(rng), channel(rng), channel(rng)};
+        material -> m_reflectivity = 0.1 * i;
+        material -> m_shininess = (i % 2 == 0) ? 10.0 : 0.0;
+        materials.push_back(material);
+    }
+
+    return materials;
+}
+
+// Function to add a transformed object to a scene
+static void AddObject
+(
+    RT::Scene &scene, const std::shared_ptr<RT::ObjectBase> &object, const std::shared_ptr<RT::SimpleMaterial> &material,
+    const Vector3<double> &translation, const Vector3<double> &rotation, const Vector3<double> &scale
+) {
+    RT::GTform transform;
+    transform.SetTransform(translation, rotation, scale);
+    object -> SetTransformMatrix(transform);
+    object -> m_baseColor = material -> m_baseColor;
+    object -> AssignMaterial(material);
+    scene.AddObject(*object);
+}
+
+// Function to place the lights on a circle above a scene of the given size, and aim the camera at it
+static void AddLightsAndCamera(RT::Scene &scene, int numLights, double size, double aspect)
+{
+    const Vector3<double> colors[] = {{1.0, 1.0, 1.0}, {1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}};
+    for (int i = 0; i < numLights; ++i)
+    {
+        double angle = (2.0 * 3.14159265358979 * i) / numLights;
+        auto light = std::make_shared<RT::PointLight>();
+        light -> m_location = Vector3<double>{size * std::cos(angle), size * std::sin(angle) - size, -size};
+        light -> m_color = colors[i % 4];
+        scene.AddLight(light);
+    }
+
+    RT::Camera &camera = scene.GetCamera();
+    camera.SetPosition(Vector3<double>{0.0, -0.7 * size, -0.6 * size});
+    camera.SetLookAt(Vector3<double>{0.0, 0.0, 0.0});
+    camera.SetUp(Vector3<double>{0.0, 0.0, 1.0});
+    camera.SetHorzSize(1.0);
+    camera.SetAspect(aspect);
+    camera.UpdateCameraGeometry();
+}
+
+// Function to build a scene of random spheres resting on a reflective floor
+static void BuildSphereScene(RT::Scene &scene, int numSpheres, int numLights, double aspect)
+{
+    std::mt19937 rng(1234);
+    auto materials = MakeMaterials(rng);
+
+    // Roughly one sphere per unit of floor area
+    double halfSize = 0.5 * std::sqrt(static_cast<double>(std::max(numSpheres, 1)));
+    std::uniform_real_distribution<double> position(-halfSize, halfSize);
+    std::uniform_real_distribution<double> radius(0.1, 0.4);
+    std::uniform_int_distribution<int> material(0, static_cast<int>(materials.size()) - 1);
+
+    scene.ClearScene();
+    AddObject(scene, std::make_shared<RT::ObjPlane>(), materials[5], {0.0, 0.0, 0.75}, {0.0, 0.0, 0.0}, {halfSize + 1.0, halfSize + 1.0, 1.0});
+    for (int i = 0; i < numSpheres; ++i)
+    {
+        double r = radius(rng);
+        AddObject(scene, std::make_shared<RT::ObjSphere>(), materials[material(rng)], {position(rng), position(rng), 0.75 - r}, {0.0, 0.0, 0.0}, {r, r, r});
+    }
+
+    AddLightsAndCamera(scene, numLights, 2.0 * halfSize + 2.0, aspect);
+}
+
+// Function to build a gridSize x gridSize grid of slightly tilted planes, with a few spheres above it
+static void BuildPlaneScene(RT::Scene &scene, int gridSize, int numLights, double aspect)
+{
+    std::mt19937 rng(1234);
+    auto materials = MakeMaterials(rng);
+    std::uniform_real_distribution<double> tilt(-0.2, 0.2);
+
+    double halfSize = 0.5 * gridSize;
+    std::uniform_real_distribution<double> position(-halfSize, halfSize);
+    std::uniform_int_distribution<int> material(0, static_cast<int>(materials.size()) - 1);
+
+    scene.ClearScene();
+    for (int y = 0; y < gridSize; ++y)
+    {
+        for (int x = 0; x < gridSize; ++x)
+        {
+            Vector3<double> centre {x + 0.5 - halfSize, y + 0.5 - halfSize, 0.75};
+            AddObject(scene, std::make_shared<RT::ObjPlane>(), materials[(x + y) % materials.size()], centre, {tilt(rng), tilt(rng), 0.0}, {0.45, 0.45, 1.0});
+        }
+    }
+
+    for (int i = 0; i < gridSize; ++i)
+        AddObject(scene, std::make_shared<RT::ObjSphere>(), materials[material(rng)], {position(rng), position(rng), -0.5}, {0.0, 0.0, 0.0}, {0.5, 0.5, 0.5});
+
+    AddLightsAndCamera(scene, numLights, 2.0 * halfSize + 2.0, aspect);
+}
+
+// Function to make the geometry of a smooth torus of about numTriangles triangles, lying in the xy plane around the origin
+static std::shared_ptr<RT::MeshGeometry> MakeTorus(int numTriangles, double ringRadius, double tubeRadius)
+{
+    // Four times as many segments around the ring as around the tube
+    const double pi = 3.14159265358979;
+    int tubeSegments = std::max(3, static_cast<int>(std::sqrt(std::max(numTriangles, 1) / 8.0)));
+    int ringSegments = 4 * tubeSegments;
+
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<uint32_t> indices;
+    positions.reserve(3 * static_cast<size_t>(ringSegments) * tubeSegments);
+    normals.reserve(positions.capacity());
+    indices.reserve(6 * static_cast<size_t>(ringSegments) * tubeSegments);
+    for (int i = 0; i < ringSegments; ++i)
+    {
+        double ringAngle = (2.0 * pi * i) / ringSegments;
+        for (int j = 0; j < tubeSegments; ++j)
+        {
+            double tubeAngle = (2.0 * pi * j) / tubeSegments;
+            double nx = std::cos(tubeAngle) * std::cos(ringAngle);
+            double ny = std::cos(tubeAngle) * std::sin(ringAngle);
+            double nz = std::sin(tubeAngle);
+            positions.insert(positions.end(), {static_cast<float>((ringRadius * std::cos(ringAngle)) + (tubeRadius * nx)), static_cast<float>((ringRadius * std::sin(ringAngle)) + (tubeRadius * ny)), static_cast<float>(tubeRadius * nz)});
+            normals.insert(normals.end(), {static_cast<float>(nx), static_cast<float>(ny), static_cast<float>(nz)});
+
+            uint32_t v00 = static_cast<uint32_t>((i * tubeSegments) + j);
+            uint32_t v10 = static_cast<uint32_t>((((i + 1) % ringSegments) * tubeSegments) + j);
+            uint32_t v01 = static_cast<uint32_t>((i * tubeSegments) + ((j + 1) % tubeSegments));
+            uint32_t v11 = static_cast<uint32_t>((((i + 1) % ringSegments) * tubeSegments) + ((j + 1) % tubeSegments));
+            indices.insert(indices.end(), {v00, v10, v11, v00, v11, v01});
+        }
+    }
+
+    auto geometry = std::make_shared<RT::MeshGeometry>();
+    geometry -> SetTriangles(std::move(positions), std::move(indices), std::move(normals));
+    return geometry;
+}
+
+// Function to build a scene of a smooth torus mesh of about numTriangles triangles resting on a reflective floor
+static void BuildMeshScene(RT::Scene &scene, int numTriangles, int numLights, double aspect)
+{
+    std::mt19937 rng(1234);
+    auto materials = MakeMaterials(rng);
+
+    const double tubeRadius = 0.7;
+    scene.ClearScene();
+    AddObject(scene, std::make_shared<RT::ObjPlane>(), materials[5], {0.0, 0.0, 0.75}, {0.0, 0.0, 0.0}, {4.0, 4.0, 1.0});
+    AddObject(scene, std::make_shared<RT::ObjMesh>(MakeTorus(numTriangles, 2.0, tubeRadius)), materials[2], {0.0, 0.0, 0.75 - tubeRadius}, {0.0, 0.0, 0.0}, {1.0, 1.0, 1.0});
+
+    AddLightsAndCamera(scene, numLights, 6.0, aspect);
+}
+
+/*
+    Function to build a scene of numInstances randomly turned copies of one 20000 triangle torus,
+    in a grid on a reflective floor. Every copy is an instance of the same geometry, so the memory
+    used by the triangles does not grow with the number of copies
+*/
+static void BuildInstanceScene(RT::Scene &scene, int numInstances, int numLights, double aspect)
+{
+    std::mt19937 rng(1234);
+    auto materials = MakeMaterials(rng);
+    std::uniform_int_distribution<int> material(0, static_cast<int>(materials.size()) - 1);
+    std::uniform_real_distribution<double> angle(0.0, 3.14159);
+
+    int gridSize = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(numInstances)))));
+    double halfSize = 0.5 * gridSize;
+    scene.ClearScene();
+    AddObject(scene, std::make_shared<RT::ObjPlane>(), materials[5], {0.0, 0.0, 0.75}, {0.0, 0.0, 0.0}, {halfSize + 1.0, halfSize + 1.0, 1.0});
+
+    auto torus = MakeTorus(20000, 2.0, 0.7);
+    for (int i = 0; i < numInstances; ++i)
+    {
+        Vector3<double> centre {(i % gridSize) + 0.5 - halfSize, (i / gridSize) + 0.5 - halfSize, 0.4};
+        AddObject(scene, std::make_shared<RT::ObjMesh>(torus), materials[material(rng)], centre, {angle(rng), angle(rng), 0.0}, {0.13, 0.13, 0.13});
+    }
+
+    AddLightsAndCamera(scene, numLights, 2.0 * halfSize + 2.0, aspect);
+}
+
+// Function to return the bytes used by the distinct mesh geometry in a scene. The store keeps shared geometry once
+static size_t GetMeshMemorySize(const RT::Scene &scene)
+{
+    size_t size = 0;
+    for (const auto &geometry : scene.GetObjects().GetMeshes())
+        size += geometry -> GetMemorySize();
+
+    return size;
+}
+
+// Function to test whether a scene name is one that the suite can build
+static bool IsKnownScene(const std::string &sceneName)
+{
+    return (sceneName == "default") || (sceneName == "spheres") || (sceneName == "planes") || (sceneName == "mesh") || (sceneName == "instances");
+}
+
+// Function to run the rendering benchmark suite
+static int RunSuite(int argc, char* argv[])
+{
+    int xSize = 320;
+    int ySize = 180;
+    int numFrames = 3;
+    int maxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    bool wavefront = false;
+    std::string outputFile;
+    BenchmarkCase singleCase;
+    bool hasSingleCase = false;
+
+    for (int i = 2; i < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::fprintf(stderr, "Option '%s' needs a value.\n", option.c_str());
+            return 1;
+        }
+
+        std::string value = argv[i + 1];
+        if (option == "--scene")
+        {
+            singleCase.m_scene = value;
+            hasSingleCase = true;
+        }
+        else if (option == "--count")
+            singleCase.m_count = std::atoi(value.c_str());
+        else if (option == "--lights")
+            singleCase.m_numLights = std::atoi(value.c_str());
+        else if (option == "--depth")
+            singleCase.m_maxDepth = std::atoi(value.c_str());
+        else if (option == "--width")
+            xSize = std::atoi(value.c_str());
+        else if (option == "--height")
+            ySize = std::atoi(value.c_str());
+        else if (option == "--frames")
+            numFrames = std::atoi(value.c_str());
+        else if (option == "--max-threads")
+            maxThreads = std::atoi(value.c_str());
+        else if ((option == "--renderer") && ((value == "recursive") || (value == "wavefront")))
+            wavefront = (value == "wavefront");
+        else if (option == "--output")
+            outputFile = value;
+        else
+        {
+            std::fprintf(stderr, "Unknown option '%s %s'.\n", option.c_str(), value.c_str());
+            return 1;
+        }
+    }
+
+    // Check the scene before anything is written, so that no partial output is left behind
+    if (hasSingleCase && !IsKnownScene(singleCase.m_scene))
+    {
+        std::fprintf(stderr, "Unknown scene '%s'.\n", singleCase.m_scene.c_str());
+        return 1;
+    }
+
+    if ((xSize < 1) || (ySize < 1) || (numFrames < 1) || (maxThreads < 1) || (singleCase.m_numLights < 0) || (singleCase.m_maxDepth < 0))
+    {
+        std::fprintf(stderr, "Invalid options.\n");
+        return 1;
+    }
+
+    // The standard cases vary one parameter at a time from 1000 spheres, 3 lights and depth 3
+    std::vector<BenchmarkCase> cases;
+    if (hasSingleCase)
+    {
+        if (singleCase.m_count < 1)
+            singleCase.m_count = (singleCase.m_scene == "planes") ? 32 : (singleCase.m_scene == "mesh") ? 100000 : 1000;
+        cases.push_back(singleCase);
+    }
+    else
+    {
+        cases =
+        {
+            {"default", 0, 3, 3},
+            {"spheres", 100, 3, 3},
+            {"spheres", 1000, 3, 3},
+            {"spheres", 10000, 3, 3},
+            {"spheres", 1000, 1, 3},
+            {"spheres", 1000, 8, 3},
+            {"spheres", 1000, 3, 0},
+            {"spheres", 1000, 3, 8},
+            {"planes", 32, 3, 3},
+            {"mesh", 100000, 3, 3},
+            {"instances", 1000, 3, 3}
+        };
+    }
+
+    // Thread counts 1, 2, 4, ... up to and including maxThreads
+    std::vector<int> threadCounts;
+    for (int numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+        threadCounts.push_back(numThreads);
+    threadCounts.push_back(maxThreads);
+
+    FILE *output = outputFile.empty() ? stdout : std::fopen(outputFile.c_str(), "w");
+    if (output == nullptr)
+    {
+        std::fprintf(stderr, "Could not open '%s'.\n", outputFile.c_str());
+        return 1;
+    }
+
+    std::fprintf(output, "{\n");
+    std::fprintf(output, "  \"width\": %d,\n  \"height\": %d,\n  \"frames\": %d,\n", xSize, ySize, numFrames);
+    std::fprintf(output, "  \"renderer\": \"%s\",\n", wavefront ? "wavefront" : "recursive");
+    std::fprintf(output, "  \"packet_kernels\": \"%s\",\n", RT::PacketKernels::GetLevelName(RT::PacketKernels::GetLevel()));
+    std::fprintf(output, "  \"hardware_threads\": %u,\n", std::thread::hardware_concurrency());
+    std::fprintf(output, "  \"results\": [\n");
+
+    Image image;
+    image.Initialize(xSize, ySize, NULL);
+    double aspect = static_cast<double>(xSize) / static_cast<double>(ySize);
+    for (size_t c = 0; c < cases.size(); ++c)
+    {
+        const BenchmarkCase &benchCase = cases[c];
+        RT::Scene scene;
+        if (benchCase.m_scene == "spheres")
+            BuildSphereScene(scene, benchCase.m_count, benchCase.m_numLights, aspect);
+        else if (benchCase.m_scene == "planes")
+            BuildPlaneScene(scene, benchCase.m_count, benchCase.m_numLights, aspect);
+        else if (benchCase.m_scene == "mesh")
+            BuildMeshScene(scene, benchCase.m_count, benchCase.m_numLights, aspect);
+        else if (benchCase.m_scene == "instances")
+            BuildInstanceScene(scene, benchCase.m_count, benchCase.m_numLights, aspect);
+        scene.SetMaxReflectionDepth(benchCase.m_maxDepth);
+        scene.SetWavefront(wavefront);
+
+        // Count the rays in a frame, then time the frames without counting
+        scene.SetThreadCount(1);
+        scene.SetStatsEnabled(true);
+        scene.Render(image);
+        RT::RenderStats stats = scene.GetStats();
+        scene.SetStatsEnabled(false);
+        double primaryRays = static_cast<double>(stats.m_totals.m_primaryRays);
+        double totalRays = static_cast<double>(stats.GetTotalRays());
+
+        std::fprintf(output, "    {\n");
+        std::fprintf(output, "      \"scene\": \"%s\",\n", benchCase.m_scene.c_str());
+        std::fprintf(output, "      \"objects\": %zu,\n      \"lights\": %zu,\n      \"max_depth\": %d,\n", static_cast<size_t>(scene.GetObjects().GetSize()), scene.GetLightList().size(), benchCase.m_maxDepth);
+        std::fprintf(output, "      \"mesh_bytes\": %zu,\n", GetMeshMemorySize(scene));
+        std::fprintf(output, "      \"bytes_per_object\": %.1f,\n", static_cast<double>(scene.GetObjectMemorySize()) / std::max<size_t>(1, scene.GetObjects().GetSize()));
+        std::fprintf(output, "      \"primary_rays\": %.0f,\n      \"total_rays\": %.0f,\n      \"stats\": ", primaryRays, totalRays);
+        stats.WriteJson(output);
+        std::fprintf(output, ",\n");
+        std::fprintf(output, "      \"threads\": [\n");
+
+        double singleThreadMs = 0.0;
+        for (size_t t = 0; t < threadCounts.size(); ++t)
+        {
+            // The first frame with each thread count starts the threads, so it is not timed
+            scene.SetThreadCount(threadCounts[t]);
+            scene.Render(image);
+
+            std::vector<double> frameMs;
+            for (int frame = 0; frame < numFrames; ++frame)
+            {
+                auto startTime = std::chrono::steady_clock::now();
+                scene.Render(image);
+                frameMs.push_back(ElapsedMs(startTime));
+            }
+            std::sort(frameMs.begin(), frameMs.end());
+            double medianMs = frameMs[frameMs.size() / 2];
+            if (t == 0)
+                singleThreadMs = medianMs;
+
+            std::fprintf
+            (
+                output,
+                "        {\"threads\": %d, \"frame_ms\": %.3f, \"primary_rays_per_s\": %.0f, \"total_rays_per_s\": %.0f, \"speedup\": %.3f}%s\n",
+                threadCounts[t], medianMs, primaryRays / (medianMs / 1000.0), totalRays / (medianMs / 1000.0),
+                singleThreadMs / medianMs, (t + 1 < threadCounts.size()) ? "," : ""
+            );
+        }
+
+        std::fprintf(output, "      ]\n    }%s\n", (c + 1 < cases.size()) ? "," : "");
+        std::fflush(output);
+    }
+
+    std::fprintf(output, "  ]\n}\n");
+    if (output != stdout)
+        std::fclose(output);
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if ((argc > 1) && (std::string(argv[1]) == "suite"))
+        return RunSuite(argc, argv);
+
+    if ((argc > 1) && (std::string(argv[1]) == "shadow"))
+    {
+        int numObjects = (argc > 2) ? std::atoi(argv[2]) : 10000;
+        int numLights = (argc > 3) ? std::atoi(argv[3]) : 8;
+        return RunShadowBenchmark(numObjects, numLights);
+    }
+
+    int xSize = (argc > 1) ? std::atoi(argv[1]) : 1280;
+    int ySize = (argc > 2) ? std::atoi(argv[2]) : 720;
+
+    // Render off-screen, the image does not need a renderer to store pixels
+    Image image;
+    image.Initialize(xSize, ySize, NULL);
+
+    // Use a single thread so the count only includes work done per ray
+    RT::Scene scene;
+    scene.SetThreadCount(1);
+
+    unsigned long long allocationsBefore = g_allocationCount.load();
+    auto startTime = std::chrono::steady_clock::now();
+    scene.Render(image);
+    auto endTime = std::chrono::steady_clock::now();
+    unsigned long long allocations = g_allocationCount.load() - allocationsBefore;
+
+    double primaryRays = static_cast<double>(xSize) * static_cast<double>(ySize);
+    double frameMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+    std::printf("resolution:               %d x %d\n", xSize, ySize);
+    std::printf("packet kernels:           %s\n", RT::PacketKernels::GetLevelName(RT::PacketKernels::GetLevel()));
+    std::printf("time per frame:           %.2f ms\n", frameMs);
+    std::printf("heap allocations:         %llu\n", allocations);
+    std::printf("allocations / primary ray: %.2f\n", static_cast<double>(allocations) / primaryRays);
+
+    return 0;
+}
@@ -1,7 +1,29 @@
 #include "CApp.h"
+#include "CHeadless.h"
+#include <cstring>
 
 int main(int argc, char* argv[])
 {
+    // Render straight to a file, without opening a window
+    if (CHeadless::IsRequested(argc, argv))
+    {
+        CHeadless Headless;
+        return Headless.OnExecute(argc, argv);
+    }
+
     CApp App;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--stats") == 0)
+            App.SetPrintStats(true);
+        else if ((std::strcmp(argv[i], "--trace") == 0) && (i + 1 < argc))
+            App.SetTraceFile(argv[++i]);
+        else if ((std::strcmp(argv[i], "--scene") == 0) && (i + 1 < argc))
+        {
+            if (!App.LoadScene(argv[++i]))
+                return 1;
+        }
+    }
+
     return App.OnExecute();
 }
\ No newline at end of file